@@ -207,7 +207,7 @@ void cw::init()
 		set_freq(progdefaults.CWsweetspot);
 	else if (progStatus.carrier != 0) {
 		set_freq(progStatus.carrier);
-#if !BENCHMARK_MODE
+#if !DECODER_MODE
 		progStatus.carrier = 0;
 #endif
 	} else
@@ -237,15 +237,19 @@ cw::cw() : modem()
 	cap |= CAP_BW;
 
 	mode = MODE_CW;
-	freqlock = false;
+	if (!extra)
+		freqlock = false;
 	usedefaultWPM = false;
 	frequency = progdefaults.CWsweetspot;
-	tx_frequency = get_txfreq_woffset();
+	if (!extra)
+		tx_frequency = get_txfreq_woffset();
 	risetime = progdefaults.CWrisetime;
 	QSKshape = progdefaults.QSKshape;
 
 	cw_ptr = 0;
 	clrcount = CLRCOUNT;
+	space_sent = true;
+	last_element = 0;
 
 	samplerate = CWSampleRate;
 	fragmentsize = CWMaxSymLen;
@@ -271,8 +275,8 @@ cw::cw() : modem()
 
 	cwTrack = true;
 	phaseacc = 0.0;
-	FFTphase = 0.0;
-	FIRphase = 0.0;
+	FFTosc.reset();
+	FIRosc.reset();
 	FFTvalue = 0.0;
 	FIRvalue = 0.0;
 	pipeptr = 0;
@@ -335,10 +339,10 @@ void cw::reset_rx_filter()
 
 		if (use_fft_filter) { // FFT filter
 			cw_FFT_filter->create_lpf(progdefaults.CWspeed/(1.2 * samplerate));
-			FFTphase = 0;
+			FFTosc.reset();
 		} else { // FIR filter
 			cw_FIR_filter->init_lowpass (CW_FIRLEN, DEC_RATIO, progdefaults.CWspeed/(1.2 * samplerate));
-			FIRphase = 0;
+			FIRosc.reset();
 		}
 		REQ(static_cast<void (waterfall::*)(int)>(&waterfall::Bandwidth),
 			wf, (int)bandwidth);
@@ -357,8 +361,8 @@ void cw::reset_rx_filter()
 		fsymlen = (int)(samplerate * 1.2 / progdefaults.CWfarnsworth);
 
 		phaseacc = 0.0;
-		FFTphase = 0.0;
-		FIRphase = 0.0;
+		FFTosc.reset();
+		FIRosc.reset();
 		FFTvalue = 0.0;
 		FIRvalue = 0.0;
 		pipeptr = 0;
@@ -518,20 +522,6 @@ void cw::clear_syncscope()
 	clrcount = CLRCOUNT;
 }
 
-cmplx cw::mixer(cmplx in)
-{
-	cmplx z (cos(phaseacc), sin(phaseacc));
-	z = z * in;
-
-	phaseacc += TWOPI * frequency / samplerate;
-	if (phaseacc > M_PI)
-		phaseacc -= TWOPI;
-	else if (phaseacc < M_PI)
-		phaseacc += TWOPI;
-
-	return z;
-}
-
 //=====================================================================
 // cw_rxprocess()
 // Called with a block (size SCBLOCKSIZE samples) of audio.
@@ -599,21 +589,16 @@ void cw::decode_stream(double value)
 
 void cw::rx_FFTprocess(const double *buf, int len)
 {
-	cmplx z, *zp;
+	cmplx *zp;
 	int n;
 
-	while (len-- > 0) {
+	rxmix.resize(len);
+	FFTosc.set_freq(frequency, samplerate);
+	FFTosc.mix(&rxmix[0], buf, len);
 
-		z = cmplx ( *buf * cos(FFTphase), *buf * sin(FFTphase) );
-		FFTphase += TWOPI * frequency / samplerate;
-		if (FFTphase > M_PI)
-			FFTphase -= TWOPI;
-		else if (FFTphase < M_PI)
-			FFTphase += TWOPI;
+	for (int j = 0; j < len; j++) {
 
-		buf++;
-
-		n = cw_FFT_filter->run(z, &zp); // n = 0 or filterlen/2
+		n = cw_FFT_filter->run(rxmix[j], &zp); // n = 0 or filterlen/2
 
 		if (!n) continue;
 
@@ -636,28 +621,20 @@ void cw::rx_FFTprocess(const double *buf, int len)
 
 void cw::rx_FIRprocess(const double *buf, int len)
 {
-	cmplx z;
-
-	while (len-- > 0) {
-		z = cmplx ( *buf * cos(FIRphase), *buf * sin(FIRphase) );
-		buf++;
-
-		FIRphase += TWOPI * frequency / samplerate;
-		if (FIRphase > M_PI)
-			FIRphase -= TWOPI;
-		else if (FIRphase < M_PI)
-			FIRphase += TWOPI;
-
-		if (cw_FIR_filter->run ( z, z )) {
+	rxmix.resize(len);
+	FIRosc.set_freq(frequency, samplerate);
+	FIRosc.mix(&rxmix[0], buf, len);
+// filter & decimate in place
+	int n = cw_FIR_filter->run(&rxmix[0], &rxmix[0], len);
 
+	for (int j = 0; j < n; j++) {
 // update the basic sample counter used for morse timing
-			smpl_ctr += DEC_RATIO;
+		smpl_ctr += DEC_RATIO;
 // demodulate
-			FIRvalue = abs(z);
-			FIRvalue = bitfilter->run(FIRvalue);
+		FIRvalue = abs(rxmix[j]);
+		FIRvalue = bitfilter->run(FIRvalue);
 
-			decode_stream(FIRvalue);
-		}
+		decode_stream(FIRvalue);
 	}
 }
 
@@ -711,8 +688,6 @@ int cw::usec_diff(unsigned int earlier, unsigned int later)
 
 int cw::handle_event(int cw_event, const char **c)
 {
-	static int space_sent = true;	// for word space logic
-	static int last_element = 0;	// length of last dot/dash
 	int element_usec;		// Time difference in usecs
 
 	switch (cw_event) {
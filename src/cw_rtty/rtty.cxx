@@ -47,10 +47,13 @@ using namespace std;
 #include "synop.h"
 #include "main.h"
 
-#include "dl_fldigi/hbtint.h"
+#include "dl_fldigi/extractor.h"
 
 #define FILTER_DEBUG 0
 
+// length of the mark and space fftfilt's
+static const int filter_length = 1024;
+
 view_rtty *rttyviewer = (view_rtty *)0;
 
 //=====================================================================
@@ -121,8 +124,8 @@ void rtty::rx_init()
 
 	lost = 0;
 
-	mark_phase = 0;
-	space_phase = 0;
+	mark_osc.reset();
+	space_osc.reset();
 	xy_phase = 0.0;
 
 	mark_mag = 0;
@@ -134,6 +137,7 @@ void rtty::rx_init()
 
 	lastchar = 0;
 
+#if !DECODER_MODE
 	// Synop file is reloaded each time we enter this modem. Ideally do that when the file is changed.
 	static bool wmo_loaded = false ;
 	if( wmo_loaded == false ) {
@@ -143,25 +147,30 @@ void rtty::rx_init()
 	/// Used by weather reports decoding.
 	synop::setup<rtty_callback>();
 	synop::instance()->init();
+#endif
 }
 
 void rtty::init()
 {
+#if !DECODER_MODE
 	bool wfrev = wf->Reverse();
 	bool wfsb = wf->USB();
 	// Probably not necessary because similar to modem::set_reverse
 	reverse = wfrev ^ !wfsb;
+#endif
 	stopflag = false;
 
 	if (progdefaults.StartAtSweetSpot)
 		set_freq(progdefaults.RTTYsweetspot);
 	else if (progStatus.carrier != 0) {
 		set_freq(progStatus.carrier);
-#if !BENCHMARK_MODE
+#if !DECODER_MODE
 		progStatus.carrier = 0;
-#endif
 	} else
 		set_freq(wf->Carrier());
+#else
+	}
+#endif
 
 	rx_init();
 	put_MODEstatus(mode);
@@ -189,12 +198,16 @@ rtty::~rtty()
 	delete m_Osc2;
 	delete m_SymShaper1;
 	delete m_SymShaper2;
+#if !DECODER_MODE
+	if (::rttyviewer == rttyviewer)
+		::rttyviewer = 0;
+	delete rttyviewer;
+#endif
 }
 
 void rtty::reset_filters()
 {
     printf("reseting Filter for Baud %f, %f\n", rtty_baud, samplerate);  // print dot length
-	int filter_length = 1024;
 
     
         if (mark_filt) {
@@ -216,9 +229,10 @@ void rtty::restart()
 {
 	double stl;
 
-	rtty_shift = shift = (progdefaults.rtty_shift >= 0 ?
+	rtty_shift = shift = (settings.rtty_shift > 0 ? settings.rtty_shift :
+			      progdefaults.rtty_shift >= 0 ?
 				  SHIFT[progdefaults.rtty_shift] : progdefaults.rtty_custom_shift);
-	rtty_baud = BAUD[progdefaults.rtty_baud];
+	rtty_baud = settings.rtty_baud > 0 ? settings.rtty_baud : BAUD[progdefaults.rtty_baud];
 	nbits = rtty_bits = BITS[progdefaults.rtty_bits];
 	if (rtty_bits == 5)
 		rtty_parity = RTTY_PARITY_NONE;
@@ -231,7 +245,7 @@ void rtty::restart()
 			case 4 : rtty_parity = RTTY_PARITY_ONE; break;
 			default : rtty_parity = RTTY_PARITY_NONE; break;
 		}
-	rtty_stop = progdefaults.rtty_stop;
+	rtty_stop = settings.rtty_stop >= 0 ? settings.rtty_stop : progdefaults.rtty_stop;
 
 	txmode = LETTERS;
 	rxmode = LETTERS;
@@ -243,7 +257,10 @@ void rtty::restart()
 
     //rtty_BW = progdefaults.RTTY_BW = rtty_baud * 2;
 
-	wf->redraw_marker();
+#if !DECODER_MODE
+	if (!extra)
+		wf->redraw_marker();
+#endif
 
 	reset_filters();
 
@@ -255,11 +272,12 @@ void rtty::restart()
 	bit = nubit = true;
 
 // stop length = 1, 1.5 or 2 bits
-	rtty_stop = progdefaults.rtty_stop;
 	if (rtty_stop == 0) stl = 1.0;
 	else if (rtty_stop == 1) stl = 1.5;
 	else stl = 2.0;
 	stoplen = (int) (stl * samplerate / rtty_baud + 0.5);
+	showxy = symbollen;
+	bitcount = 5 * nbits * symbollen;
 	freqerr = 0.0;
 	pipeptr = 0;
 
@@ -270,12 +288,14 @@ void rtty::restart()
 
 	metric = 0.0;
 
-	if ((rtty_baud - (int)rtty_baud) == 0)
-		snprintf(msg1, sizeof(msg1), "%-3.0f/%-4.0f", rtty_baud, rtty_shift);
-	else
-		snprintf(msg1, sizeof(msg1), "%-4.2f/%-4.0f", rtty_baud, rtty_shift);
-	put_Status1(msg1);
-	put_MODEstatus(mode);
+	if (!extra) {
+		if ((rtty_baud - (int)rtty_baud) == 0)
+			snprintf(msg1, sizeof(msg1), "%-3.0f/%-4.0f", rtty_baud, rtty_shift);
+		else
+			snprintf(msg1, sizeof(msg1), "%-4.2f/%-4.0f", rtty_baud, rtty_shift);
+		put_Status1(msg1);
+		put_MODEstatus(mode);
+	}
 	for (int i = 0; i < MAXPIPE; i++) QI[i].real() = QI[i].imag() = 0.0;
 	sigpwr = 0.0;
 	noisepwr = 0.0;
@@ -288,8 +308,8 @@ void rtty::restart()
 	m_SymShaper1->Preset(rtty_baud, samplerate);
 	m_SymShaper2->Preset(rtty_baud, samplerate);
 
-	mark_phase = 0;
-	space_phase = 0;
+	mark_osc.reset();
+	space_osc.reset();
 	xy_phase = 0.0;
 
 	mark_mag = 0;
@@ -301,8 +321,12 @@ void rtty::restart()
 
 	for (int i = 0; i < MAXPIPE; i++) mark_history[i] = space_history[i] = cmplx(0,0);
 
-	rttyviewer->restart();
-	progStatus.rtty_filter_changed = false;
+#if !DECODER_MODE
+	if (rttyviewer && !extra)
+		rttyviewer->restart();
+#endif
+	if (!extra)
+		progStatus.rtty_filter_changed = false;
 
 }
 
@@ -322,7 +346,13 @@ rtty::rtty(trx_mode tty_mode)
 	pipe = new double[MAXPIPE];
 	dsppipe = new double [MAXPIPE];
 
-	::rttyviewer = new view_rtty(mode);
+	// only the active modem feeds the signal browser; the decoder has none
+#if !DECODER_MODE
+	if (!extra)
+		::rttyviewer = rttyviewer = new view_rtty(mode);
+	else
+#endif
+		rttyviewer = 0;
 
 	m_Osc1 = new Oscillator( samplerate );
 	m_Osc2 = new Oscillator( samplerate );
@@ -350,14 +380,10 @@ void rtty::Clear_syncscope()
 	set_scope(0, 0, false);
 }
 
-cmplx rtty::mixer(double &phase, double f, cmplx in)
+cmplx rtty::mixer(C_NCO &osc, double f, cmplx in)
 {
-	cmplx z = cmplx( cos(phase), sin(phase)) * in;
-
-	phase -= TWOPI * f / samplerate;
-	if (phase < -TWOPI) phase += TWOPI;
-
-	return z;
+	osc.set_step(-TWOPI * f / samplerate);
+	return osc.mix(in);
 }
 
 unsigned char rtty::Bit_reverse(unsigned char in, int n)
@@ -485,6 +511,7 @@ bool rtty::rx(bool bit) // original modified for probability test
 				if ((metric >= progStatus.sldrSquelchValue && progStatus.sqlonoff) || !progStatus.sqlonoff) {
 					c = decode_char();
 
+#if !DECODER_MODE
 					if( progdefaults.SynopAdifDecoding || progdefaults.SynopKmlDecoding ) {
 						if (c != 0 && c != '\r')  {
 							synop::instance()->add(c);
@@ -493,7 +520,9 @@ bool rtty::rx(bool bit) // original modified for probability test
 								synop::instance()->flush(false);
 							put_rx_char(c);
 						}
-					} else if ( c != 0 ) {
+					} else
+#endif
+					if ( c != 0 ) {
 // supress <CR><CR> and <LF><LF> sequences
 // these were observed during the RTTY contest 2/9/2013
 						if (c == '\r' && lastchar == '\r');
@@ -512,12 +541,9 @@ bool rtty::rx(bool bit) // original modified for probability test
 					if(nbits == 8) put_rx_ssdv(c, lb);
 
 					if (lb != 0)
-						dl_fldigi::hbtint::extrmgr->skipped(lb);
+						dl_fldigi::extractor::skipped(lb);
 
-					if (nbits == 5)
-						dl_fldigi::hbtint::extrmgr->push(c, habitat::PUSH_BAUDOT_HACK);
-					else
-						dl_fldigi::hbtint::extrmgr->push(c);
+					dl_fldigi::extractor::put(c, nbits == 5);
 				}
 				lost = 0;
 			}
@@ -530,6 +556,7 @@ bool rtty::rx(bool bit) // original modified for probability test
 	return flag;
 }
 
+#if !DECODER_MODE
 char snrmsg[80];
 void rtty::Metric()
 {
@@ -587,6 +614,13 @@ void rtty::searchUp()
 		srchfreq += 5.0;
 	}
 }
+#else
+// The signal is measured and searched for on the waterfall, which the
+// decoder does not have
+void rtty::Metric() { }
+void rtty::searchDown() { }
+void rtty::searchUp() { }
+#endif
 
 #if FILTER_DEBUG == 1
 int snum = 0;
@@ -605,18 +639,18 @@ int rtty::rx_process(const double *buf, int len)
 {
 	const double *buffer = buf;
 	int length = len;
-	static int showxy = symbollen;
 
-	cmplx z, zmark, zspace, *zp_mark, *zp_space;
+	cmplx *zp_mark, *zp_space;
 
 	int n_out = 0;
-	static int bitcount = 5 * nbits * symbollen;
 
+#if !DECODER_MODE
 	if ( !progdefaults.report_when_visible ||
 		 dlgViewer->visible() || progStatus.show_channels )
 		if (!bHistory && rttyviewer) rttyviewer->rx_process(buf, len);
+#endif
 
-	if (progStatus.rtty_filter_changed) {
+	if (progStatus.rtty_filter_changed && !extra) {
 		progStatus.rtty_filter_changed = false;
 		reset_filters();
 	}
@@ -624,81 +658,78 @@ int rtty::rx_process(const double *buf, int len)
 	Metric();
 #if FILTER_DEBUG == 1
 double value;
-#endif
-	while (length-- > 0) {
-
-// Create analytic signal from sound card input samples
-
-#if FILTER_DEBUG == 1
-if (snum < 2 * filter_length) {
+std::vector<double> ookbuf(buf, buf + len);
+for (int i = 0; i < len && snum < 2 * filter_length; i++, snum++) {
 	frequency = 1000.0;
 	ook(snum);
-//	z.real() = z.imag() = (snum/symbollen % 2 == 0) ? 1.0 : 0.0;
-	z = complex(value, value);
-	ook_signal << snum << "," << z.real() << ",";
-//	snum++;
-} else {
-	z = cmplx(*buffer, *buffer);
+	ookbuf[i] = value;
+	ook_signal << snum << "," << value << "\n";
 }
-#else
-	z = cmplx(*buffer, *buffer);
+buffer = &ookbuf[0];
 #endif
-	buffer++;
 
-// Mix it with the audio carrier frequency to create two baseband signals
-// mark and space are separated and processed independently
-// lowpass Windowed Sinc - Overlap-Add convolution filters.
+// The mark and space filters take the real sound card samples directly.
+// Their lowpass responses are shifted up to the FFT bins nearest the mark and
+// space tones, so each sees only the positive frequency half of its tone, and
+// the outputs are then mixed down to baseband.  The residual offset of up to
+// half a bin moves the filter a few Hz off the tone, which the raised cosine
+// response hardly notices.
 // The two fftfilt's are the same size and processed in sync
 // therefore the mark and space filters will concurrently have the
 // same size outputs available for further processing
 
-		zmark = mixer(mark_phase, frequency + shift/2.0, z);
-		mark_filt->run(zmark, &zp_mark);
-
-		zspace = mixer(space_phase, frequency - shift/2.0, z);
-		n_out = space_filt->run(zspace, &zp_space);
-#if FILTER_DEBUG == 1
-if (snum < 2 * filter_length) {
-	ook_signal << abs(zmark) <<"\n";
-	snum++;
-}
-#endif
-		for (int i = 0; i < n_out; i++) {
-
-			mark_mag = abs(zp_mark[i]);
-			mark_env = decayavg (mark_env, mark_mag,
-						(mark_mag > mark_env) ? symbollen / 4 : symbollen * 16);
-			mark_noise = decayavg (mark_noise, mark_mag,
-						(mark_mag < mark_noise) ? symbollen / 4 : symbollen * 48);
-			space_mag = abs(zp_space[i]);
-			space_env = decayavg (space_env, space_mag,
-						(space_mag > space_env) ? symbollen / 4 : symbollen * 16);
-			space_noise = decayavg (space_noise, space_mag,
-						(space_mag < space_noise) ? symbollen / 4 : symbollen * 48);
+	if (mark_buf.size() < (size_t)(length + filter_length / 2)) {
+		mark_buf.resize(length + filter_length / 2);
+		space_buf.resize(length + filter_length / 2);
+	}
+	zp_mark = &mark_buf[0];
+	zp_space = &space_buf[0];
+
+	mark_filt->shift((frequency + shift/2.0) / samplerate);
+	mark_filt->run(buffer, length, zp_mark);
+
+	space_filt->shift((frequency - shift/2.0) / samplerate);
+	n_out = space_filt->run(buffer, length, zp_space);
+
+	for (int i = 0; i < n_out; i++) {
+
+		zp_mark[i] = mixer(mark_osc, frequency + shift/2.0, zp_mark[i]);
+		zp_space[i] = mixer(space_osc, frequency - shift/2.0, zp_space[i]);
+
+		mark_mag = abs(zp_mark[i]);
+		mark_env = decayavg (mark_env, mark_mag,
+					(mark_mag > mark_env) ? symbollen / 4 : symbollen * 16);
+		mark_noise = decayavg (mark_noise, mark_mag,
+					(mark_mag < mark_noise) ? symbollen / 4 : symbollen * 48);
+		space_mag = abs(zp_space[i]);
+		space_env = decayavg (space_env, space_mag,
+					(space_mag > space_env) ? symbollen / 4 : symbollen * 16);
+		space_noise = decayavg (space_noise, space_mag,
+					(space_mag < space_noise) ? symbollen / 4 : symbollen * 48);
 #if FILTER_DEBUG == 1
 if (mnum < 2 * filter_length)
 	ook_signal << ",,," << mnum++ + filter_length / 2 << "," << mark_mag << "," << space_mag << "\n";
 #endif
-			noise_floor = min(space_noise, mark_noise);
+		noise_floor = min(space_noise, mark_noise);
 
 // clipped if clipped decoder selected
-			double mclipped = 0, sclipped = 0;
-			mclipped = mark_mag > mark_env ? mark_env : mark_mag;
-			sclipped = space_mag > space_env ? space_env : space_mag;
-			if (mclipped < noise_floor) mclipped = noise_floor;
-			if (sclipped < noise_floor) sclipped = noise_floor;
-
-			switch (progdefaults.rtty_cwi) {
-				case 1 : // mark only decode
-					space_env = sclipped = noise_floor;
-					break;
-				case 2: // space only decode
-					mark_env = mclipped = noise_floor;
-				default : ;
-			}
+		double mclipped = 0, sclipped = 0;
+		mclipped = mark_mag > mark_env ? mark_env : mark_mag;
+		sclipped = space_mag > space_env ? space_env : space_mag;
+		if (mclipped < noise_floor) mclipped = noise_floor;
+		if (sclipped < noise_floor) sclipped = noise_floor;
+
+		switch (progdefaults.rtty_cwi) {
+			case 1 : // mark only decode
+				space_env = sclipped = noise_floor;
+				break;
+			case 2: // space only decode
+				mark_env = mclipped = noise_floor;
+			default : ;
+		}
 
 //			double v0, v1, v2, v3, v4, v5;
-			double v3;
+		double v3;
 // no ATC
 //			v0 = mark_mag - space_mag;
 // Linear ATC
@@ -707,10 +738,10 @@ if (mnum < 2 * filter_length)
 //			v2  = (mclipped - noise_floor) - (sclipped - noise_floor) - 0.5 * (
 //					(mark_env - noise_floor) - (space_env - noise_floor));
 // Optimal ATC
-			v3  = (mclipped - noise_floor) * (mark_env - noise_floor) -
-					(sclipped - noise_floor) * (space_env - noise_floor) - 0.25 * (
-					(mark_env - noise_floor) * (mark_env - noise_floor) -
-					(space_env - noise_floor) * (space_env - noise_floor));
+		v3  = (mclipped - noise_floor) * (mark_env - noise_floor) -
+				(sclipped - noise_floor) * (space_env - noise_floor) - 0.25 * (
+				(mark_env - noise_floor) * (mark_env - noise_floor) -
+				(space_env - noise_floor) * (space_env - noise_floor));
 // Kahn Squarer with Linear ATC
 //			v4 =  (mark_mag - noise_floor) * (mark_mag - noise_floor) -
 //					(space_mag - noise_floor) * (space_mag - noise_floor) - 0.25 * (
@@ -731,7 +762,7 @@ if (mnum < 2 * filter_length)
 //				bit = v2 > 0;
 //				break;
 //			case 2: // optimal ATC
-				bit = v3 > 0;
+			bit = v3 > 0;
 //				break;
 //			case 3: // Kahn linear ATC
 //				bit = v4 > 0;
@@ -746,107 +777,106 @@ if (mnum < 2 * filter_length)
 
 // XY scope signal generation
 
-			if (progdefaults.true_scope) {
+		if (progdefaults.true_scope) {
 //----------------------------------------------------------------------
 // "true" scope implementation------------------------------------------
 //----------------------------------------------------------------------
 
 // get the baseband-signal and...
-				xy.real() = zp_mark[i].real() * cos(xy_phase) + zp_mark[i].imag() * sin(xy_phase);
-				xy.imag() = zp_space[i].real() * cos(xy_phase) + zp_space[i].imag() * sin(xy_phase);
+			xy.real() = zp_mark[i].real() * cos(xy_phase) + zp_mark[i].imag() * sin(xy_phase);
+			xy.imag() = zp_space[i].real() * cos(xy_phase) + zp_space[i].imag() * sin(xy_phase);
 
 // if mark-tone has a higher magnitude than the space-tone,
 // further reduce the scope's space-amplitude and vice versa
 // this makes the scope looking a little bit nicer, too...
 // aka: less noisy...
-				if( abs(zp_mark[i]) > abs(zp_space[i]) ) {
-					xy.imag() *= abs(zp_space[i])/abs(zp_mark[i]);
-				} else {
-					xy.real() /= abs(zp_space[i])/abs(zp_mark[i]);
-				}
+			if( abs(zp_mark[i]) > abs(zp_space[i]) ) {
+				xy.imag() *= abs(zp_space[i])/abs(zp_mark[i]);
+			} else {
+				xy.real() /= abs(zp_space[i])/abs(zp_mark[i]);
+			}
 
 // now normalize the scope
-				double const norm = 1.3*(abs(zp_mark [i]) + abs(zp_space[i]));
-				xy /= norm;
+			double const norm = 1.3*(abs(zp_mark [i]) + abs(zp_space[i]));
+			xy /= norm;
 
-			} else {
+		} else {
 //----------------------------------------------------------------------
 // "ortho" scope implementation-----------------------------------------
 //----------------------------------------------------------------------
 // get magnitude of the baseband-signal
-				if (bit)
-					xy = cmplx( mark_mag * cos(xy_phase), space_noise * sin(xy_phase) / 2.0);
-				else
-					xy = cmplx( mark_noise * cos(xy_phase) / 2.0, space_mag * sin(xy_phase));
+			if (bit)
+				xy = cmplx( mark_mag * cos(xy_phase), space_noise * sin(xy_phase) / 2.0);
+			else
+				xy = cmplx( mark_noise * cos(xy_phase) / 2.0, space_mag * sin(xy_phase));
 // now normalize the scope
-				double const norm = (mark_env + space_env);
-				xy /= norm;
-			}
+			double const norm = (mark_env + space_env);
+			xy /= norm;
+		}
 
 // Rotate the scope x-y iaw frequency error.  Old scopes were not capable
 // of this, but it should be very handy, so... who cares of realism anyways?
-			double const rotate = 8 * TWOPI * freqerr / rtty_shift;
-			xy = xy * cmplx(cos(rotate), sin(rotate));
+		double const rotate = 8 * TWOPI * freqerr / rtty_shift;
+		xy = xy * cmplx(cos(rotate), sin(rotate));
 
-			QI[inp_ptr] = xy;
+		QI[inp_ptr] = xy;
 
 // shift it to 128Hz(!) and not to it's original position.
 // this makes it more pretty and does not remove it's other
 // qualities. Reason is that this is a fraction of the used
 // block-size.
-			xy_phase += (TWOPI * (128.0 / samplerate));
+		xy_phase += (TWOPI * (128.0 / samplerate));
 // end XY signal generation
 
-			mark_history[inp_ptr] = zp_mark[i];
-			space_history[inp_ptr] = zp_space[i];
+		mark_history[inp_ptr] = zp_mark[i];
+		space_history[inp_ptr] = zp_space[i];
 
-			inp_ptr = (inp_ptr + 1) % MAXPIPE;
+		inp_ptr = (inp_ptr + 1) % MAXPIPE;
 
-			if (dspcnt && (--dspcnt % (nbits + 2) == 0)) {
-				pipe[pipeptr] = bit - 0.5; //testbit - 0.5;
-				pipeptr = (pipeptr + 1) % symbollen;
-			}
+		if (dspcnt && (--dspcnt % (nbits + 2) == 0)) {
+			pipe[pipeptr] = bit - 0.5; //testbit - 0.5;
+			pipeptr = (pipeptr + 1) % symbollen;
+		}
 
 // detect TTY signal transitions
 // rx(...) returns true if valid TTY bit stream detected
 // either character or idle signal
-			if ( rx( reverse ? !bit : bit ) ) {
-				dspcnt = symbollen * (nbits + 2);
-				if (!bHighSpeed) Update_syncscope();
-				clear_zdata = true;
-				bitcount = 5 * nbits * symbollen;
-				if (sigsearch) sigsearch--;
-					int mp0 = inp_ptr - 2;
-				int mp1 = mp0 + 1;
-				if (mp0 < 0) mp0 += MAXPIPE;
-				if (mp1 < 0) mp1 += MAXPIPE;
-				double ferr = (TWOPI * samplerate / rtty_baud) *
-						(!reverse ?
-							arg(conj(mark_history[mp1]) * mark_history[mp0]) :
-							arg(conj(space_history[mp1]) * space_history[mp0]));
-				if (fabs(ferr) > rtty_baud / 2) ferr = 0;
-				freqerr = decayavg ( freqerr, ferr / 8,
-					progdefaults.rtty_afcspeed == 0 ? 8 :
-					progdefaults.rtty_afcspeed == 1 ? 4 : 1 );
-				if (progStatus.afconoff &&
-					(metric > progStatus.sldrSquelchValue || !progStatus.sqlonoff))
-					set_freq(frequency - freqerr);
-			} else
-				if (bitcount) --bitcount;
-		}
-		if (!bHighSpeed) {
-			if (!bitcount) {
-				if (clear_zdata) {
-					clear_zdata = false;
-					Clear_syncscope();
-					for (int i = 0; i < MAXPIPE; i++) QI[i].real() = QI[i].imag() = 0.0;
-				}
-			}
-			if (!--showxy) {
-				set_zdata(QI, MAXPIPE);
-				showxy = symbollen;
+		if ( rx( reverse ? !bit : bit ) ) {
+			dspcnt = symbollen * (nbits + 2);
+			if (!bHighSpeed) Update_syncscope();
+			clear_zdata = true;
+			bitcount = 5 * nbits * symbollen;
+			if (sigsearch) sigsearch--;
+				int mp0 = inp_ptr - 2;
+			int mp1 = mp0 + 1;
+			if (mp0 < 0) mp0 += MAXPIPE;
+			if (mp1 < 0) mp1 += MAXPIPE;
+			double ferr = (TWOPI * samplerate / rtty_baud) *
+					(!reverse ?
+						arg(conj(mark_history[mp1]) * mark_history[mp0]) :
+						arg(conj(space_history[mp1]) * space_history[mp0]));
+			if (fabs(ferr) > rtty_baud / 2) ferr = 0;
+			freqerr = decayavg ( freqerr, ferr / 8,
+				progdefaults.rtty_afcspeed == 0 ? 8 :
+				progdefaults.rtty_afcspeed == 1 ? 4 : 1 );
+			if (progStatus.afconoff &&
+				(metric > progStatus.sldrSquelchValue || !progStatus.sqlonoff))
+				set_freq(frequency - freqerr);
+		} else
+			if (bitcount) --bitcount;
+	}
+	if (!bHighSpeed) {
+		if (!bitcount) {
+			if (clear_zdata) {
+				clear_zdata = false;
+				Clear_syncscope();
+				for (int i = 0; i < MAXPIPE; i++) QI[i].real() = QI[i].imag() = 0.0;
 			}
 		}
+		if ((showxy -= length) <= 0) {
+			set_zdata(QI, MAXPIPE);
+			showxy = symbollen;
+		}
 	}
 	return 0;
 }
@@ -38,6 +38,16 @@ using namespace std;
 #include "Viewer.h"
 #include "qrunner.h"
 
+// The mark and space tones of every channel are taken from one polyphase
+// filter bank, decimated to no fewer than 16 samples per bit, instead of each
+// channel mixing and filtering the full rate input twice.  The raised cosine
+// filters and the decoder state machines run at the decimated rate.
+//
+// At 300 baud and above there is no decimation, and the filter bank would
+// only add to the cost.  The raised cosine filters then take the real input
+// directly, shifted up to the mark and space tones as in the rtty modem, and
+// share one forward FFT of it between all of the channels.
+
 //=====================================================================
 // Baudot support
 //=====================================================================
@@ -72,8 +82,8 @@ void view_rtty::rx_init()
 		channel[ch].frequency = NULLFREQ;
 		channel[ch].poserr = channel[ch].negerr = 0.0;
 
-		channel[ch].mark_phase = 0;
-		channel[ch].space_phase = 0;
+		channel[ch].mark_osc.reset();
+		channel[ch].space_osc.reset();
 		channel[ch].mark_mag = 0;
 		channel[ch].space_mag = 0;
 		channel[ch].mark_env = 0;
@@ -101,24 +111,25 @@ view_rtty::~view_rtty()
 		if (channel[ch].mark_filt) delete channel[ch].mark_filt;
 		if (channel[ch].space_filt) delete channel[ch].space_filt;
 	}
+	delete chan;
+	delete input;
 }
 
 void view_rtty::reset_filters(int ch)
 {
-	int filter_length = 1024;
-	if (channel[ch].mark_filt) {
-		channel[ch].mark_filt->rtty_filter(rtty_baud/samplerate);
-	} else {
-		channel[ch].mark_filt = new fftfilt(rtty_baud/samplerate, filter_length);
-		channel[ch].mark_filt->rtty_filter(rtty_baud/samplerate);
-	}
-
-	if (channel[ch].space_filt) {
-		channel[ch].space_filt->rtty_filter(rtty_baud/samplerate);
-	} else {
-		channel[ch].space_filt = new fftfilt(rtty_baud/samplerate, filter_length);
-		channel[ch].space_filt->rtty_filter(rtty_baud/samplerate);
-	}
+// the filters run at the decimated rate, and keep the same block period
+	int filter_length = 1024 / decimate;
+	double f = rtty_baud * decimate / samplerate;
+
+	if (channel[ch].mark_filt)
+		delete channel[ch].mark_filt;
+	channel[ch].mark_filt = new fftfilt(f, filter_length);
+	channel[ch].mark_filt->rtty_filter(f);
+
+	if (channel[ch].space_filt)
+		delete channel[ch].space_filt;
+	channel[ch].space_filt = new fftfilt(f, filter_length);
+	channel[ch].space_filt->rtty_filter(f);
 }
 
 void view_rtty::restart()
@@ -143,7 +154,12 @@ void view_rtty::restart()
 	rtty_stop = progdefaults.rtty_stop;
 
 
-	symbollen = (int) (samplerate / rtty_baud + 0.5);
+// decimate as far as leaves at least 16 samples per bit
+	decimate = 1;
+	while (decimate < 16 && samplerate / (2 * decimate * rtty_baud) >= 16)
+		decimate *= 2;
+
+	symbollen = (int) (samplerate / decimate / rtty_baud + 0.5);
 	bflen = symbollen/3;
 
 	set_bandwidth(shift);
@@ -154,6 +170,19 @@ void view_rtty::restart()
 	if (bp_filt_lo < 0) bp_filt_lo = 0;
 	bp_filt_hi = (shift/2.0 + rtty_BW/2.0) / samplerate;
 
+// The prototype passes a tone up to half a bin away from the bin centre,
+// and its transition band ends below the decimated Nyquist frequency.
+	delete chan;
+	delete input;
+	chan = 0;
+	input = 0;
+	if (decimate > 1)
+		chan = new channelizer(VIEW_RTTY_BINS, VIEW_RTTY_TAPS, decimate,
+			(samplerate / (2.0 * VIEW_RTTY_BINS) + rtty_baud) / samplerate +
+			2.75 / VIEW_RTTY_TAPS);
+	else
+		input = new fftfilt(rtty_baud / samplerate, 1024);
+
 	for (int ch = 0; ch < MAX_CHANNELS; ch ++) {
 
 		reset_filters(ch);
@@ -167,8 +196,8 @@ void view_rtty::restart()
 		channel[ch].sigsearch = 0;
 		channel[ch].frequency = NULLFREQ;
 		channel[ch].counter = symbollen / 2;
-		channel[ch].mark_phase = 0;
-		channel[ch].space_phase = 0;
+		channel[ch].mark_osc.reset();
+		channel[ch].space_osc.reset();
 		channel[ch].mark_mag = 0;
 		channel[ch].space_mag = 0;
 		channel[ch].mark_env = 0;
@@ -194,7 +223,7 @@ void view_rtty::restart()
 	if (rtty_stop == 0) stl = 1.0;
 	else if (rtty_stop == 1) stl = 1.5;
 	else stl = 2.0;
-	stoplen = (int) (stl * samplerate / rtty_baud + 0.5);
+	stoplen = (int) (stl * samplerate / decimate / rtty_baud + 0.5);
 
 	rx_init();
 }
@@ -212,18 +241,16 @@ view_rtty::view_rtty(trx_mode tty_mode)
 		channel[ch].space_filt = (fftfilt *)0;
 		channel[ch].bits = (Cmovavg *)0;
 	}
+	chan = 0;
+	input = 0;
 
 	restart();
 }
 
-cmplx view_rtty::mixer(double &phase, double f, cmplx in)
+cmplx view_rtty::mixer(C_NCO &osc, double f, cmplx in)
 {
-	cmplx z = cmplx( cos(phase), sin(phase)) * in;;
-
-	phase -= TWOPI * f / samplerate;
-	if (phase < - TWOPI) phase += TWOPI;
-
-	return z;
+	osc.set_step(-TWOPI * f * decimate / samplerate);
+	return osc.mix(in);
 }
 
 
@@ -297,7 +324,8 @@ bool view_rtty::is_mark_space( int ch, int &correction)
 // test for mark/space straddle point
 		for (int i = 0; i < symbollen; i++)
 			correction += channel[ch].bit_buf[i];
-		if (abs(symbollen/2 - correction) < 6) // too small & bad signals are not decoded
+// too small & bad signals are not decoded; the limit is 5 full rate samples
+		if (abs(symbollen/2 - correction) * decimate <= max(5, decimate))
 			return true;
 	}
 	return false;
@@ -453,91 +481,129 @@ void view_rtty::clear()
 	}
 }
 
+void view_rtty::demodulate(int ch, cmplx *zp_mark, cmplx *zp_space, int n)
+{
+	bool bit;
+
+	for (int i = 0; i < n; i++) {
+
+		channel[ch].mark_mag = abs(zp_mark[i]);
+		channel[ch].mark_env = decayavg (channel[ch].mark_env, channel[ch].mark_mag,
+			(channel[ch].mark_mag > channel[ch].mark_env) ? symbollen / 4 : symbollen * 16);
+		channel[ch].mark_noise = decayavg (channel[ch].mark_noise, channel[ch].mark_mag,
+			(channel[ch].mark_mag < channel[ch].mark_noise) ? symbollen / 4 : symbollen * 48);
+		channel[ch].space_mag = abs(zp_space[i]);
+		channel[ch].space_env = decayavg (channel[ch].space_env, channel[ch].space_mag,
+			(channel[ch].space_mag > channel[ch].space_env) ? symbollen / 4 : symbollen * 16);
+		channel[ch].space_noise = decayavg (channel[ch].space_noise, channel[ch].space_mag,
+			(channel[ch].space_mag < channel[ch].space_noise) ? symbollen / 4 : symbollen * 48);
+
+		channel[ch].noise_floor = min(channel[ch].space_noise, channel[ch].mark_noise);
+
+// clipped if clipped decoder selected
+		double mclipped = 0, sclipped = 0;
+		mclipped = channel[ch].mark_mag > channel[ch].mark_env ? 
+					channel[ch].mark_env : channel[ch].mark_mag;
+		sclipped = channel[ch].space_mag > channel[ch].space_env ? 
+					channel[ch].space_env : channel[ch].space_mag;
+		if (mclipped < channel[ch].noise_floor) mclipped = channel[ch].noise_floor;
+		if (sclipped < channel[ch].noise_floor) sclipped = channel[ch].noise_floor;
+
+// Optimal ATC
+//		int v = (((mclipped - channel[ch].noise_floor) * (channel[ch].mark_env - channel[ch].noise_floor) -
+//				(sclipped - channel[ch].noise_floor) * (channel[ch].space_env - channel[ch].noise_floor)) -
+//		0.25 * ((channel[ch].mark_env - channel[ch].noise_floor) * 
+//				(channel[ch].mark_env - channel[ch].noise_floor) -
+//				(channel[ch].space_env - channel[ch].noise_floor) * 
+//				(channel[ch].space_env - channel[ch].noise_floor)));
+//		bit = (v > 0);
+// Kahn Square Law demodulator
+		bit = norm(zp_mark[i]) >= norm(zp_space[i]);
+
+		channel[ch].mark_history[channel[ch].inp_ptr] = zp_mark[i];
+		channel[ch].space_history[channel[ch].inp_ptr] = zp_space[i];
+		channel[ch].inp_ptr = (channel[ch].inp_ptr + 1) % MAXPIPE;
+
+		if (channel[ch].state == RCVNG && rx( ch, reverse ? !bit : bit ) ) {
+			if (channel[ch].sigsearch) channel[ch].sigsearch--;
+			int mp0 = channel[ch].inp_ptr - 2;
+			int mp1 = mp0 + 1;
+			if (mp0 < 0) mp0 += MAXPIPE;
+			if (mp1 < 0) mp1 += MAXPIPE;
+// the phase step between samples is `decimate' times that at the full rate
+			double ferr = (TWOPI * samplerate / rtty_baud / decimate) *
+				(!reverse ? 
+				arg(conj(channel[ch].mark_history[mp1]) * channel[ch].mark_history[mp0]) :
+				arg(conj(channel[ch].space_history[mp1]) * channel[ch].space_history[mp0]));
+			if (fabs(ferr) > rtty_baud / 2) ferr = 0;
+			channel[ch].freqerr = decayavg ( channel[ch].freqerr, ferr / 4,
+				progdefaults.rtty_afcspeed == 0 ? 8 :
+				progdefaults.rtty_afcspeed == 1 ? 4 : 1 );
+			if (channel[ch].metric > pow(10, progStatus.VIEWER_rttysquelch / 10.0))
+				channel[ch].frequency -= ferr;
+		}
+	}
+}
+
 int view_rtty::rx_process(const double *buf, int buflen)
 {
-	cmplx z, zmark, zspace, *zp_mark, *zp_space;
-	static bool bit = true;
+	cmplx zmark, zspace, *zp_mark, *zp_space;
 	int n = 0;
+	bool active = false;
 
 	rtty_squelch = pow(10, progStatus.VIEWER_rttysquelch / 10.0);
 
 	for (int ch = 0; ch < progdefaults.VIEWERchannels; ch++) {
 		if (channel[ch].state == IDLE)
 			continue;
+		active = true;
 		if (channel[ch].sigsearch) {
 			channel[ch].sigsearch--;
 			if (!channel[ch].sigsearch)
 				channel[ch].state = RCVNG;
 		}
+	}
 
-		for (int len = 0; len < buflen; len++) {
-			z = cmplx(buf[len], buf[len]);
-
-			zmark = mixer(channel[ch].mark_phase, channel[ch].frequency + shift/2.0, z);
-			channel[ch].mark_filt->run(zmark, &zp_mark);
-
-			zspace = mixer(channel[ch].space_phase, channel[ch].frequency - shift/2.0, z);
-			n = channel[ch].space_filt->run(zspace, &zp_space);
-
-// n loop
-			if (n) Metric(ch);
-
-			for (int i = 0; i < n; i++) {
-
-				channel[ch].mark_mag = abs(zp_mark[i]);
-				channel[ch].mark_env = decayavg (channel[ch].mark_env, channel[ch].mark_mag,
-					(channel[ch].mark_mag > channel[ch].mark_env) ? symbollen / 4 : symbollen * 16);
-				channel[ch].mark_noise = decayavg (channel[ch].mark_noise, channel[ch].mark_mag,
-					(channel[ch].mark_mag < channel[ch].mark_noise) ? symbollen / 4 : symbollen * 48);
-				channel[ch].space_mag = abs(zp_space[i]);
-				channel[ch].space_env = decayavg (channel[ch].space_env, channel[ch].space_mag,
-					(channel[ch].space_mag > channel[ch].space_env) ? symbollen / 4 : symbollen * 16);
-				channel[ch].space_noise = decayavg (channel[ch].space_noise, channel[ch].space_mag,
-					(channel[ch].space_mag < channel[ch].space_noise) ? symbollen / 4 : symbollen * 48);
-
-				channel[ch].noise_floor = min(channel[ch].space_noise, channel[ch].mark_noise);
-
-// clipped if clipped decoder selected
-				double mclipped = 0, sclipped = 0;
-				mclipped = channel[ch].mark_mag > channel[ch].mark_env ? 
-							channel[ch].mark_env : channel[ch].mark_mag;
-				sclipped = channel[ch].space_mag > channel[ch].space_env ? 
-							channel[ch].space_env : channel[ch].space_mag;
-				if (mclipped < channel[ch].noise_floor) mclipped = channel[ch].noise_floor;
-				if (sclipped < channel[ch].noise_floor) sclipped = channel[ch].noise_floor;
+	for (int len = 0; len < buflen; len++) {
+		if (input) {
+			if (!input->transform(buf[len]) || !active)
+				continue;
+		} else {
+			if (!chan->push(buf[len]) || !active)
+				continue;
+			chan->process();
+		}
 
-// Optimal ATC
-//				int v = (((mclipped - channel[ch].noise_floor) * (channel[ch].mark_env - channel[ch].noise_floor) -
-//						(sclipped - channel[ch].noise_floor) * (channel[ch].space_env - channel[ch].noise_floor)) -
-//				0.25 * ((channel[ch].mark_env - channel[ch].noise_floor) * 
-//						(channel[ch].mark_env - channel[ch].noise_floor) -
-//						(channel[ch].space_env - channel[ch].noise_floor) * 
-//						(channel[ch].space_env - channel[ch].noise_floor)));
-//				bit = (v > 0);
-// Kahn Square Law demodulator
-				bit = norm(zp_mark[i]) >= norm(zp_space[i]);
-
-				channel[ch].mark_history[channel[ch].inp_ptr] = zp_mark[i];
-				channel[ch].space_history[channel[ch].inp_ptr] = zp_space[i];
-				channel[ch].inp_ptr = (channel[ch].inp_ptr + 1) % MAXPIPE;
-
-				if (channel[ch].state == RCVNG && rx( ch, reverse ? !bit : bit ) ) {
-					if (channel[ch].sigsearch) channel[ch].sigsearch--;
-					int mp0 = channel[ch].inp_ptr - 2;
-					int mp1 = mp0 + 1;
-					if (mp0 < 0) mp0 += MAXPIPE;
-					if (mp1 < 0) mp1 += MAXPIPE;
-					double ferr = (TWOPI * samplerate / rtty_baud) *
-						(!reverse ? 
-						arg(conj(channel[ch].mark_history[mp1]) * channel[ch].mark_history[mp0]) :
-						arg(conj(channel[ch].space_history[mp1]) * channel[ch].space_history[mp0]));
-					if (fabs(ferr) > rtty_baud / 2) ferr = 0;
-					channel[ch].freqerr = decayavg ( channel[ch].freqerr, ferr / 4,
-						progdefaults.rtty_afcspeed == 0 ? 8 :
-						progdefaults.rtty_afcspeed == 1 ? 4 : 1 );
-					if (channel[ch].metric > pow(10, progStatus.VIEWER_rttysquelch / 10.0))
-						channel[ch].frequency -= ferr;
+		for (int ch = 0; ch < progdefaults.VIEWERchannels; ch++) {
+			if (channel[ch].state == IDLE)
+				continue;
+
+			double fm = channel[ch].frequency + shift/2.0;
+			double fs = channel[ch].frequency - shift/2.0;
+
+			if (input) {
+				channel[ch].mark_filt->shift(fm / samplerate);
+				channel[ch].mark_filt->run(*input, &zp_mark);
+				channel[ch].space_filt->shift(fs / samplerate);
+				n = channel[ch].space_filt->run(*input, &zp_space);
+				for (int i = 0; i < n; i++) {
+					zp_mark[i] = mixer(channel[ch].mark_osc, fm, zp_mark[i]);
+					zp_space[i] = mixer(channel[ch].space_osc, fs, zp_space[i]);
 				}
+			} else {
+// conj() keeps the sense of the mixers, and so of the AFC, as it was
+				zmark = mixer(channel[ch].mark_osc, fm,
+					conj(chan->bin(chan->nearest(fm / samplerate))));
+				channel[ch].mark_filt->run(zmark, &zp_mark);
+
+				zspace = mixer(channel[ch].space_osc, fs,
+					conj(chan->bin(chan->nearest(fs / samplerate))));
+				n = channel[ch].space_filt->run(zspace, &zp_space);
+			}
+
+			if (n) {
+				Metric(ch);
+				demodulate(ch, zp_mark, zp_space, n);
 			}
 		}
 	}
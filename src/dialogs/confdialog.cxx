@@ -4746,6 +4746,8 @@ Fl_Input *imagepacketurl=(Fl_Input *)0;
 static void cb_imagepacketurl(Fl_Input* o, void*) {
   progdefaults.ssdv_packet_url = o->value();
 progdefaults.changed = true;
+dl_fldigi::changed(dl_fldigi::CH_SSDV_SETTINGS);
+btnApplyConfig->activate();
 }
 
 Fl_Check_Button *imagesave=(Fl_Check_Button *)0;
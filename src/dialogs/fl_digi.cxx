@@ -122,9 +122,6 @@
 
 #include "htmlstrings.h"
 #	include "xmlrpc.h"
-#if BENCHMARK_MODE
-#	include "benchmark.h"
-#endif
 #include "debug.h"
 #include "re.h"
 #include "network.h"
@@ -158,6 +155,7 @@
 #include "dl_fldigi/dl_fldigi.h"
 #include "dl_fldigi/flights.h"
 #include "dl_fldigi/hbtint.h"
+#include "dl_fldigi/extractor.h"
 #include "dl_fldigi/update.h"
 bool bHAB = false;
 
@@ -903,9 +901,6 @@ void set_dominoex_tab_widgets()
 void startup_modem(modem* m, int f)
 {
 	trx_start_modem(m, f);
-#if BENCHMARK_MODE
-	return;
-#endif
 
 	restoreFocus();
 
@@ -1123,16 +1118,80 @@ void init_modem_squelch(trx_mode mode, int freq)
 	init_modem(mode, freq);
 }
 
+// Returns a new modem for `mode'
+modem* create_modem(trx_mode mode)
+{
+	switch (mode) {
+	case MODE_NULL:
+		return new NULLMODEM;
+	case MODE_CW:
+		return new cw;
+
+	case MODE_THOR4: case MODE_THOR5: case MODE_THOR8:
+	case MODE_THOR11:case MODE_THOR16: case MODE_THOR22: 
+	case MODE_THOR25x4: case MODE_THOR50x1: case MODE_THOR50x2: case MODE_THOR100: 
+		return new thor(mode);
+
+	case MODE_DOMINOEX4: case MODE_DOMINOEX5: case MODE_DOMINOEX8:
+	case MODE_DOMINOEX11: case MODE_DOMINOEX16: case MODE_DOMINOEX22:
+	case MODE_DOMINOEX44: case MODE_DOMINOEX88:
+		return new dominoex(mode);
+
+	case MODE_FELDHELL: case MODE_SLOWHELL: case MODE_HELLX5: case MODE_HELLX9:
+	case MODE_FSKHELL: case MODE_FSKH105: case MODE_HELL80:
+		return new feld(mode);
+
+	case MODE_MFSK4: case MODE_MFSK11: case MODE_MFSK22: case MODE_MFSK31:
+	case MODE_MFSK64: case MODE_MFSK8: case MODE_MFSK16: case MODE_MFSK32:
+	case MODE_MFSK128: case MODE_MFSK64L: case MODE_MFSK128L:
+		return new mfsk(mode);
+
+	case MODE_WEFAX_576: case MODE_WEFAX_288:
+		return new wefax(mode);
+
+	case MODE_NAVTEX: case MODE_SITORB:
+		return new navtex(mode);
+
+	case MODE_MT63_500S: case MODE_MT63_1000S: case MODE_MT63_2000S :
+	case MODE_MT63_500L: case MODE_MT63_1000L: case MODE_MT63_2000L :
+		return new mt63(mode);
+
+	case MODE_OLIVIA: case MODE_OLIVIA_4_250: case MODE_OLIVIA_8_250:
+	case MODE_OLIVIA_4_500: case MODE_OLIVIA_8_500: case MODE_OLIVIA_16_500:
+	case MODE_OLIVIA_8_1000: case MODE_OLIVIA_16_1000: case MODE_OLIVIA_32_1000:
+	case MODE_OLIVIA_64_2000:
+		return new olivia(mode);
+
+	case MODE_CONTESTIA:
+		return new contestia;
+
+	case MODE_RTTY:
+		return new rtty(mode);
+
+	case MODE_THROB1: case MODE_THROB2: case MODE_THROB4:
+	case MODE_THROBX1: case MODE_THROBX2: case MODE_THROBX4:
+		return new throb(mode);
+
+	case MODE_WWV:
+		return new wwv;
+	case MODE_ANALYSIS:
+		return new anal;
+	case MODE_SSB:
+		return new ssb;
+
+	default: // all the PSK modes
+		return new psk(mode);
+	}
+}
+
 void init_modem(trx_mode mode, int freq)
 {
 	ENSURE_THREAD(FLMAIN_TID);
 
 LOG_INFO("mode: %d, freq: %d", (int)mode, freq);
 
-#if !BENCHMARK_MODE
        quick_change = 0;
        modem_config_tab = tabsModems->child(0);
-#endif
 
 	switch (mode) {
 	case MODE_NEXT:
@@ -1146,12 +1205,12 @@ LOG_INFO("mode: %d, freq: %d", (int)mode, freq);
 
 	case MODE_NULL:
 		startup_modem(*mode_info[mode].modem ? *mode_info[mode].modem :
-			      *mode_info[mode].modem = new NULLMODEM, freq);
+			      *mode_info[mode].modem = create_modem(mode), freq);
 		break;
 
 	case MODE_CW:
 		startup_modem(*mode_info[mode].modem ? *mode_info[mode].modem :
-			      *mode_info[mode].modem = new cw, freq);
+			      *mode_info[mode].modem = create_modem(mode), freq);
 		modem_config_tab = tabCW;
 		break;
 
@@ -1159,7 +1218,7 @@ LOG_INFO("mode: %d, freq: %d", (int)mode, freq);
 	case MODE_THOR11:case MODE_THOR16: case MODE_THOR22: 
 	case MODE_THOR25x4: case MODE_THOR50x1: case MODE_THOR50x2: case MODE_THOR100: 
 		startup_modem(*mode_info[mode].modem ? *mode_info[mode].modem :
-			      *mode_info[mode].modem = new thor(mode), freq);
+			      *mode_info[mode].modem = create_modem(mode), freq);
 		quick_change = quick_change_thor;
 		modem_config_tab = tabTHOR;
 		break;
@@ -1168,7 +1227,7 @@ LOG_INFO("mode: %d, freq: %d", (int)mode, freq);
 	case MODE_DOMINOEX11: case MODE_DOMINOEX16: case MODE_DOMINOEX22:
 	case MODE_DOMINOEX44: case MODE_DOMINOEX88:
 		startup_modem(*mode_info[mode].modem ? *mode_info[mode].modem :
-			      *mode_info[mode].modem = new dominoex(mode), freq);
+			      *mode_info[mode].modem = create_modem(mode), freq);
 		quick_change = quick_change_domino;
 		modem_config_tab = tabDomEX;
 		break;
@@ -1181,7 +1240,7 @@ LOG_INFO("mode: %d, freq: %d", (int)mode, freq);
 	case MODE_FSKH105:
 	case MODE_HELL80:
 		startup_modem(*mode_info[mode].modem ? *mode_info[mode].modem :
-			      *mode_info[mode].modem = new feld(mode), freq);
+			      *mode_info[mode].modem = create_modem(mode), freq);
 		quick_change = quick_change_feld;
 		modem_config_tab = tabFeld;
 		break;
@@ -1198,14 +1257,14 @@ LOG_INFO("mode: %d, freq: %d", (int)mode, freq);
 	case MODE_MFSK64L:
 	case MODE_MFSK128L:
 		startup_modem(*mode_info[mode].modem ? *mode_info[mode].modem :
-			      *mode_info[mode].modem = new mfsk(mode), freq);
+			      *mode_info[mode].modem = create_modem(mode), freq);
 		quick_change = quick_change_mfsk;
 		break;
 
 	case MODE_WEFAX_576:
 	case MODE_WEFAX_288:
 		startup_modem(*mode_info[mode].modem ? *mode_info[mode].modem :
-			      *mode_info[mode].modem = new wefax(mode), freq);
+			      *mode_info[mode].modem = create_modem(mode), freq);
 		quick_change = quick_change_wefax;
 		modem_config_tab = tabWefax;
 		break;
@@ -1213,7 +1272,7 @@ LOG_INFO("mode: %d, freq: %d", (int)mode, freq);
 	case MODE_NAVTEX:
 	case MODE_SITORB:
 		startup_modem(*mode_info[mode].modem ? *mode_info[mode].modem :
-			      *mode_info[mode].modem = new navtex(mode), freq);
+			      *mode_info[mode].modem = create_modem(mode), freq);
 		quick_change = quick_change_navtex;
 		modem_config_tab = tabNavtex;
 		break;
@@ -1221,7 +1280,7 @@ LOG_INFO("mode: %d, freq: %d", (int)mode, freq);
 	case MODE_MT63_500S: case MODE_MT63_1000S: case MODE_MT63_2000S :
 	case MODE_MT63_500L: case MODE_MT63_1000L: case MODE_MT63_2000L :
 		startup_modem(*mode_info[mode].modem ? *mode_info[mode].modem :
-			      *mode_info[mode].modem = new mt63(mode), freq);
+			      *mode_info[mode].modem = create_modem(mode), freq);
 		quick_change = quick_change_mt63;
 		modem_config_tab = tabMT63;
 		break;
@@ -1230,20 +1289,20 @@ LOG_INFO("mode: %d, freq: %d", (int)mode, freq);
 	case MODE_PSK125: case MODE_PSK250: case MODE_PSK500:
 	case MODE_PSK1000:
 		startup_modem(*mode_info[mode].modem ? *mode_info[mode].modem :
-			      *mode_info[mode].modem = new psk(mode), freq);
+			      *mode_info[mode].modem = create_modem(mode), freq);
 		quick_change = quick_change_psk;
 		modem_config_tab = tabPSK;
 		break;
 	case MODE_QPSK31: case MODE_QPSK63: case MODE_QPSK125: case MODE_QPSK250: case MODE_QPSK500:
 		startup_modem(*mode_info[mode].modem ? *mode_info[mode].modem :
-			      *mode_info[mode].modem = new psk(mode), freq);
+			      *mode_info[mode].modem = create_modem(mode), freq);
 		quick_change = quick_change_qpsk;
 		modem_config_tab = tabPSK;
 		break;
 	case MODE_PSK125R: case MODE_PSK250R: case MODE_PSK500R:
 	case MODE_PSK1000R:
 		startup_modem(*mode_info[mode].modem ? *mode_info[mode].modem :
-			      *mode_info[mode].modem = new psk(mode), freq);
+			      *mode_info[mode].modem = create_modem(mode), freq);
 		quick_change = quick_change_pskr;
 		modem_config_tab = tabPSK;
 		break;
@@ -1255,7 +1314,7 @@ LOG_INFO("mode: %d, freq: %d", (int)mode, freq);
 	case MODE_2X_PSK800 :
 	case MODE_2X_PSK1000 :
 		startup_modem(*mode_info[mode].modem ? *mode_info[mode].modem :
-			      *mode_info[mode].modem = new psk(mode), freq);
+			      *mode_info[mode].modem = create_modem(mode), freq);
 		quick_change = quick_change_psk_multi;
 		modem_config_tab = tabPSK;
 		break;
@@ -1285,7 +1344,7 @@ LOG_INFO("mode: %d, freq: %d", (int)mode, freq);
 	case MODE_2X_PSK800R :
 	case MODE_2X_PSK1000R :
 		startup_modem(*mode_info[mode].modem ? *mode_info[mode].modem :
-			      *mode_info[mode].modem = new psk(mode), freq);
+			      *mode_info[mode].modem = create_modem(mode), freq);
 		quick_change = quick_change_psk_multiR;
 		modem_config_tab = tabPSK;
 		break;
@@ -1301,21 +1360,21 @@ LOG_INFO("mode: %d, freq: %d", (int)mode, freq);
 	case MODE_OLIVIA_32_1000:
 	case MODE_OLIVIA_64_2000:
 		startup_modem(*mode_info[mode].modem ? *mode_info[mode].modem :
-			      *mode_info[mode].modem = new olivia(mode), freq);
+			      *mode_info[mode].modem = create_modem(mode), freq);
 		modem_config_tab = tabOlivia;
 		quick_change = quick_change_olivia;
 		break;
 
 	case MODE_CONTESTIA:
 		startup_modem(*mode_info[mode].modem ? *mode_info[mode].modem :
-			      *mode_info[mode].modem = new contestia, freq);
+			      *mode_info[mode].modem = create_modem(mode), freq);
 		modem_config_tab = tabContestia;
 		quick_change = quick_change_contestia;
 		break;
 
 	case MODE_RTTY:
 		startup_modem(*mode_info[mode].modem ? *mode_info[mode].modem :
-			      *mode_info[mode].modem = new rtty(mode), freq);
+			      *mode_info[mode].modem = create_modem(mode), freq);
 		modem_config_tab = tabRTTY;
 		quick_change = quick_change_rtty;
 		break;
@@ -1323,39 +1382,35 @@ LOG_INFO("mode: %d, freq: %d", (int)mode, freq);
 	case MODE_THROB1: case MODE_THROB2: case MODE_THROB4:
 	case MODE_THROBX1: case MODE_THROBX2: case MODE_THROBX4:
 		startup_modem(*mode_info[mode].modem ? *mode_info[mode].modem :
-			      *mode_info[mode].modem = new throb(mode), freq);
+			      *mode_info[mode].modem = create_modem(mode), freq);
 		quick_change = quick_change_throb;
 		break;
 
 	case MODE_WWV:
 		startup_modem(*mode_info[mode].modem ? *mode_info[mode].modem :
-			      *mode_info[mode].modem = new wwv, freq);
+			      *mode_info[mode].modem = create_modem(mode), freq);
 		break;
 
 	case MODE_ANALYSIS:
 		startup_modem(*mode_info[mode].modem ? *mode_info[mode].modem :
-			      *mode_info[mode].modem = new anal, freq);
+			      *mode_info[mode].modem = create_modem(mode), freq);
 		break;
 
 	case MODE_SSB:
 		startup_modem(*mode_info[mode].modem ? *mode_info[mode].modem :
-			      *mode_info[mode].modem = new ssb, freq);
+			      *mode_info[mode].modem = create_modem(mode), freq);
 		break;
 
 	default:
 		LOG_ERROR("Unknown mode: %" PRIdPTR, mode);
 		mode = MODE_PSK31;
 		startup_modem(*mode_info[mode].modem ? *mode_info[mode].modem :
-			      *mode_info[mode].modem = new psk(mode), freq);
+			      *mode_info[mode].modem = create_modem(mode), freq);
 		quick_change = quick_change_psk;
 		modem_config_tab = tabPSK;
 		break;
 	}
 
-#if BENCHMARK_MODE
-	return;
-#endif
-
 	clear_StatusMessages();
 	progStatus.lastmode = mode;
 
@@ -6659,11 +6714,15 @@ void create_fl_digi_main(int argc, char** argv)
 
 void put_freq(double frequency)
 {
+	if (trx_extra_modem() >= 0)
+		return;
 	wf->carrier((int)floor(frequency + 0.5));
 }
 
 void put_Bandwidth(int bandwidth)
 {
+	if (trx_extra_modem() >= 0)
+		return;
 	wf->Bandwidth ((int)bandwidth);
 }
 
@@ -6681,6 +6740,8 @@ static void callback_set_metric(double metric)
 
 void global_display_metric(double metric)
 {
+	if (trx_extra_modem() >= 0)
+		return;
 	FL_LOCK_D();
 	REQ_DROP(callback_set_metric, metric);
 	FL_UNLOCK_D();
@@ -6689,6 +6750,8 @@ void global_display_metric(double metric)
 
 void put_cwRcvWPM(double wpm)
 {
+	if (trx_extra_modem() >= 0)
+		return;
 	int U = progdefaults.CWupperlimit;
 	int L = progdefaults.CWlowerlimit;
 	double dWPM = 100.0*(wpm - L)/(U - L);
@@ -6701,6 +6764,8 @@ void put_cwRcvWPM(double wpm)
 
 void set_scope_mode(Digiscope::scope_mode md)
 {
+	if (trx_extra_modem() >= 0)
+		return;
 	if (digiscope) {
 		digiscope->mode(md);
 		REQ(&Fl_Window::size_range, scopeview, SCOPEWIN_MIN_WIDTH, SCOPEWIN_MIN_HEIGHT,
@@ -6712,6 +6777,8 @@ void set_scope_mode(Digiscope::scope_mode md)
 
 void set_scope(double *data, int len, bool autoscale)
 {
+	if (trx_extra_modem() >= 0)
+		return;
 	if (digiscope)
 		digiscope->data(data, len, autoscale);
 	wf->wfscope->data(data, len, autoscale);
@@ -6719,6 +6786,8 @@ void set_scope(double *data, int len, bool autoscale)
 
 void set_phase(double phase, double quality, bool highlight)
 {
+	if (trx_extra_modem() >= 0)
+		return;
 	if (digiscope)
 		digiscope->phase(phase, quality, highlight);
 	wf->wfscope->phase(phase, quality, highlight);
@@ -6726,6 +6795,8 @@ void set_phase(double phase, double quality, bool highlight)
 
 void set_rtty(double flo, double fhi, double amp)
 {
+	if (trx_extra_modem() >= 0)
+		return;
 	if (digiscope)
 		digiscope->rtty(flo, fhi, amp);
 	wf->wfscope->rtty(flo, fhi, amp);
@@ -6733,6 +6804,8 @@ void set_rtty(double flo, double fhi, double amp)
 
 void set_video(double *data, int len, bool dir)
 {
+	if (trx_extra_modem() >= 0)
+		return;
 	if (digiscope)
 		digiscope->video(data, len, dir);
 	wf->wfscope->video(data, len, dir);
@@ -6740,6 +6813,8 @@ void set_video(double *data, int len, bool dir)
 
 void set_zdata(cmplx *zarray, int len)
 {
+	if (trx_extra_modem() >= 0)
+		return;
 	if (digiscope)
 		digiscope->zdata(zarray, len);
 	wf->wfscope->zdata(zarray, len);
@@ -6747,6 +6822,8 @@ void set_zdata(cmplx *zarray, int len)
 
 void set_scope_xaxis_1(double y1)
 {
+	if (trx_extra_modem() >= 0)
+		return;
 	if (digiscope)
 		digiscope->xaxis_1(y1);
 	wf->wfscope->xaxis_1(y1);
@@ -6754,6 +6831,8 @@ void set_scope_xaxis_1(double y1)
 
 void set_scope_xaxis_2(double y2)
 {
+	if (trx_extra_modem() >= 0)
+		return;
 	if (digiscope)
 		digiscope->xaxis_2(y2);
 	wf->wfscope->xaxis_2(y2);
@@ -6761,6 +6840,8 @@ void set_scope_xaxis_2(double y2)
 
 void set_scope_yaxis_1(double x1)
 {
+	if (trx_extra_modem() >= 0)
+		return;
 	if (digiscope)
 		digiscope->yaxis_1(x1);
 	wf->wfscope->yaxis_1(x1);
@@ -6768,6 +6849,8 @@ void set_scope_yaxis_1(double x1)
 
 void set_scope_yaxis_2(double x2)
 {
+	if (trx_extra_modem() >= 0)
+		return;
 	if (digiscope)
 		digiscope->yaxis_2(x2);
 	wf->wfscope->yaxis_2(x2);
@@ -6775,6 +6858,8 @@ void set_scope_yaxis_2(double x2)
 
 void set_scope_clear_axis()
 {
+	if (trx_extra_modem() >= 0)
+		return;
 	if (digiscope) {
 		digiscope->xaxis_1(0);
 		digiscope->xaxis_2(0);
@@ -6869,13 +6954,42 @@ void add_tx_char(int data)
 }
 
 //======================================================================
+// Received text gathered while put_rx_chars_flmain() runs: the text for the
+// log files, and the last run of ReceiveText characters that share a style
+static bool rx_text_batch = false;
+static string rx_log_text;
+static string rx_text_run;
+static int rx_text_run_style;
+
+static void flush_rx_text_run(void)
+{
+	if (rx_text_run.empty())
+		return;
+	ReceiveText->addstr(rx_text_run, rx_text_run_style);
+	rx_text_run.clear();
+}
+
 static void display_rx_data(const unsigned char data, int style) {
-	ReceiveText->add(data, style);
+	// a NUL would end the run's string, so it is added on its own
+	if (!rx_text_batch || !data || style != rx_text_run_style)
+		flush_rx_text_run();
+	if (rx_text_batch && data) {
+		rx_text_run_style = style;
+		rx_text_run += (char)data;
+	}
+	else
+		ReceiveText->add(data, style);
 
 	if (bWF_only) return;
 
 	speak(data);
 
+	if (rx_text_batch) {
+		if (Maillogfile || progStatus.LOGenabled)
+			rx_log_text += (char)data;
+		return;
+	}
+
 	if (Maillogfile)
 		Maillogfile->log_to_file(cLogfile::LOG_RX, string(1, (const char)data));
 
@@ -6962,40 +7076,187 @@ static void put_rx_char_flmain(unsigned int data, int style)
 	}
 }
 
+// One character and style byte for each character in data
+static void put_rx_chars_flmain(const string& data, const string& style)
+{
+	ENSURE_THREAD(FLMAIN_TID);
+
+	rx_text_batch = true;
+	for (size_t i = 0; i < data.length(); i++)
+		put_rx_char_flmain((unsigned char)data[i], (unsigned char)style[i]);
+	rx_text_batch = false;
+	flush_rx_text_run();
+
+	if (rx_log_text.empty())
+		return;
+	if (Maillogfile)
+		Maillogfile->log_to_file(cLogfile::LOG_RX, rx_log_text);
+	if (progStatus.LOGenabled)
+		logfile->log_to_file(cLogfile::LOG_RX, rx_log_text);
+	rx_log_text.clear();
+}
+
+// ----------------------------------------------------------------------------
+// Extra modems
+
+static Fl_Double_Window* extra_modem_win[NUM_EXTRA_MODEMS];
+static FTextRX* extra_modem_text[NUM_EXTRA_MODEMS];
+
+static inline bool extra_rx_char_shown(unsigned char data)
+{
+	return data != '\r' && (data >= ' ' || data == '\n');
+}
+
+static void put_extra_rx_char_flmain(int i, unsigned int data)
+{
+	ENSURE_THREAD(FLMAIN_TID);
+
+	if (!extra_modem_text[i] || !extra_rx_char_shown(data))
+		return;
+	extra_modem_text[i]->add(data);
+}
+
+static void put_extra_rx_chars_flmain(int i, const string& data)
+{
+	ENSURE_THREAD(FLMAIN_TID);
+
+	if (!extra_modem_text[i])
+		return;
+	string text;
+	text.reserve(data.length());
+	for (size_t j = 0; j < data.length(); j++)
+		if (extra_rx_char_shown(data[j]))
+			text += data[j];
+	if (!text.empty())
+		extra_modem_text[i]->addstr(text);
+}
+
+static void cb_extra_modem_win(Fl_Widget* w, void* arg)
+{
+	trx_remove_modem(reinterpret_cast<intptr_t>(arg));
+	w->hide();
+}
+
+void start_extra_modem(trx_mode mode, int freq, const modem_settings& settings)
+{
+	ENSURE_THREAD(FLMAIN_TID);
+
+	if (!trx_extra_mode_ok(mode)) {
+		LOG_ERROR("Cannot receive mode %" PRIdPTR " as an extra modem", mode);
+		return;
+	}
+	if (freq <= 0)
+		freq = progdefaults.PSKsweetspot;
+
+	int i = trx_add_modem(mode, freq, settings);
+	if (i < 0) {
+		LOG_ERROR("No room for another extra modem (at most %d)", NUM_EXTRA_MODEMS);
+		return;
+	}
+
+	if (!extra_modem_win[i]) {
+		extra_modem_win[i] = new Fl_Double_Window(480, 160);
+		extra_modem_text[i] = new FTextRX(0, 0, 480, 160);
+		extra_modem_win[i]->resizable(extra_modem_text[i]);
+		extra_modem_win[i]->end();
+		extra_modem_win[i]->xclass(PACKAGE_NAME);
+		extra_modem_win[i]->callback(cb_extra_modem_win, reinterpret_cast<void*>(i));
+	}
+	else
+		extra_modem_text[i]->clear();
+
+	char title[96];
+	int n = snprintf(title, sizeof(title), "%s @ %d Hz", mode_info[mode].sname, freq);
+	if (mode == MODE_RTTY && settings.rtty_baud > 0)
+		n += snprintf(title + n, sizeof(title) - n, ", %g baud", settings.rtty_baud);
+	if (mode == MODE_RTTY && settings.rtty_shift > 0)
+		snprintf(title + n, sizeof(title) - n, ", %g Hz shift", settings.rtty_shift);
+	extra_modem_win[i]->copy_label(title);
+	extra_modem_win[i]->show();
+}
+
+// Characters collected between batch_rx_chars() and flush_rx_chars(), with
+// one style byte for each
+struct rx_char_batch {
+	bool on;
+	string data, style;
+};
+static rx_char_batch rx_batch[NUM_THREADS];
+
+static rx_char_batch* get_rx_batch(void)
+{
+	intptr_t id = GET_THREAD_ID();
+	if (id < 0 || id >= NUM_THREADS || !rx_batch[id].on)
+		return 0;
+	return &rx_batch[id];
+}
+
+void batch_rx_chars(void)
+{
+	intptr_t id = GET_THREAD_ID();
+	if (id >= 0 && id < NUM_THREADS)
+		rx_batch[id].on = true;
+}
+
+void flush_rx_chars(void)
+{
+	rx_char_batch* b = get_rx_batch();
+	if (!b)
+		return;
+	b->on = false;
+	if (b->data.empty())
+		return;
+
+	int extra = trx_extra_modem();
+	if (extra >= 0)
+		REQ(put_extra_rx_chars_flmain, extra, b->data);
+	else {
+		WriteARQ(b->data.data(), b->data.length());
+		REQ(put_rx_chars_flmain, b->data, b->style);
+	}
+	b->data.clear();
+	b->style.clear();
+}
+
 void put_rx_char(unsigned int data, int style, bool extracted)
 {
-#if BENCHMARK_MODE
-	if (!benchmark.output.empty()) {
-		if (unlikely(benchmark.buffer.length() + 16 > benchmark.buffer.capacity()))
-			benchmark.buffer.reserve(benchmark.buffer.capacity() + BUFSIZ);
-		benchmark.buffer += (char)data;
+	int extra = trx_extra_modem();
+	rx_char_batch* b = get_rx_batch();
+	if (extra >= 0) {
+		if (b)
+			b->data += (char)data;
+		else
+			REQ(put_extra_rx_char_flmain, extra, data);
+		if (!extracted)
+			dl_fldigi::extractor::put(data);
+		return;
 	}
-#else
+
 	if (progdefaults.autoextract == true)
 		rx_extract_add(data);
-	WriteARQ(data);
-	REQ(put_rx_char_flmain, data, style);
-#endif
+	if (b) {
+		b->data += (char)data;
+		b->style += (char)style;
+	}
+	else {
+		WriteARQ(data);
+		REQ(put_rx_char_flmain, data, style);
+	}
 
     if (!extracted)
     {
-        dl_fldigi::hbtint::extrmgr->push(data);
+        dl_fldigi::extractor::put(data);
     }
 }
 
-static void put_rx_ssdv_flmain(unsigned int data, int lost)
+// The SSDV window decodes on its own thread and only hands the GUI thread
+// what it has to show.
+void put_rx_ssdv(unsigned int data, int lost)
 {
-	ENSURE_THREAD(FLMAIN_TID);
-
+	if (trx_extra_modem() >= 0)
+		return;
 	if (ssdv)
-	{
 		ssdv->put_byte(data, lost);
-	}
-}
-
-void put_rx_ssdv(unsigned int data, int lost)
-{
-	REQ(put_rx_ssdv_flmain, data, lost);
 }
 
 static string strSecText = "";
@@ -7022,6 +7283,8 @@ static void put_sec_char_flmain(char chr)
 
 void put_sec_char(char chr)
 {
+	if (trx_extra_modem() >= 0)
+		return;
 	REQ(put_sec_char_flmain, chr);
 }
 
@@ -7047,6 +7310,8 @@ static void put_status_msg(Fl_Box* status, const char* msg, double timeout, stat
 
 void put_status(const char *msg, double timeout, status_timeout action)
 {
+	if (trx_extra_modem() >= 0)
+		return;
 	static char m[50];
 	strncpy(m, msg, sizeof(m));
 	m[sizeof(m) - 1] = '\0';
@@ -7068,6 +7333,8 @@ void put_status_safe(const char *msg, double timeout, status_timeout action)
 
 void put_Status2(const char *msg, double timeout, status_timeout action)
 {
+	if (trx_extra_modem() >= 0)
+		return;
 	static char m[60];
 	strncpy(m, msg, sizeof(m));
 	m[sizeof(m) - 1] = '\0';
@@ -7079,6 +7346,8 @@ void put_Status2(const char *msg, double timeout, status_timeout action)
 
 void put_Status1(const char *msg, double timeout, status_timeout action)
 {
+	if (trx_extra_modem() >= 0)
+		return;
 	static char m[60];
 	strncpy(m, msg, sizeof(m));
 	m[sizeof(m) - 1] = '\0';
@@ -7091,6 +7360,8 @@ void put_Status1(const char *msg, double timeout, status_timeout action)
 
 void put_WARNstatus(double val)
 {
+	if (trx_extra_modem() >= 0)
+		return;
 	FL_LOCK_D();
 	if (val < 0.05)
 		WARNstatus->color(progdefaults.LowSignal);
@@ -7127,6 +7398,8 @@ void clear_StatusMessages()
 
 void put_MODEstatus(const char* fmt, ...)
 {
+	if (trx_extra_modem() >= 0)
+		return;
 	static char s[32];
 	va_list args;
 	va_start(args, fmt);
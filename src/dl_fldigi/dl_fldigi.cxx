@@ -23,6 +23,8 @@
 #include "dl_fldigi/location.h"
 #include "dl_fldigi/gps.h"
 #include "dl_fldigi/update.h"
+#include "dl_fldigi/ssdv_upload.h"
+#include "dl_fldigi/station.h"
 
 using namespace std;
 
@@ -54,9 +56,13 @@ void ready(bool hab_mode)
 {
     hab_ui_exists = hab_mode;
 
+    /* The threads started below read the settings from the start */
+    station::publish();
+
     flights::load_cache();
     hbtint::start();
     location::start();
+    ssdv_upload::start();
 
     /* online will call uthr->settings() if hab_mode since it online will
      * "change" from false to true) */
@@ -74,8 +80,10 @@ void cleanup()
     shutting_down = true;
 
     gps::cleanup();
+    ssdv_upload::cleanup();
     hbtint::cleanup();
     flights::cleanup();
+    station::cleanup();
 }
 
 static void periodically(void *)
@@ -136,7 +144,9 @@ void online(bool val)
 
     if (changed)
     {
+        station::publish();
         hbtint::uthr->settings();
+        ssdv_upload::online(val);
     }
 
     if (changed && dl_online)
@@ -189,6 +199,14 @@ void commit()
 {
     Fl_AutoLock lock;
 
+    if (dirty & CH_LOCATION_MODE)
+    {
+        location::current_location_mode = location::new_location_mode;
+    }
+
+    if (dirty != CH_NONE)
+        station::publish();
+
     /* Update something if its settings change; fairly simple: */
     if (dirty & CH_UTHR_SETTINGS)
     {
@@ -200,9 +218,9 @@ void commit()
         hbtint::uthr->payloads();
     }
 
-    if (dirty & CH_LOCATION_MODE)
+    if (dirty & CH_SSDV_SETTINGS)
     {
-        location::current_location_mode = location::new_location_mode;
+        ssdv_upload::settings();
     }
 
     if ((dirty & CH_LOCATION_MODE) || (dirty & CH_GPS_SETTINGS))
@@ -248,4 +266,36 @@ void status_important(const string &message)
     last_warn = time(NULL);
 }
 
+struct posted_status
+{
+    string message;
+    bool important;
+};
+
+static void show_posted_status(void *arg)
+{
+    posted_status *s = static_cast<posted_status *>(arg);
+
+    if (!shutting_down)
+    {
+        if (s->important)
+            status_important(s->message);
+        else
+            status(s->message);
+    }
+
+    delete s;
+}
+
+void post_status(const string &message, bool important)
+{
+    posted_status *s = new posted_status;
+    s->message = message;
+    s->important = important;
+
+    /* Fl::awake fails if its queue is full */
+    if (Fl::awake(show_posted_status, s) != 0)
+        delete s;
+}
+
 } /* namespace dl_fldigi */
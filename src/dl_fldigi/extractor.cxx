@@ -0,0 +1,334 @@
+/*
+ * License: GNU GPL 3
+ *
+ * extractor.cxx: UKHAS sentence framing and checksums, on their own thread
+ */
+
+#include "dl_fldigi/extractor.h"
+
+#include <string>
+#include <algorithm>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "debug.h"
+#include "threads.h"
+#include "trx.h"
+#include "modem.h"
+#include "ringbuffer.h"
+
+#include "dl_fldigi/hbtint.h"
+
+using namespace std;
+
+namespace dl_fldigi {
+namespace extractor {
+
+/* Longer than any sentence habitat will take */
+static const size_t max_sentence = 1024;
+
+struct rx_byte
+{
+    unsigned char c;
+    bool baudot, reversed;
+    int lost, audio_freq;
+};
+
+enum state { SEARCH, DOLLAR, BODY };
+
+struct stream
+{
+    /* Written by the modem's thread only */
+    ringbuffer<rx_byte> *input;
+    int lost;
+
+    /* The extractor thread's */
+    enum state st;
+    string sentence;
+    bool damaged, baudot, reversed;
+    int audio_freq;
+};
+
+/* The active modem's, then one for each extra modem */
+#define NUM_STREAMS (1 + NUM_EXTRA_MODEMS)
+static stream streams[NUM_STREAMS];
+
+static pthread_t thread;
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+static bool running, quit;
+
+static uint16_t crc_table[256];
+
+static void make_crc_table()
+{
+    for (int i = 0; i < 256; i++)
+    {
+        uint16_t crc = i << 8;
+        for (int j = 0; j < 8; j++)
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+        crc_table[i] = crc;
+    }
+}
+
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    return -1;
+}
+
+/* Baudot has no '*', so RTTY payloads send '#' before the checksum; habitat
+ * maps it back with PUSH_BAUDOT_HACK */
+static string baudot_hack(string s)
+{
+    replace(s.begin(), s.end(), '#', '*');
+    return s;
+}
+
+/* The sentence without its "$$", and with the checksum after the last '*':
+ * two hex digits are an XOR of the bytes before it, four a CRC16-CCITT */
+static bool checksum_ok(const string &s)
+{
+    string::size_type star = s.rfind('*');
+    if (star == string::npos)
+        return false;
+
+    size_t digits = s.size() - star - 1;
+    if (digits != 2 && digits != 4)
+        return false;
+
+    unsigned int expect = 0;
+    for (size_t i = star + 1; i < s.size(); i++)
+    {
+        int v = hex_value(s[i]);
+        if (v < 0)
+            return false;
+        expect = (expect << 4) | v;
+    }
+
+    const unsigned char *p = (const unsigned char *)s.data();
+
+    if (digits == 2)
+    {
+        unsigned char x = 0;
+        for (size_t i = 0; i < star; i++)
+            x ^= p[i];
+        return x == expect;
+    }
+
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < star; i++)
+        crc = (crc << 8) ^ crc_table[(crc >> 8) ^ p[i]];
+    return crc == expect;
+}
+
+/* Every framed sentence goes to habitat's extractor manager, which parses it
+ * against the payload's configuration (which may use another checksum, or
+ * none) and uploads it; the server judges damaged ones for itself.  The
+ * checksum here only picks the log line. */
+static void finish(int i, stream &s)
+{
+    string sentence = "$$" + s.sentence;
+
+    if (s.damaged)
+        LOG_DEBUG("sentence with bytes lost: %s", sentence.c_str());
+    else if (!checksum_ok(s.baudot ? baudot_hack(s.sentence) : s.sentence))
+        LOG_DEBUG("no XOR or CRC16 checksum: %s", sentence.c_str());
+
+    hbtint::sentence(i - 1, sentence + "\n", s.baudot, s.audio_freq,
+                     s.reversed);
+}
+
+static void process(int i, const rx_byte &b)
+{
+    stream &s = streams[i];
+    char c = b.c;
+
+    if (b.lost && s.st == BODY)
+        s.damaged = true;
+
+    switch (s.st)
+    {
+    case SEARCH:
+        if (c == '$')
+            s.st = DOLLAR;
+        break;
+
+    case DOLLAR:
+        if (c != '$')
+        {
+            s.st = SEARCH;
+            break;
+        }
+        s.st = BODY;
+        s.sentence.clear();
+        s.damaged = false;
+        s.baudot = b.baudot;
+        s.audio_freq = b.audio_freq;
+        s.reversed = b.reversed;
+        break;
+
+    case BODY:
+        if (c == '\n' || c == '\r')
+        {
+            if (!s.sentence.empty())
+                finish(i, s);
+            s.st = SEARCH;
+        }
+        else if (c == '$' && s.sentence.empty())
+        {
+            /* More than two $s to start with */
+        }
+        else if (c == '$' && s.sentence[s.sentence.size() - 1] == '$')
+        {
+            /* A new sentence; this one was cut short */
+            s.sentence.erase(s.sentence.size() - 1);
+            if (!s.sentence.empty())
+                hbtint::bad_sentence(i - 1, "$$" + s.sentence);
+            s.sentence.clear();
+            s.damaged = false;
+            s.audio_freq = b.audio_freq;
+            s.reversed = b.reversed;
+        }
+        else if (s.sentence.size() >= max_sentence)
+        {
+            LOG_DEBUG("sentence too long");
+            hbtint::bad_sentence(i - 1, "$$" + s.sentence);
+            s.st = SEARCH;
+        }
+        else
+        {
+            s.sentence += c;
+        }
+        break;
+    }
+}
+
+static void *run(void *)
+{
+    SET_THREAD_ID(EXTRACT_TID);
+
+    rx_byte in[256];
+
+    pthread_mutex_lock(&mutex);
+
+    while (!quit)
+    {
+        size_t total = 0;
+
+        pthread_mutex_unlock(&mutex);
+        for (int i = 0; i < NUM_STREAMS; i++)
+        {
+            size_t n = streams[i].input->read(in, sizeof(in) / sizeof(*in));
+            for (size_t j = 0; j < n; j++)
+                process(i, in[j]);
+            total += n;
+        }
+        pthread_mutex_lock(&mutex);
+
+        /* The modems don't lock when they signal, so a wakeup can be
+         * missed; never sleep for long */
+        if (total == 0 && !quit)
+            pthread_cond_timedwait_rel(&cond, &mutex, 0.1);
+    }
+
+    pthread_mutex_unlock(&mutex);
+    return NULL;
+}
+
+void init()
+{
+    make_crc_table();
+
+    for (int i = 0; i < NUM_STREAMS; i++)
+    {
+        streams[i].input = new ringbuffer<rx_byte>(4096);
+        streams[i].lost = 0;
+        streams[i].st = SEARCH;
+    }
+}
+
+void start()
+{
+    guard_lock lock(&mutex);
+
+    if (running)
+        return;
+
+    quit = false;
+    if (pthread_create(&thread, NULL, run, NULL) != 0)
+    {
+        LOG_PERROR("pthread_create");
+        return;
+    }
+
+    running = true;
+}
+
+void cleanup()
+{
+    pthread_mutex_lock(&mutex);
+    if (!running)
+    {
+        pthread_mutex_unlock(&mutex);
+        return;
+    }
+    quit = true;
+    pthread_cond_signal(&cond);
+    pthread_mutex_unlock(&mutex);
+
+    pthread_join(thread, NULL);
+    running = false;
+}
+
+void put(unsigned char c, bool baudot)
+{
+    int i = trx_extra_modem() + 1;
+    stream &s = streams[i];
+    modem *m = trx_rx_modem();
+
+    rx_byte b;
+    b.c = c;
+    b.baudot = baudot;
+    b.lost = s.lost;
+    b.audio_freq = m ? m->get_freq() : 0;
+    b.reversed = m ? m->get_reverse() : false;
+
+#if DECODER_MODE
+    s.lost = 0;
+    process(i, b);
+#else
+    if (!s.input)
+        return;
+
+    /* Count the byte as lost if the extractor has fallen behind */
+    if (s.input->write_space() == 0)
+    {
+        s.lost++;
+        return;
+    }
+
+    s.lost = 0;
+    s.input->write(&b, 1);
+
+    /* Wake the thread once there may be a sentence to finish, or the queue
+     * is filling up */
+    if (c == '\n' || c == '\r' ||
+        s.input->write_space() < s.input->length() / 2)
+        pthread_cond_signal(&cond);
+#endif
+}
+
+void skipped(int n)
+{
+    if (n > 0)
+        streams[trx_extra_modem() + 1].lost += n;
+}
+
+} /* namespace extractor */
+} /* namespace dl_fldigi */
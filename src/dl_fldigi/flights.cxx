@@ -41,7 +41,7 @@ static vector<Json::Value> flight_docs, payload_docs;
  * They're invalidated when the relevant vector is modified. When new data is
  * downloaded, the relvant populate_{flights,payloads} function will update
  * these if necessary.
- * hbtint::extrmgr->payload should be called when cur_payload is updated.
+ * hbtint::payload should be called when cur_payload is updated.
  * The data pointed to must not be modified at all while extrmgr has a
  * pointer to it. populate_*'s cleanup actions remove it before modifying. */
 static const Json::Value *cur_flight, *cur_payload, *cur_transmission;
@@ -612,7 +612,7 @@ static void do_select_payload(const Json::Value &payload)
 
     /* Disable stuff, incase tests fail */
     cur_payload = NULL;
-    hbtint::extrmgr->payload(NULL);
+    hbtint::payload(NULL);
 
     if (hab_ui_exists)
     {
@@ -638,7 +638,7 @@ static void do_select_payload(const Json::Value &payload)
 
     /* OK. Setup */
     cur_payload = &payload;
-    hbtint::extrmgr->payload(&payload);
+    hbtint::payload(&payload);
 
     LOG_DEBUG("payload OK, checking transmissions");
 
@@ -35,6 +35,7 @@
 #include "dl_fldigi/dl_fldigi.h"
 #include "dl_fldigi/location.h"
 #include "dl_fldigi/hbtint.h"
+#include "dl_fldigi/station.h"
 
 using namespace std;
 
@@ -187,18 +188,18 @@ void *GPSThread::run()
     return NULL;
 }
 
+/* The GPS thread doesn't take the Fl lock; the UI is updated by the main
+ * thread, from Fl::awake */
 void GPSThread::warning(const string &message)
 {
-    Fl_AutoLock lock;
     LOG_WARN("hbtGPS %s", message.c_str());
 
     string temp = "GPS Error " + message;
-    status_important(temp);
+    post_status(temp, true);
 }
 
 void GPSThread::log(const string &message)
 {
-    Fl_AutoLock lock;
     LOG_DEBUG("hbtGPS %s", message.c_str());
 }
 
@@ -336,51 +337,81 @@ void GPSThread::read()
         throw runtime_error("Failed to parse data (fail)");
     }
 
-    update_ui(time_str, latitude, longitude, altitude);
-    upload(time_str, latitude, longitude, altitude);
+    bool uploaded = upload(time_str, latitude, longitude, altitude);
+    update_ui(time_str, latitude, longitude, altitude, uploaded);
 }
 
-void GPSThread::update_ui(const string &time_str,
-                          double latitude, double longitude, double altitude)
+struct gps_position
 {
+    string time_str;
+    double latitude, longitude, altitude;
+    bool uploaded;
+};
+
+static void show_position(void *arg)
+{
+    gps_position *p = static_cast<gps_position *>(arg);
+
+    if (dl_fldigi::shutting_down)
+    {
+        delete p;
+        return;
+    }
+
     ostringstream lat_tmp, lon_tmp, alt_tmp;
-	lat_tmp << latitude;
-    lon_tmp << longitude;
-    alt_tmp << altitude;
+    lat_tmp << p->latitude;
+    lon_tmp << p->longitude;
+    alt_tmp << p->altitude;
 
-    gps_pos_time->value(time_str.c_str());
+    gps_pos_time->value(p->time_str.c_str());
     gps_pos_lat->value(lat_tmp.str().c_str());
     gps_pos_lon->value(lon_tmp.str().c_str());
     gps_pos_altitude->value(alt_tmp.str().c_str());
 
     gps_pos_save->activate();
+
+    /* Keep the position we last uploaded */
+    if (p->uploaded)
+    {
+        location::listener_valid = true;
+        location::listener_latitude = p->latitude;
+        location::listener_longitude = p->longitude;
+        location::listener_altitude = p->altitude;
+        location::update_distance_bearing();
+    }
+
+    delete p;
 }
 
-void GPSThread::upload(const string &time_str,
-                       double latitude, double longitude, double altitude)
+void GPSThread::update_ui(const string &time_str,
+                          double latitude, double longitude, double altitude,
+                          bool uploaded)
 {
-    Fl_AutoLock lock;
+    gps_position *p = new gps_position;
+    p->time_str = time_str;
+    p->latitude = latitude;
+    p->longitude = longitude;
+    p->altitude = altitude;
+    p->uploaded = uploaded;
+    if (Fl::awake(show_position, p) != 0)
+        delete p;
+}
 
+bool GPSThread::upload(const string &time_str,
+                       double latitude, double longitude, double altitude)
+{
     LOG_DEBUG("GPS position: %s %f %f, %fM",
               time_str.c_str(), latitude, longitude, altitude);
 
     if (time(NULL) - last_upload < rate)
-        return;
+        return false;
 
     /* Data OK? upload. */
-    if (location::current_location_mode != location::LOC_GPS)
+    if (station::get().location_mode != location::LOC_GPS)
         throw runtime_error("GPS mode disabled mid-line");
 
     last_upload = time(NULL);
 
-    location::listener_valid = true;
-    location::listener_latitude = latitude;
-    location::listener_longitude = longitude;
-    location::listener_altitude = altitude;
-    location::update_distance_bearing();
-
-    ostringstream temp;
-
     Json::Value data(Json::objectValue);
     // data["time"] = time_str;
     data["latitude"] = latitude;
@@ -389,6 +420,7 @@ void GPSThread::upload(const string &time_str,
     data["chase"] = true;
 
     hbtint::uthr->listener_telemetry(data);
+    return true;
 }
 
 #ifndef __MINGW32__
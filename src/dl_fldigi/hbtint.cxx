@@ -25,57 +25,174 @@
 #include "dl_fldigi/version.h"
 #include "dl_fldigi/location.h"
 #include "dl_fldigi/flights.h"
+#include "dl_fldigi/extractor.h"
+#include "dl_fldigi/spool.h"
+#include "dl_fldigi/station.h"
+
+#if DECODER_MODE
+#  include "decoder.h"
+#endif
 
 using namespace std;
 
 namespace dl_fldigi {
 namespace hbtint {
 
+#if !DECODER_MODE
 static EZ::cURLGlobal *cgl;
+#else
+/* dl-fldigi-decode uploads nothing: its extractor managers are given an
+ * uploader that is never started, and that drops the telemetry */
+class DDiscardUploader : public habitat::UploaderThread
+{
+public:
+    void payload_telemetry(const string &data,
+                           const Json::Value &metadata=Json::Value::null,
+                           int time_created=-1) {}
+};
+static DDiscardUploader *discard;
+#endif
 DExtractorManager *extrmgr;
 DUploaderThread *uthr;
 static habitat::UKHASExtractor *ukhas;
+static DExtractorManager *extra_extrmgr[NUM_EXTRA_MODEMS];
+static habitat::UKHASExtractor *extra_ukhas[NUM_EXTRA_MODEMS];
 
 static EZ::Mutex rig_mutex;
 static time_t rig_freq_updated, rig_mode_updated;
 static long long rig_freq;
 static string rig_mode;
 
+/* The extractor managers are used by the extractor thread, and given
+ * payload configuration by the main thread. Whilst a sentence is being
+ * pushed, its audio frequency is kept for payload_telemetry() */
+static EZ::Mutex extr_mutex;
+static int sentence_freq;
+static bool sentence_reversed;
+
 void init()
 {
+#if !DECODER_MODE
     cgl = new EZ::cURLGlobal();
 
     uthr = new DUploaderThread();
-    extrmgr = new DExtractorManager(*uthr);
+    habitat::UploaderThread &u = *uthr;
+#else
+    discard = new DDiscardUploader();
+    habitat::UploaderThread &u = *discard;
+#endif
+
+    extrmgr = new DExtractorManager(u);
 
     ukhas = new habitat::UKHASExtractor();
     extrmgr->add(*ukhas);
+
+    for (int i = 0; i < NUM_EXTRA_MODEMS; i++)
+    {
+        extra_extrmgr[i] = new DExtractorManager(u);
+        extra_ukhas[i] = new habitat::UKHASExtractor();
+        extra_extrmgr[i]->add(*extra_ukhas[i]);
+    }
+
+    extractor::init();
+}
+
+static DExtractorManager *manager(int modem)
+{
+    return modem < 0 ? extrmgr : extra_extrmgr[modem];
+}
+
+void sentence(int modem, const string &s, bool baudot, int audio_freq,
+              bool reversed)
+{
+    EZ::MutexLock lock(extr_mutex);
+    DExtractorManager *m = manager(modem);
+
+    if (!m)
+        return;
+
+    sentence_freq = audio_freq;
+    sentence_reversed = reversed;
+
+    for (string::const_iterator i = s.begin(); i != s.end(); ++i)
+    {
+        if (baudot)
+            m->push(*i, habitat::PUSH_BAUDOT_HACK);
+        else
+            m->push(*i);
+    }
+}
+
+void bad_sentence(int modem, const string &s)
+{
+    EZ::MutexLock lock(extr_mutex);
+    DExtractorManager *m = manager(modem);
+
+    if (!m)
+        return;
+
+    Json::Value data(Json::objectValue);
+    data["_sentence"] = s;
+    data["_parsed"] = false;
+    m->data(data);
+}
+
+void payload(const Json::Value *data)
+{
+    EZ::MutexLock lock(extr_mutex);
+
+    extrmgr->payload(data);
+    for (int i = 0; i < NUM_EXTRA_MODEMS; i++)
+        extra_extrmgr[i]->payload(data);
 }
 
 void start()
 {
+    extractor::start();
+#if !DECODER_MODE
+    spool::start();
     uthr->start();
+#endif
 }
 
 void cleanup()
 {
+    extractor::cleanup();
+
     delete extrmgr;
     delete ukhas;
 
     extrmgr = 0;
     ukhas = 0;
 
-    /* This prevents deadlocks with our use of Fl::lock in the uploader
-     * thread (which is a necessary evil since we're accessing loads of
-     * global fldigi stuff) */
+    for (int i = 0; i < NUM_EXTRA_MODEMS; i++)
+    {
+        delete extra_extrmgr[i];
+        delete extra_ukhas[i];
+        extra_extrmgr[i] = 0;
+        extra_ukhas[i] = 0;
+    }
+
+#if !DECODER_MODE
+    spool::cleanup();
+
+    /* The uploader thread never takes the Fl lock, so we can just wait
+     * for it. Anything it has left for the main thread is dropped, since
+     * shutting_down is set */
     if (uthr)
+    {
         uthr->shutdown();
-
-    while (uthr)
-        Fl::wait();
+        uthr->join();
+        delete uthr;
+        uthr = 0;
+    }
 
     delete cgl;
     cgl = 0;
+#else
+    delete discard;
+    discard = 0;
+#endif
 }
 
 void rig_set_freq(long long freq)
@@ -92,28 +209,7 @@ void rig_set_mode(const string &mode)
     rig_mode = mode;
 }
 
-static void uthr_thread_death(void *what)
-{
-    if (what != uthr)
-    {
-        LOG_ERROR("unknown thread");
-        return;
-    }
-
-    LOG_INFO("cleaning up");
-    uthr->join();
-    delete uthr;
-    uthr = 0;
-}
-
-/* Modify run() to help us shutdown the thread */
-void *DUploaderThread::run()
-{
-    void *ret = UploaderThread::run();
-    Fl::awake(uthr_thread_death, this);
-    return ret;
-}
-
+#if !DECODER_MODE
 /* Some functions below are called via a DUploaderThread pointer so
  * the fact that they are non virtual is OK. Having a different set of
  * arguments even prevents the wrong function from being selected.
@@ -122,48 +218,52 @@ void *DUploaderThread::run()
 
 void DUploaderThread::settings()
 {
-    Fl_AutoLock lock;
+    const station::snapshot &s = station::get();
 
     UploaderThread::reset();
+    spool::reset();
 
-    if (!online())
+    if (!s.online)
     {
         warning("upload disabled: offline");
         return;
     }
 
-    if (!progdefaults.myCall.size() || !progdefaults.habitat_uri.size() ||
-        !progdefaults.habitat_db.size())
+    if (!s.callsign.size() || !s.habitat_uri.size() || !s.habitat_db.size())
     {
         warning("upload disabled: settings missing");
         return;
     }
 
-    UploaderThread::settings(progdefaults.myCall, progdefaults.habitat_uri,
-                             progdefaults.habitat_db);
+    UploaderThread::settings(s.callsign, s.habitat_uri, s.habitat_db);
+    spool::settings(s.callsign, s.habitat_uri, s.habitat_db);
 }
 
 void DUploaderThread::payload_telemetry(const string &data,
         const Json::Value &metadata, int time_created)
 {
-    Fl_AutoLock lock;
-
     /* If the frequency/mode from the rig is recent, upload it.
      * null metadata is automatically converted to an object by jsoncpp */
 
     Json::Value rig_info(Json::objectValue);
-    
-    if (rig_freq_updated >= time(NULL) - 30)
-        rig_info["frequency"] = rig_freq;
-    if (rig_mode_updated >= time(NULL) - 30)
-        rig_info["mode"] = rig_mode;
-    rig_info["audio_frequency"] = active_modem->get_freq();
-    rig_info["reversed"] = active_modem->get_reverse();
+
+    {
+        EZ::MutexLock lock(rig_mutex);
+        if (rig_freq_updated >= time(NULL) - 30)
+            rig_info["frequency"] = rig_freq;
+        if (rig_mode_updated >= time(NULL) - 30)
+            rig_info["mode"] = rig_mode;
+    }
+
+    /* From the modem that received the sentence; see sentence() */
+    rig_info["audio_frequency"] = sentence_freq;
+    rig_info["reversed"] = sentence_reversed;
 
     Json::Value new_metadata = metadata;
     new_metadata["rig_info"] = rig_info;
 
-    UploaderThread::payload_telemetry(data, new_metadata, time_created);
+    /* Spooled, and uploaded in batches by spool.cxx */
+    spool::payload_telemetry(data, new_metadata, time_created);
 }
 
 
@@ -192,18 +292,16 @@ void DUploaderThread::listener_telemetry()
     if (location::listener_altitude != 0)
         data["altitude"] = location::listener_altitude;
 
-    UploaderThread::listener_telemetry(data);
+    spool::listener_doc("listener_telemetry", data);
 }
 
 void DUploaderThread::listener_telemetry(const Json::Value &data)
 {
-    Fl_AutoLock lock;
-
-    if (location::current_location_mode != location::LOC_GPS)
+    if (station::get().location_mode != location::LOC_GPS)
         throw runtime_error("Attempted to upload GPS data while not "
                             "in GPS mode");
 
-    UploaderThread::listener_telemetry(data);
+    spool::listener_doc("listener_telemetry", data);
 }
 
 static void info_add(Json::Value &data, const string &key, const string &value)
@@ -223,36 +321,57 @@ void DUploaderThread::listener_information()
     info_add(data, "antenna", progdefaults.myAntenna);
     data["dl_fldigi"] = git_short_commit;
 
-    UploaderThread::listener_information(data);
+    spool::listener_doc("listener_information", data);
 }
 
-/* These functions absolutely must be thread safe. */
+/* These functions absolutely must be thread safe, and must not take the
+ * Fl lock (see cleanup()): anything for the UI is passed to the main
+ * thread with Fl::awake. */
+
 void DUploaderThread::log(const string &message)
 {
-    Fl_AutoLock lock;
     LOG_DEBUG("hbtUT %s", message.c_str());
 }
 
 void DUploaderThread::warning(const string &message)
 {
-    Fl_AutoLock lock;
     LOG_WARN("hbtUT %s", message.c_str());
-    status_important(message);
+    post_status(message, true);
 }
 
 void DUploaderThread::caught_exception(const habitat::NotInitialisedError &e)
 {
-    Fl_AutoLock lock;
     LOG_WARN("NotInitialisedError");
-    status_important("Can't upload! Either in offline mode, or "
-                        "your callsign is not set.");
+    post_status("Can't upload! Either in offline mode, or "
+                "your callsign is not set.", true);
 }
 
 void DUploaderThread::saved_id(const string &type, const string &id)
 {
     /* Log as normal, but also set status */
     UploaderThread::saved_id(type, id);
-    status("Uploaded " + type + " successfully");
+    post_status("Uploaded " + type + " successfully");
+}
+
+struct ui_docs
+{
+    vector<Json::Value> docs;
+    bool payloads;
+};
+
+static void show_docs(void *arg)
+{
+    ui_docs *d = static_cast<ui_docs *>(arg);
+
+    if (!shutting_down)
+    {
+        if (d->payloads)
+            flights::new_payload_docs(d->docs);
+        else
+            flights::new_flight_docs(d->docs);
+    }
+
+    delete d;
 }
 
 void DUploaderThread::got_flights(const vector<Json::Value> &new_flights)
@@ -261,7 +380,11 @@ void DUploaderThread::got_flights(const vector<Json::Value> &new_flights)
     ltmp << "Downloaded " << new_flights.size() << " flight docs";
     log(ltmp.str());
 
-    flights::new_flight_docs(new_flights);
+    ui_docs *d = new ui_docs;
+    d->docs = new_flights;
+    d->payloads = false;
+    if (Fl::awake(show_docs, d) != 0)
+        delete d;
 }
 
 void DUploaderThread::got_payloads(const vector<Json::Value> &new_payloads)
@@ -270,16 +393,21 @@ void DUploaderThread::got_payloads(const vector<Json::Value> &new_payloads)
     ltmp << "Downloaded " << new_payloads.size() << " payload docs";
     log(ltmp.str());
 
-    flights::new_payload_docs(new_payloads);
+    ui_docs *d = new ui_docs;
+    d->docs = new_payloads;
+    d->payloads = true;
+    if (Fl::awake(show_docs, d) != 0)
+        delete d;
 }
+#endif // !DECODER_MODE
 
 /* Be careful not to call this function instead of dl_fldigi::status() */
 void DExtractorManager::status(const string &msg)
 {
-    Fl_AutoLock lock;
     LOG_DEBUG("hbtE %s", msg.c_str());
 }
 
+#if !DECODER_MODE
 static void set_jvalue(Fl_Output *widget, const Json::Value &value)
 {
     if (value.isString())
@@ -314,13 +442,8 @@ static void set_jvalue(Fl_Output *widget, const Json::Value &value)
     }
 }
 
-void DExtractorManager::data(const Json::Value &d)
+static void update_ui(const Json::Value &d)
 {
-    Fl_AutoLock lock;
-
-    if (!hab_ui_exists)
-        return;
-
     if (d["_sentence"].isString())
     {
         string clean = d["_sentence"].asString();
@@ -388,5 +511,31 @@ void DExtractorManager::data(const Json::Value &d)
     location::update_distance_bearing();
 }
 
+static void show_data(void *arg)
+{
+    Json::Value *d = static_cast<Json::Value *>(arg);
+
+    if (!shutting_down)
+        update_ui(*d);
+
+    delete d;
+}
+#endif // !DECODER_MODE
+
+void DExtractorManager::data(const Json::Value &d)
+{
+#if DECODER_MODE
+    decoder_put_telemetry(d);
+#else
+    if (!hab_ui_exists)
+        return;
+
+    /* We're on the modem's thread */
+    Json::Value *v = new Json::Value(d);
+    if (Fl::awake(show_data, v) != 0)
+        delete v;
+#endif
+}
+
 } /* namespace hbtint */
 } /* namespace dl_fldigi */
@@ -16,6 +16,7 @@
 
 #include "dl_fldigi/dl_fldigi.h"
 #include "dl_fldigi/gps.h"
+#include "dl_fldigi/station.h"
 
 using namespace std;
 
@@ -34,6 +35,7 @@ void start()
     else
         current_location_mode = LOC_STATIONARY;
 
+    station::publish();
     gps::configure_gps();
 }
 
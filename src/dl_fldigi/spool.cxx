@@ -0,0 +1,639 @@
+/*
+ * License: GNU GPL 3
+ *
+ * spool.cxx: Disk backed, batched uploads of habitat documents
+ */
+
+#include "dl_fldigi/spool.h"
+
+#include <string>
+#include <sstream>
+#include <deque>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <curl/curl.h>
+#include <openssl/sha.h>
+
+#include "base64.h"
+#include "debug.h"
+#include "main.h"
+#include "threads.h"
+#include "timeops.h"
+
+#include "habitat/RFC3339.h"
+
+#include "dl_fldigi/dl_fldigi.h"
+
+using namespace std;
+
+namespace dl_fldigi {
+namespace spool {
+
+enum result { SENT, RETRY, REFUSED };
+
+struct transfer
+{
+    CURL *curl;
+    struct curl_slist *headers;
+    string url, body, response;
+    bool bulk;
+    size_t index;
+};
+
+static const size_t max_queue = 5000;
+static const size_t batch_size = 50;
+static const size_t max_transfers = 4;
+static const long transfer_timeout = 30;
+static const double min_backoff = 2.0, max_backoff = 300.0;
+
+static pthread_t thread;
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+
+/* Guarded by mutex. The first `sending' documents of the queue are the
+ * batch being uploaded. */
+static bool running, quit, configured;
+static string callsign, database;
+static deque<Json::Value> queue;
+static size_t sending, dropped;
+static unsigned int id_seq;
+
+/* One document per line, as JSON.  Documents are only ever appended; the
+ * file is emptied when the queue is, and otherwise compacted once it holds
+ * twice as many lines as there are documents queued.  After a crash some
+ * documents may be sent again, which habitat takes as a conflict or as the
+ * same listener added again. */
+static string spool_name;
+static FILE *spool;
+static size_t spooled;
+
+static string hex(const unsigned char *d, size_t len)
+{
+    static const char digits[] = "0123456789abcdef";
+    string s;
+
+    s.reserve(len * 2);
+    for (size_t i = 0; i < len; i++)
+    {
+        s += digits[d[i] >> 4];
+        s += digits[d[i] & 0xF];
+    }
+
+    return s;
+}
+
+static string sha256hex(const string &s)
+{
+    unsigned char md[SHA256_DIGEST_LENGTH];
+    SHA256((const unsigned char *)s.data(), s.size(), md);
+    return hex(md, sizeof(md));
+}
+
+/* habitat wants the raw sentence without line breaks */
+static string raw_base64(const string &s)
+{
+    string r;
+    int iostatus = 0;
+    base64<char> encoder;
+    back_insert_iterator<string> ins = back_inserter(r);
+
+    encoder.put(s.begin(), s.end(), ins, iostatus, base64<>::noline());
+
+    r.erase(remove(r.begin(), r.end(), '\n'), r.end());
+    return r;
+}
+
+static string rfc3339(time_t t)
+{
+    return RFC3339::timestamp_to_rfc3339_localoffset(t);
+}
+
+static void spool_write(const Json::Value &doc)
+{
+    if (!spool)
+        return;
+
+    Json::FastWriter writer;
+    fputs(writer.write(doc).c_str(), spool);
+    fflush(spool);
+    spooled++;
+}
+
+static void spool_rewrite()
+{
+    if (spool)
+        fclose(spool);
+
+    spool = fopen(spool_name.c_str(), "w");
+    if (!spool)
+    {
+        LOG_ERROR("Could not open %s: %s", spool_name.c_str(),
+                  strerror(errno));
+        return;
+    }
+
+    spooled = 0;
+    for (deque<Json::Value>::const_iterator i = queue.begin();
+         i != queue.end(); ++i)
+        spool_write(*i);
+}
+
+/* Called after each batch, with what is left in the queue */
+static void spool_trim()
+{
+    if (!spool)
+        return;
+
+    if (queue.empty())
+    {
+        if (ftruncate(fileno(spool), 0) != 0)
+        {
+            LOG_ERROR("Could not truncate %s: %s", spool_name.c_str(),
+                      strerror(errno));
+            spool_rewrite();
+            return;
+        }
+        rewind(spool);
+        spooled = 0;
+    }
+    else if (spooled >= 2 * queue.size())
+    {
+        spool_rewrite();
+    }
+}
+
+static void push(const Json::Value &doc)
+{
+    /* Make room by dropping the oldest document not being sent */
+    if (queue.size() >= max_queue && queue.size() > sending)
+    {
+        queue.erase(queue.begin() + sending);
+        if (dropped++ == 0)
+            LOG_WARN("habitat spool full, dropping the oldest documents");
+    }
+
+    queue.push_back(doc);
+}
+
+static void spool_load()
+{
+    FILE *f = fopen(spool_name.c_str(), "r");
+    if (!f)
+        return;
+
+    Json::Reader reader;
+    string line;
+    char buf[1024];
+
+    while (fgets(buf, sizeof(buf), f))
+    {
+        line += buf;
+        if (line.empty() || line[line.size() - 1] != '\n')
+            continue;
+
+        Json::Value doc;
+        if (reader.parse(line, doc, false) && doc.isObject() &&
+            doc["type"].isString())
+            push(doc);
+        line.clear();
+    }
+
+    fclose(f);
+
+    if (!queue.empty())
+        LOG_INFO("%u habitat documents waiting to be uploaded",
+                 (unsigned)queue.size());
+}
+
+static void enqueue(const Json::Value &doc)
+{
+    guard_lock lock(&mutex);
+
+    if (!running)
+    {
+        LOG_WARN("habitat uploads not started, dropping %s",
+                 doc["type"].asCString());
+        return;
+    }
+
+    push(doc);
+    spool_write(doc);
+    pthread_cond_signal(&cond);
+}
+
+void payload_telemetry(const string &data, const Json::Value &metadata,
+                       int time_created)
+{
+    Json::Value doc(Json::objectValue);
+
+    doc["type"] = "payload_telemetry";
+    doc["data"] = data;
+    doc["metadata"] = metadata;
+    doc["time_created"] = (time_created == -1 ? (int)time(NULL) :
+                           time_created);
+
+    enqueue(doc);
+}
+
+void listener_doc(const string &type, const Json::Value &data,
+                  int time_created)
+{
+    Json::Value doc(Json::objectValue);
+
+    doc["type"] = type;
+    doc["data"] = data;
+    doc["time_created"] = (time_created == -1 ? (int)time(NULL) :
+                           time_created);
+
+    /* A fixed _id makes sending the document again harmless */
+    Json::FastWriter writer;
+    ostringstream seed;
+    {
+        guard_lock lock(&mutex);
+        seed << writer.write(doc) << time(NULL) << ' ' << getpid() << ' '
+             << id_seq++;
+    }
+    doc["_id"] = sha256hex(seed.str()).substr(0, 32);
+
+    enqueue(doc);
+}
+
+static size_t write_response(void *ptr, size_t size, size_t nmemb,
+                             void *userdata)
+{
+    static_cast<string *>(userdata)->append((const char *)ptr,
+                                             size * nmemb);
+    return size * nmemb;
+}
+
+static void setup(transfer &t)
+{
+    t.curl = curl_easy_init();
+    t.headers = curl_slist_append(NULL, "Content-Type: application/json");
+    if (!t.curl)
+        return;
+
+    curl_easy_setopt(t.curl, CURLOPT_URL, t.url.c_str());
+    curl_easy_setopt(t.curl, CURLOPT_HTTPHEADER, t.headers);
+    curl_easy_setopt(t.curl, CURLOPT_POSTFIELDS, t.body.c_str());
+    curl_easy_setopt(t.curl, CURLOPT_POSTFIELDSIZE, (long)t.body.size());
+    if (!t.bulk)
+        curl_easy_setopt(t.curl, CURLOPT_CUSTOMREQUEST, "PUT");
+    curl_easy_setopt(t.curl, CURLOPT_WRITEFUNCTION, write_response);
+    curl_easy_setopt(t.curl, CURLOPT_WRITEDATA, &t.response);
+    curl_easy_setopt(t.curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(t.curl, CURLOPT_TIMEOUT, transfer_timeout);
+}
+
+/* Reads the outcome of one finished transfer into results */
+static void finished(transfer &t, CURLcode r, const vector<Json::Value> &batch,
+                     vector<result> &results)
+{
+    long code = 0;
+
+    if (r != CURLE_OK)
+    {
+        LOG_WARN("habitat upload failed: %s", curl_easy_strerror(r));
+        return;
+    }
+
+    curl_easy_getinfo(t.curl, CURLINFO_RESPONSE_CODE, &code);
+
+    if (!t.bulk)
+    {
+        if (code >= 200 && code < 300)
+            results[t.index] = SENT;
+        /* 409 means another listener's upload got there first */
+        else if (code >= 400 && code < 500 && code != 408 && code != 409 &&
+                 code != 429)
+        {
+            LOG_WARN("habitat refused payload_telemetry: HTTP %ld %s",
+                     code, t.response.c_str());
+            results[t.index] = REFUSED;
+        }
+        else
+            LOG_WARN("habitat upload failed: HTTP %ld", code);
+        return;
+    }
+
+    if (code < 200 || code >= 300)
+    {
+        LOG_WARN("habitat bulk upload failed: HTTP %ld", code);
+        return;
+    }
+
+    /* One entry per document, each either saved or with an error. A
+     * conflict means an earlier attempt saved it. */
+    Json::Reader reader;
+    Json::Value reply;
+    if (!reader.parse(t.response, reply, false) || !reply.isArray())
+    {
+        LOG_WARN("habitat bulk upload: bad reply");
+        return;
+    }
+
+    for (Json::Value::ArrayIndex i = 0; i < reply.size(); i++)
+    {
+        const Json::Value &item = reply[i];
+        const string id = item["id"].asString();
+
+        for (size_t j = 0; j < batch.size(); j++)
+        {
+            if (batch[j]["_id"].asString() != id ||
+                batch[j]["type"].asString() == "payload_telemetry")
+                continue;
+
+            if (!item.isMember("error") || item["error"].asString() == "conflict")
+            {
+                results[j] = SENT;
+            }
+            else
+            {
+                LOG_WARN("habitat refused %s: %s",
+                         batch[j]["type"].asCString(),
+                         item["reason"].asString().c_str());
+                results[j] = REFUSED;
+            }
+            break;
+        }
+    }
+}
+
+static void send_batch(CURLM *multi, const string &base, const string &call,
+                       const vector<Json::Value> &batch,
+                       vector<result> &results)
+{
+    Json::FastWriter writer;
+    vector<transfer> transfers;
+    Json::Value bulk(Json::objectValue);
+    const string now = rfc3339(time(NULL));
+
+    bulk["docs"] = Json::Value(Json::arrayValue);
+
+    for (size_t i = 0; i < batch.size(); i++)
+    {
+        const Json::Value &doc = batch[i];
+        const string created = rfc3339(doc["time_created"].asInt());
+
+        if (doc["type"].asString() != "payload_telemetry")
+        {
+            Json::Value d(Json::objectValue);
+            d["_id"] = doc["_id"];
+            d["type"] = doc["type"];
+            d["time_created"] = created;
+            d["time_uploaded"] = now;
+            d["data"] = doc["data"];
+            d["data"]["callsign"] = call;
+            bulk["docs"].append(d);
+            continue;
+        }
+
+        /* As habitat::Uploader::payload_telemetry() */
+        const string raw = raw_base64(doc["data"].asString());
+
+        Json::Value receiver(Json::objectValue);
+        const Json::Value &metadata = doc["metadata"];
+        if (metadata.isObject())
+        {
+            Json::Value::Members keys = metadata.getMemberNames();
+            for (size_t k = 0; k < keys.size(); k++)
+                if (keys[k].size() && keys[k][0] != '_')
+                    receiver[keys[k]] = metadata[keys[k]];
+        }
+        receiver["time_created"] = created;
+        receiver["time_uploaded"] = now;
+
+        Json::Value body(Json::objectValue);
+        body["data"]["_raw"] = raw;
+        body["receivers"][call] = receiver;
+
+        transfer t;
+        t.url = base + "_design/payload_telemetry/_update/add_listener/" +
+                sha256hex(raw);
+        t.body = writer.write(body);
+        t.bulk = false;
+        t.index = i;
+        transfers.push_back(t);
+    }
+
+    if (bulk["docs"].size())
+    {
+        transfer t;
+        t.url = base + "_bulk_docs";
+        t.body = writer.write(bulk);
+        t.bulk = true;
+        t.index = 0;
+        transfers.push_back(t);
+    }
+
+    /* Run up to max_transfers at once; the multi handle keeps the
+     * connections for the next batch */
+    size_t next = 0, active = 0;
+    bool stop = false;
+
+    while (active || (next < transfers.size() && !stop))
+    {
+        while (!stop && active < max_transfers && next < transfers.size())
+        {
+            transfer &t = transfers[next++];
+            setup(t);
+            if (t.curl && curl_multi_add_handle(multi, t.curl) == CURLM_OK)
+                active++;
+        }
+
+        int still_running;
+        curl_multi_perform(multi, &still_running);
+        curl_multi_wait(multi, NULL, 0, 250, NULL);
+        curl_multi_perform(multi, &still_running);
+
+        CURLMsg *msg;
+        int left;
+        while ((msg = curl_multi_info_read(multi, &left)))
+        {
+            if (msg->msg != CURLMSG_DONE)
+                continue;
+
+            CURL *curl = msg->easy_handle;
+            CURLcode r = msg->data.result;
+
+            for (size_t i = 0; i < next; i++)
+            {
+                if (transfers[i].curl != curl)
+                    continue;
+                curl_multi_remove_handle(multi, curl);
+                finished(transfers[i], r, batch, results);
+                curl_easy_cleanup(curl);
+                transfers[i].curl = NULL;
+                active--;
+                break;
+            }
+        }
+
+        /* Leave the rest for next time if shutting down */
+        guard_lock lock(&mutex);
+        stop = quit;
+        if (stop)
+            break;
+    }
+
+    for (size_t i = 0; i < transfers.size(); i++)
+    {
+        if (transfers[i].curl)
+        {
+            curl_multi_remove_handle(multi, transfers[i].curl);
+            curl_easy_cleanup(transfers[i].curl);
+        }
+        curl_slist_free_all(transfers[i].headers);
+    }
+}
+
+static void *run(void *)
+{
+    CURLM *multi = curl_multi_init();
+    double backoff = 0.0;
+    struct timespec retry_at = {0, 0}, now;
+
+    pthread_mutex_lock(&mutex);
+
+    while (!quit)
+    {
+        clock_gettime(CLOCK_REALTIME, &now);
+        bool waiting = retry_at > now;
+
+        if (!multi || queue.empty() || !configured || waiting)
+        {
+            if (multi && configured && waiting && !queue.empty())
+                pthread_cond_timedwait(&cond, &mutex, &retry_at);
+            else
+                pthread_cond_wait(&cond, &mutex);
+            continue;
+        }
+
+        sending = min(batch_size, queue.size());
+        vector<Json::Value> batch(queue.begin(), queue.begin() + sending);
+        vector<result> results(sending, RETRY);
+        string base = database, call = callsign;
+
+        pthread_mutex_unlock(&mutex);
+        send_batch(multi, base, call, batch, results);
+        pthread_mutex_lock(&mutex);
+
+        /* Put back what has to be sent again, in order */
+        size_t sent = 0, retry = 0;
+        for (size_t i = sending; i-- > 0; )
+        {
+            if (results[i] == SENT)
+                sent++;
+            if (results[i] == RETRY)
+            {
+                queue[sending - 1 - retry] = batch[i];
+                retry++;
+            }
+        }
+        queue.erase(queue.begin(), queue.begin() + (sending - retry));
+        sending = 0;
+
+        spool_trim();
+
+        if (retry)
+        {
+            clock_gettime(CLOCK_REALTIME, &now);
+            backoff = backoff ? backoff * 2 : min_backoff;
+            if (backoff > max_backoff)
+                backoff = max_backoff;
+            retry_at = now + backoff;
+        }
+        else
+        {
+            backoff = 0.0;
+        }
+
+        if (sent)
+        {
+            ostringstream msg;
+            msg << "Uploaded " << sent << " document" <<
+                   (sent == 1 ? "" : "s") << " successfully";
+            post_status(msg.str());
+        }
+    }
+
+    pthread_mutex_unlock(&mutex);
+
+    if (multi)
+        curl_multi_cleanup(multi);
+
+    return NULL;
+}
+
+void start()
+{
+    guard_lock lock(&mutex);
+
+    if (running)
+        return;
+
+    spool_name = HomeDir + "habitat_spool.json";
+    spool_load();
+    spool_rewrite();
+
+    quit = false;
+    if (pthread_create(&thread, NULL, run, NULL) != 0)
+    {
+        LOG_PERROR("pthread_create");
+        return;
+    }
+
+    running = true;
+}
+
+void cleanup()
+{
+    pthread_mutex_lock(&mutex);
+    if (!running)
+    {
+        pthread_mutex_unlock(&mutex);
+        return;
+    }
+    quit = true;
+    pthread_cond_signal(&cond);
+    pthread_mutex_unlock(&mutex);
+
+    pthread_join(thread, NULL);
+
+    guard_lock lock(&mutex);
+    running = false;
+    if (spool)
+        fclose(spool);
+    spool = NULL;
+}
+
+void settings(const string &new_callsign, const string &couch_uri,
+              const string &couch_db)
+{
+    guard_lock lock(&mutex);
+
+    callsign = new_callsign;
+    database = couch_uri;
+    if (database.empty() || database[database.size() - 1] != '/')
+        database += '/';
+    database += couch_db + '/';
+    configured = true;
+    pthread_cond_signal(&cond);
+}
+
+void reset()
+{
+    guard_lock lock(&mutex);
+    configured = false;
+}
+
+} /* namespace spool */
+} /* namespace dl_fldigi */
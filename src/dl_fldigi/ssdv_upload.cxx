@@ -0,0 +1,448 @@
+/*
+ * License: GNU GPL 3
+ *
+ * ssdv_upload.cxx: Pooled SSDV packet uploads, spooled to disk
+ */
+
+#include "dl_fldigi/ssdv_upload.h"
+
+#include <string>
+#include <deque>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include <curl/curl.h>
+
+#include "debug.h"
+#include "main.h"
+#include "threads.h"
+#include "timeops.h"
+#include "ssdv.h"
+
+#include "dl_fldigi/station.h"
+
+using namespace std;
+
+namespace dl_fldigi {
+namespace ssdv_upload {
+
+/* TODO: HABITAT-LATER upload using habitat */
+
+struct item
+{
+    string callsign;
+    int fixes;
+    string hex;
+};
+
+struct transfer
+{
+    CURL *curl;
+    struct curl_httppost *form;
+    bool busy;
+    item it;
+};
+
+static const size_t max_queue = 8192;
+static const int max_transfers = 4;
+static const long transfer_timeout = 30;
+static const double min_backoff = 1.0, max_backoff = 300.0;
+
+static pthread_t thread;
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+
+/* Guarded by mutex */
+static bool running, quit, is_online;
+static string url;
+static deque<item> queue;
+static size_t dropped;
+
+/* The spool holds one line per packet, "fixes hex callsign". Packets are
+ * appended as they are queued, and the file is emptied once everything
+ * in it has been sent, or cut down to what is still queued when it grows
+ * to twice max_queue lines; a crash may send a few packets twice. */
+static string spool_name;
+static FILE *spool;
+static size_t spool_lines;
+
+static void spool_write(const item &it)
+{
+    if (!spool)
+        return;
+
+    fprintf(spool, "%d %s %s\n", it.fixes, it.hex.c_str(),
+            it.callsign.c_str());
+    fflush(spool);
+    spool_lines++;
+}
+
+static void push(const item &it)
+{
+    if (queue.size() >= max_queue)
+    {
+        queue.pop_front();
+        if (dropped++ == 0)
+            LOG_WARN("SSDV upload queue full, dropping the oldest packets");
+    }
+
+    queue.push_back(it);
+}
+
+static void spool_load()
+{
+    FILE *f = fopen(spool_name.c_str(), "r");
+    if (!f)
+        return;
+
+    char line[SSDV_PKT_SIZE * 2 + 128];
+    while (fgets(line, sizeof(line), f))
+    {
+        item it;
+        char *p = line, *end;
+
+        it.fixes = strtol(p, &end, 10);
+        if (end == p || *end != ' ')
+            continue;
+
+        p = end + 1;
+        end = strchr(p, ' ');
+        if (!end || end - p != SSDV_PKT_SIZE * 2)
+            continue;
+        it.hex.assign(p, end - p);
+
+        it.callsign = end + 1;
+        string::size_type nl = it.callsign.find_first_of("\r\n");
+        if (nl != string::npos)
+            it.callsign.erase(nl);
+
+        push(it);
+        spool_lines++;
+    }
+
+    fclose(f);
+
+    if (!queue.empty())
+        LOG_INFO("%u SSDV packets waiting to be uploaded",
+                 (unsigned)queue.size());
+}
+
+/* Replaces the spool with what is queued and in flight */
+static void spool_rewrite(const transfer *transfers)
+{
+    if (spool)
+        fclose(spool);
+
+    spool_lines = 0;
+    spool = fopen(spool_name.c_str(), "w");
+    if (!spool)
+    {
+        LOG_ERROR("Could not open %s: %s", spool_name.c_str(),
+                  strerror(errno));
+        return;
+    }
+
+    for (int i = 0; i < max_transfers; i++)
+        if (transfers[i].busy)
+            spool_write(transfers[i].it);
+
+    for (deque<item>::const_iterator i = queue.begin(); i != queue.end(); ++i)
+        spool_write(*i);
+}
+
+static bool start_transfer(CURLM *multi, transfer &t, const item &it)
+{
+    struct curl_httppost *last = NULL;
+    char fixes[16];
+
+    snprintf(fixes, sizeof(fixes), "%d", it.fixes);
+
+    t.form = NULL;
+    curl_formadd(&t.form, &last, CURLFORM_COPYNAME, "callsign",
+        CURLFORM_COPYCONTENTS, it.callsign.c_str(), CURLFORM_END);
+    curl_formadd(&t.form, &last, CURLFORM_COPYNAME, "encoding",
+        CURLFORM_COPYCONTENTS, "hex", CURLFORM_END);
+    curl_formadd(&t.form, &last, CURLFORM_COPYNAME, "fixes",
+        CURLFORM_COPYCONTENTS, fixes, CURLFORM_END);
+    curl_formadd(&t.form, &last, CURLFORM_COPYNAME, "packet",
+        CURLFORM_COPYCONTENTS, it.hex.c_str(), CURLFORM_END);
+
+    /* The connections belong to the multi handle, so resetting the easy
+     * handle doesn't close them */
+    curl_easy_reset(t.curl);
+    curl_easy_setopt(t.curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(t.curl, CURLOPT_HTTPPOST, t.form);
+    curl_easy_setopt(t.curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(t.curl, CURLOPT_TIMEOUT, transfer_timeout);
+
+    if (curl_multi_add_handle(multi, t.curl) != CURLM_OK)
+    {
+        curl_formfree(t.form);
+        t.form = NULL;
+        return false;
+    }
+
+    t.it = it;
+    t.busy = true;
+    return true;
+}
+
+/* Returns false if the packet should be sent again later */
+static bool finished(transfer &t, CURLcode r)
+{
+    long code = 0;
+
+    if (r != CURLE_OK)
+    {
+        LOG_WARN("SSDV upload failed: %s", curl_easy_strerror(r));
+        return false;
+    }
+
+    curl_easy_getinfo(t.curl, CURLINFO_RESPONSE_CODE, &code);
+
+    if (code >= 200 && code < 300)
+    {
+        LOG_DEBUG("SSDV packet uploaded");
+        return true;
+    }
+
+    /* The server won't ever take this one */
+    if (code >= 400 && code < 500 && code != 408 && code != 429)
+    {
+        LOG_WARN("SSDV packet refused: HTTP %ld", code);
+        return true;
+    }
+
+    LOG_WARN("SSDV upload failed: HTTP %ld", code);
+    return false;
+}
+
+static void *run(void *)
+{
+    CURLM *multi = curl_multi_init();
+    transfer transfers[max_transfers];
+    int active = 0;
+    double backoff = 0.0;
+    struct timespec retry_at = {0, 0}, now;
+
+    for (int i = 0; i < max_transfers; i++)
+    {
+        transfers[i].curl = curl_easy_init();
+        transfers[i].form = NULL;
+        transfers[i].busy = false;
+    }
+
+    pthread_mutex_lock(&mutex);
+
+    while (!quit)
+    {
+        clock_gettime(CLOCK_REALTIME, &now);
+        bool can_send = multi && is_online && !url.empty();
+        bool waiting = retry_at > now;
+
+        /* Put the next packets on the idle handles */
+        for (int i = 0; can_send && !waiting && i < max_transfers; i++)
+        {
+            transfer &t = transfers[i];
+
+            if (queue.empty())
+                break;
+            if (t.busy || !t.curl)
+                continue;
+            if (!start_transfer(multi, t, queue.front()))
+                break;
+
+            queue.pop_front();
+            active++;
+        }
+
+        /* Empty the spool once everything in it has been sent.  Otherwise
+         * rewrite it when it holds twice what can be queued, before waiting,
+         * so that it stays bounded while offline too. */
+        if (active == 0 && queue.empty())
+        {
+            if (spool_lines)
+                spool_rewrite(transfers);
+        }
+        else if (spool_lines > 2 * max_queue)
+        {
+            spool_rewrite(transfers);
+        }
+
+        if (active == 0)
+        {
+            if (can_send && waiting && !queue.empty())
+                pthread_cond_timedwait(&cond, &mutex, &retry_at);
+            else
+                pthread_cond_wait(&cond, &mutex);
+            continue;
+        }
+
+        pthread_mutex_unlock(&mutex);
+        int still_running;
+        curl_multi_perform(multi, &still_running);
+        curl_multi_wait(multi, NULL, 0, 250, NULL);
+        curl_multi_perform(multi, &still_running);
+        pthread_mutex_lock(&mutex);
+
+        CURLMsg *msg;
+        int left;
+        while ((msg = curl_multi_info_read(multi, &left)))
+        {
+            if (msg->msg != CURLMSG_DONE)
+                continue;
+
+            CURL *curl = msg->easy_handle;
+            CURLcode r = msg->data.result;
+            int i;
+
+            for (i = 0; i < max_transfers; i++)
+                if (transfers[i].curl == curl)
+                    break;
+            if (i == max_transfers)
+                continue;
+
+            transfer &t = transfers[i];
+            curl_multi_remove_handle(multi, curl);
+            curl_formfree(t.form);
+            t.form = NULL;
+            t.busy = false;
+            active--;
+
+            if (finished(t, r))
+            {
+                backoff = 0.0;
+                continue;
+            }
+
+            queue.push_front(t.it);
+
+            clock_gettime(CLOCK_REALTIME, &now);
+            if (!(retry_at > now))
+            {
+                backoff = backoff ? backoff * 2 : min_backoff;
+                if (backoff > max_backoff)
+                    backoff = max_backoff;
+                retry_at = now + backoff;
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&mutex);
+
+    /* Anything still in flight stays in the spool */
+    for (int i = 0; i < max_transfers; i++)
+    {
+        transfer &t = transfers[i];
+
+        if (t.busy)
+        {
+            curl_multi_remove_handle(multi, t.curl);
+            curl_formfree(t.form);
+        }
+        if (t.curl)
+            curl_easy_cleanup(t.curl);
+    }
+
+    if (multi)
+        curl_multi_cleanup(multi);
+
+    return NULL;
+}
+
+void start()
+{
+    guard_lock lock(&mutex);
+
+    if (running)
+        return;
+
+    spool_name = HomeDir + "ssdv_spool.txt";
+    spool_load();
+
+    spool = fopen(spool_name.c_str(), "a");
+    if (!spool)
+        LOG_ERROR("Could not open %s: %s", spool_name.c_str(),
+                  strerror(errno));
+
+    url = station::get().ssdv_packet_url;
+    quit = false;
+
+    if (pthread_create(&thread, NULL, run, NULL) != 0)
+    {
+        LOG_PERROR("pthread_create");
+        return;
+    }
+
+    running = true;
+}
+
+void cleanup()
+{
+    pthread_mutex_lock(&mutex);
+    if (!running)
+    {
+        pthread_mutex_unlock(&mutex);
+        return;
+    }
+    quit = true;
+    pthread_cond_signal(&cond);
+    pthread_mutex_unlock(&mutex);
+
+    pthread_join(thread, NULL);
+
+    guard_lock lock(&mutex);
+    running = false;
+    if (spool)
+        fclose(spool);
+    spool = NULL;
+}
+
+void online(bool value)
+{
+    guard_lock lock(&mutex);
+
+    is_online = value;
+    url = station::get().ssdv_packet_url;
+    pthread_cond_signal(&cond);
+}
+
+void settings()
+{
+    guard_lock lock(&mutex);
+
+    url = station::get().ssdv_packet_url;
+    pthread_cond_signal(&cond);
+}
+
+void packet(const uint8_t *pkt, int fixes)
+{
+    const station::snapshot &s = station::get();
+    item it;
+    char hex[3];
+
+    it.callsign = (s.callsign.empty() ? "UNKNOWN" : s.callsign);
+    it.fixes = fixes;
+    it.hex.reserve(SSDV_PKT_SIZE * 2);
+    for (int i = 0; i < SSDV_PKT_SIZE; i++)
+    {
+        snprintf(hex, sizeof(hex), "%02X", pkt[i]);
+        it.hex.append(hex, 2);
+    }
+
+    guard_lock lock(&mutex);
+
+    /* Don't upload if no URL is present */
+    if (!running || url.empty())
+        return;
+
+    push(it);
+    spool_write(it);
+    pthread_cond_signal(&cond);
+}
+
+} /* namespace ssdv_upload */
+} /* namespace dl_fldigi */
@@ -0,0 +1,68 @@
+/*
+ * License: GNU GPL 3
+ *
+ * station.cxx: Immutable snapshots of the settings, for other threads
+ */
+
+#include "dl_fldigi/station.h"
+
+#include <vector>
+
+#include "configuration.h"
+#include "util.h"
+
+#include "dl_fldigi/dl_fldigi.h"
+
+using namespace std;
+
+namespace dl_fldigi {
+namespace station {
+
+static const snapshot initial;
+static const snapshot *volatile current = &initial;
+
+/* Replaced snapshots that another thread may still be reading. Main
+ * thread only */
+static vector<const snapshot *> retired;
+
+void publish()
+{
+    snapshot *s = new snapshot();
+
+    s->online = online();
+    s->callsign = progdefaults.myCall;
+    s->habitat_uri = progdefaults.habitat_uri;
+    s->habitat_db = progdefaults.habitat_db;
+    s->ssdv_packet_url = progdefaults.ssdv_packet_url;
+    s->location_mode = location::current_location_mode;
+
+    const snapshot *old = current;
+    if (old != &initial)
+        retired.push_back(old);
+
+    /* The snapshot must be complete before anyone can see it */
+    write_memory_barrier();
+    current = s;
+}
+
+const snapshot &get()
+{
+    const snapshot *s = current;
+    read_memory_barrier();
+    return *s;
+}
+
+void cleanup()
+{
+    /* The other threads have been stopped by now */
+    for (size_t i = 0; i < retired.size(); i++)
+        delete retired[i];
+    retired.clear();
+
+    if (current != &initial)
+        delete current;
+    current = &initial;
+}
+
+} /* namespace station */
+} /* namespace dl_fldigi */
@@ -76,9 +76,8 @@ void dominoex::rx_init()
 	met1 = 0.0;
 	met2 = 0.0;
 	counter = 0;
-	phase[0] = 0.0;
-	for (int i = 0; i < MAXFFTS; i++)
-		phase[i+1] = 0.0;
+	for (int i = 0; i <= MAXFFTS; i++)
+		osc[i].reset();
 	put_MODEstatus(mode);
 	put_sec_char(0);
 	syncfilter->reset();
@@ -323,7 +322,6 @@ dominoex::dominoex(trx_mode md)
 // rx modules
 cmplx dominoex::mixer(int n, cmplx in)
 {
-	cmplx z;
 	double f;
 
 // first IF mixer (n == 0) plus
@@ -333,14 +331,8 @@ cmplx dominoex::mixer(int n, cmplx in)
 		f = frequency - FIRSTIF;
 	else
 		f = FIRSTIF - BASEFREQ - bandwidth / 2.0 + tonespacing * (1.0 * (n - 1) / paths );
-	z = cmplx( cos(phase[n]), sin(phase[n]));
-	z = z * in;
-	phase[n] -= TWOPI * f / samplerate;
-	if (phase[n] > M_PI)
-		phase[n] -= TWOPI;
-	else if (phase[n] < M_PI)
-		phase[n] += TWOPI;
-	return z;
+	osc[n].set_step(-TWOPI * f / samplerate);
+	return osc[n].mix(in);
 }
 
 void dominoex::recvchar(int c)
@@ -0,0 +1,97 @@
+// ----------------------------------------------------------------------------
+// channelizer.cxx  --  polyphase FFT filter bank
+//
+// The lowpass prototype h[] is split into `bins' polyphase branches.  For
+// each output block the branch sums
+//
+//	u[m] = sum over p of h[m + p * bins] * x[n - m - p * bins]
+//
+// are transformed by one FFT, which gives every bin filtered by h[] shifted
+// to that bin's centre frequency.
+//
+// Reference:
+//	 "Multirate Digital Signal Processing" by Crochiere and Rabiner
+//
+// This file is part of fldigi.
+//
+// Fldigi is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Fldigi is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with fldigi.  If not, see <http://www.gnu.org/licenses/>.
+// ----------------------------------------------------------------------------
+
+#include <config.h>
+
+#include <cmath>
+
+#include "channelizer.h"
+
+channelizer::channelizer(int bins, int taps, int decimate, double cutoff)
+	: nbins(bins), ntaps(taps), dec(decimate)
+{
+	coeff = new double[ntaps];
+	hist = new double[2 * ntaps];
+	out = new cmplx[nbins];
+	fft = new g_fft<double>(nbins);
+
+// windowed sinc prototype, normalised to unity gain at DC
+	double sum = 0.0;
+	for (int i = 0; i < ntaps; i++) {
+		double t = i - ntaps / 2;
+		double w = 0.42 - 0.5 * cos(2.0 * M_PI * i / ntaps) +
+			0.08 * cos(4.0 * M_PI * i / ntaps);
+		coeff[i] = w * (t == 0 ? 2.0 * cutoff : sin(2.0 * M_PI * cutoff * t) / (M_PI * t));
+		sum += coeff[i];
+	}
+	for (int i = 0; i < ntaps; i++)
+		coeff[i] /= sum;
+
+	clear();
+}
+
+channelizer::~channelizer()
+{
+	delete [] coeff;
+	delete [] hist;
+	delete [] out;
+	delete fft;
+}
+
+void channelizer::clear()
+{
+	for (int i = 0; i < 2 * ntaps; i++)
+		hist[i] = 0.0;
+	for (int i = 0; i < nbins; i++)
+		out[i] = cmplx(0.0, 0.0);
+	inptr = 0;
+	count = 0;
+}
+
+void channelizer::process()
+{
+// hist[inptr + i] is the input i samples ago
+	const double *x = hist + inptr;
+	for (int m = 0; m < nbins; m++) {
+		double u = 0.0;
+		for (int i = m; i < ntaps; i += nbins)
+			u += coeff[i] * x[i];
+		out[m] = cmplx(u, 0.0);
+	}
+	fft->ComplexFFT(out);
+}
+
+int channelizer::nearest(double f) const
+{
+	int k = (int)floor(f * nbins + 0.5);
+	if (k < 0) return 0;
+	if (k > nbins / 2) return nbins / 2;
+	return k;
+}
@@ -40,23 +40,61 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <memory.h>
+#include <map>
 #include "configuration.h"
+#include "threads.h"
 
 #include "misc.h"
 #include "fftfilt.h"
 
 //------------------------------------------------------------------------------
-// initialize the filter
-// create forward and reverse FFTs
+// FFT plans
+// g_fft only reads its tables once they are built, so one instance of each
+// length serves every filter, for both the forward and reverse transforms,
+// from any thread.
 //------------------------------------------------------------------------------
 
-// probably only need a single instance of g_fft !!
-// use for both forward and reverse
+struct fft_plan {
+	g_fft<double> *fft;
+	int refs;
+};
+static std::map<int, fft_plan> fft_plans;
+static pthread_mutex_t fft_plans_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+g_fft<double> *fftfilt::get_fft(int len)
+{
+	guard_lock lock(&fft_plans_mutex);
+
+	fft_plan& plan = fft_plans[len];
+	if (!plan.refs)
+		plan.fft = new g_fft<double>(len);
+	plan.refs++;
+	return plan.fft;
+}
+
+void fftfilt::release_fft(int len)
+{
+	guard_lock lock(&fft_plans_mutex);
+
+	std::map<int, fft_plan>::iterator i = fft_plans.find(len);
+	if (i == fft_plans.end())
+		return;
+	if (--i->second.refs == 0) {
+		delete i->second.fft;
+		fft_plans.erase(i);
+	}
+}
+
+//------------------------------------------------------------------------------
+// initialize the filter
+//------------------------------------------------------------------------------
 
 void fftfilt::init_filter()
 {
 	flen2 = flen >> 1;
-	fft			= new g_fft<double>(flen);
+	fft			= get_fft(flen);
+	shifted		= 0;
+	nshift		= 0;
 
 	filter		= new cmplx[flen];
 	timedata	= new cmplx[flen];
@@ -101,9 +139,10 @@ fftfilt::fftfilt(double f, int len)
 
 fftfilt::~fftfilt()
 {
-	if (fft) delete fft;
+	if (fft) release_fft(flen);
 
 	if (filter) delete [] filter;
+	if (shifted) delete [] shifted;
 	if (timedata) delete [] timedata;
 	if (freqdata) delete [] freqdata;
 	if (output) delete [] output;
@@ -180,6 +219,7 @@ void fftfilt::create_filter(double f1, double f2)
 	fspec.close();
 	delete [] revht;
 */
+	shift_filter();
 	pass = 2;
 }
 
@@ -187,41 +227,125 @@ void fftfilt::create_filter(double f1, double f2)
  * Filter with fast convolution (overlap-add algorithm).
  */
 
-int fftfilt::run(const cmplx & in, cmplx **out)
+// freqdata holds the transform of the last flen/2 inputs; completes the
+// convolution into out
+int fftfilt::process(cmplx *out)
 {
-// collect flen/2 input samples
-	timedata[inptr++] = in;
-
-	if (inptr < flen2)
-		return 0;
 	if (pass) --pass; // filter output is not stable until 2 passes
 
-// FFT transpose to the frequency domain
-	memcpy(freqdata, timedata, flen * sizeof(cmplx));
-	fft->ComplexFFT(freqdata);
-
 // multiply with the filter shape
+	const cmplx *h = nshift ? shifted : filter;
 	for (int i = 0; i < flen; i++)
-		freqdata[i] *= filter[i];
+		freqdata[i] *= h[i];
 
 // transform back to time domain
 	fft->InverseComplexFFT(freqdata);
 
 // overlap and add
 // save the second half for overlapping next inverse FFT
+	if (pass) out = output;
 	for (int i = 0; i < flen2; i++) {
-		output[i] = ovlbuf[i] + freqdata[i];
+		out[i] = ovlbuf[i] + freqdata[i];
 		ovlbuf[i] = freqdata[i+flen2];
 	}
 
 // clear inbuf pointer
 	inptr = 0;
 
+	return pass ? 0 : flen2;
+}
+
+int fftfilt::run(const cmplx & in, cmplx **out)
+{
+// collect flen/2 input samples
+	timedata[inptr++] = in;
+
+	if (inptr < flen2)
+		return 0;
+
+// FFT transpose to the frequency domain
+	memcpy(freqdata, timedata, flen * sizeof(cmplx));
+	fft->ComplexFFT(freqdata);
+
 // signal the caller there is flen/2 samples ready
-	if (pass) return 0;
+	*out = output;
+	return process(output);
+}
+
+int fftfilt::run(const cmplx *in, int len, cmplx *out)
+{
+	int nout = 0;
+
+	while (len > 0) {
+		int n = flen2 - inptr;
+		if (n > len) n = len;
+		memcpy(timedata + inptr, in, n * sizeof(cmplx));
+		inptr += n;
+		in += n;
+		len -= n;
+
+		if (inptr < flen2)
+			break;
+		memcpy(freqdata, timedata, flen * sizeof(cmplx));
+		fft->ComplexFFT(freqdata);
+		nout += process(out + nout);
+	}
+
+	return nout;
+}
+
+int fftfilt::run(const double *in, int len, cmplx *out)
+{
+	int nout = 0;
+
+	while (len > 0) {
+		for (; len > 0 && inptr < flen2; len--)
+			timedata[inptr++] = cmplx(*in++, 0.0);
+
+		if (inptr < flen2)
+			break;
+		real_transform();
+		nout += process(out + nout);
+	}
+
+	return nout;
+}
+
+// The second half of timedata is always zero, so the block is a real
+// sequence of flen points.  Its transform is conjugate symmetric and a real
+// FFT gives the lower half, with the real Nyquist term packed into the
+// imaginary part of the DC term.
+void fftfilt::real_transform()
+{
+	double *rdata = (double *)freqdata;
+
+	for (int i = 0; i < flen2; i++)
+		rdata[i] = timedata[i].real();
+	memset(rdata + flen2, 0, flen2 * sizeof(double));
+	fft->RealFFT(freqdata);
+
+	freqdata[flen2] = cmplx(freqdata[0].imag(), 0.0);
+	freqdata[0] = cmplx(freqdata[0].real(), 0.0);
+	for (int i = 1; i < flen2; i++)
+		freqdata[flen - i] = conj(freqdata[i]);
+}
 
+bool fftfilt::transform(double in)
+{
+	timedata[inptr++] = cmplx(in, 0.0);
+	if (inptr < flen2)
+		return false;
+
+	real_transform();
+	inptr = 0;
+	return true;
+}
+
+int fftfilt::run(const fftfilt& src, cmplx **out)
+{
+	memcpy(freqdata, src.freqdata, flen * sizeof(cmplx));
 	*out = output;
-	return flen2;
+	return process(output);
 }
 
 //------------------------------------------------------------------------------
@@ -265,7 +389,9 @@ void fftfilt::rtty_filter(double f)
             dht *= dht; // cos^2
 
     // amplitude equalized nyquist-channel response
-            dht /= sinc(2.0 * i * f);
+    // (tuned for 1024 point filters; i is scaled to that length so that a
+    // shorter filter at a decimated rate equalizes the same frequencies)
+            dht /= sinc(2.0 * i * f * flen / 1024.0);
 
             filter[i].real() = dht*cos((double)i* - 0.5*M_PI);
             filter[i].imag() = dht*sin((double)i* - 0.5*M_PI);
@@ -298,7 +424,34 @@ void fftfilt::rtty_filter(double f)
 	fspec.close();
 	delete [] revht;
 */
+	shift_filter();
 // start outputs after 2 full passes are complete
 	pass = 2;
 }
 
+//------------------------------------------------------------------------------
+// passband shift
+// Rotating H(w) by k bins multiplies h(t) by exp(j 2pi k t / flen), which
+// moves a lowpass response up to the bin frequency without a new design.
+//------------------------------------------------------------------------------
+
+void fftfilt::shift(double f)
+{
+	int k = (int)floor(f * flen + 0.5) % flen;
+	if (k < 0) k += flen;
+	if (k == nshift)
+		return;
+	nshift = k;
+	shift_filter();
+}
+
+void fftfilt::shift_filter()
+{
+	if (!nshift)
+		return;
+	if (!shifted)
+		shifted = new cmplx[flen];
+	for (int i = 0; i < flen; i++)
+		shifted[(i + nshift) % flen] = filter[i];
+}
+
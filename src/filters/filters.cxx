@@ -186,6 +186,46 @@ int C_FIR_filter::run (const cmplx &in, cmplx &out) {
 	return 0;
 }
 
+//=====================================================================
+// Run a block
+// passes len cmplx values (in) and receives the decimated cmplx values
+// (out), which may be the same array as in
+// function returns the number of values written to out
+//=====================================================================
+
+int C_FIR_filter::run (const cmplx *in, cmplx *out, int len) {
+	int n = 0;
+
+	while (len > 0) {
+		int chunk = FIRBufferLen - pointer;
+		if (chunk > len)
+			chunk = len;
+		for (int i = 0; i < chunk; i++) {
+			ibuffer[pointer + i] = in[i].real();
+			qbuffer[pointer + i] = in[i].imag();
+		}
+// only the samples that are kept are computed, as in the single run()
+		for (int i = 0; i < chunk; i++) {
+			if (++counter < decimateratio)
+				continue;
+			counter = 0;
+			int p = pointer + i;
+			out[n++] = cmplx (	mac(&ibuffer[p - length], ifilter, length),
+								mac(&qbuffer[p - length], qfilter, length) );
+		}
+		in += chunk;
+		len -= chunk;
+		pointer += chunk;
+		if (pointer == FIRBufferLen) {
+			memmove (ibuffer, ibuffer + FIRBufferLen - length, length * sizeof (double) );
+			memmove (qbuffer, qbuffer + FIRBufferLen - length, length * sizeof (double) );
+			pointer = length;
+		}
+	}
+
+	return n;
+}
+
 //=====================================================================
 // Run the filter for the Real part of the cmplx variable
 //=====================================================================
@@ -221,7 +261,7 @@ int C_FIR_filter::Irun (const double &in, double &out) {
 //=====================================================================
 
 int C_FIR_filter::Qrun (const double &in, double &out) {
-	double *qptr = ibuffer + pointer;
+	double *qptr = qbuffer + pointer;
 
 	pointer++;
 	counter++;
@@ -0,0 +1,449 @@
+// ----------------------------------------------------------------------------
+// gfft.cxx  --  specialised g_fft implementations
+//
+// g_fft<float> uses the radix-4 kernel below, which works on two complex
+// values at a time with SSE or NEON, or FFTW's single precision library
+// when configured with it.  g_fft<double> stays with the template code.
+//
+// Twiddle factors, bit reversal tables and FFTW plans are built once for
+// each size and kept for the life of the process, so that any number of
+// g_fft objects of one size share them.
+//
+// This file is part of fldigi.
+//
+// Fldigi is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Fldigi is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with fldigi.  If not, see <http://www.gnu.org/licenses/>.
+// ----------------------------------------------------------------------------
+
+#include <config.h>
+
+#include <cmath>
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include "gfft.h"
+#include "threads.h"
+
+#if USE_FFTW
+#  include <fftw3.h>
+#elif defined(__SSE__)
+#  include <xmmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#  include <arm_neon.h>
+#endif
+
+static pthread_mutex_t plans_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+//------------------------------------------------------------------------------
+// Real transforms
+// N real points are transformed as N/2 complex points z[m] = x[2m] + j x[2m+1].
+// With Z = FFT(z), the even and odd point spectra are
+//	Fe[k] = (Z[k] + conj(Z[N/2 - k])) / 2
+//	Fo[k] = (Z[k] - conj(Z[N/2 - k])) / 2j
+// and X[k] = Fe[k] + W^k Fo[k], W = exp(-j 2pi / N).  X[N/2] is packed into
+// the imaginary part of X[0], as g_fft has always done.
+//------------------------------------------------------------------------------
+
+// W^k for k = 0 ... N/4, for the N point real transforms
+template <typename T>
+static const std::complex<T> *split_twiddles(int N)
+{
+	static std::map<int, std::vector<std::complex<T> > > cache;
+
+	guard_lock lock(&plans_mutex);
+	std::vector<std::complex<T> >& w = cache[N];
+	if (w.empty()) {
+		w.resize(N / 4 + 1);
+		for (int k = 0; k <= N / 4; k++)
+			w[k] = std::complex<T>(cos(2.0 * M_PI * k / N), -sin(2.0 * M_PI * k / N));
+	}
+	return &w[0];
+}
+
+// z holds FFT(z) of n = N/2 points; replaces it with the packed X
+template <typename T>
+static void real_split(std::complex<T> *z, int n, const std::complex<T> *w)
+{
+	const std::complex<T> mj(0, -1);
+
+	T r = z[0].real(), i = z[0].imag();
+	z[0] = std::complex<T>(r + i, r - i);
+
+	for (int k = 1; k <= n / 2; k++) {
+		std::complex<T> a = z[k], b = conj(z[n - k]);
+		std::complex<T> fe = (a + b) * T(0.5);
+		std::complex<T> fo = (a - b) * mj * T(0.5);
+		std::complex<T> t = w[k] * fo;
+		z[k] = fe + t;
+		z[n - k] = conj(fe - t);
+	}
+}
+
+// The reverse of real_split, leaving Z for an inverse FFT of n points
+template <typename T>
+static void real_unsplit(std::complex<T> *z, int n, const std::complex<T> *w)
+{
+	const std::complex<T> j(0, 1);
+
+	T r = z[0].real(), i = z[0].imag();
+	z[0] = std::complex<T>(r + i, r - i) * T(0.5);
+
+	for (int k = 1; k <= n / 2; k++) {
+		std::complex<T> a = z[k], b = conj(z[n - k]);
+		std::complex<T> fe = (a + b) * T(0.5);
+		std::complex<T> fo = (a - b) * conj(w[k]) * T(0.5);
+		z[k] = fe + j * fo;
+		z[n - k] = conj(fe - j * fo);
+	}
+}
+
+// Both implementations below keep their own tables, so the cosine and bit
+// reversal tables of the template code are left empty
+template <> void g_fft<float>::fftInit()
+{
+	for (int i = 0; i < 32; i++) {
+		FFT_table_1[i] = 0;
+		FFT_table_2[i] = 0;
+	}
+	FFT_N = ConvertFFTSize(FFT_size);
+	Utbl = 0;
+	BRLow = BRLowReal = 0;
+}
+
+#if USE_FFTW
+
+//------------------------------------------------------------------------------
+// FFTW
+// The plans are in place, unaligned and made with FFTW_ESTIMATE, so they do
+// not touch the planning buffer and may be executed on any buffer.  The
+// planner is not thread safe but fftw_execute_dft is.
+//------------------------------------------------------------------------------
+
+template <typename T> struct fftw;
+
+template <> struct fftw<float> {
+	typedef fftwf_plan plan;
+	typedef fftwf_complex complex;
+	static plan make(int n, int sign) {
+		complex *buf = static_cast<complex *>(fftwf_malloc(n * sizeof(complex)));
+		plan p = fftwf_plan_dft_1d(n, buf, buf, sign, FFTW_ESTIMATE | FFTW_UNALIGNED);
+		fftwf_free(buf);
+		return p;
+	}
+	static void execute(plan p, std::complex<float> *buf) {
+		complex *b = reinterpret_cast<complex *>(buf);
+		fftwf_execute_dft(p, b, b);
+	}
+};
+
+template <typename T>
+struct fftw_plans {
+	typename fftw<T>::plan fwd, inv;		// N points
+	typename fftw<T>::plan rfwd, rinv;		// N/2 points
+	const std::complex<T> *split;
+};
+
+template <typename T>
+static fftw_plans<T> *get_plans(int N)
+{
+	static std::map<int, fftw_plans<T> > cache;
+
+	const std::complex<T> *split = split_twiddles<T>(N);
+
+	guard_lock lock(&plans_mutex);
+	typename std::map<int, fftw_plans<T> >::iterator i = cache.find(N);
+	if (i == cache.end()) {
+		fftw_plans<T> p;
+		p.fwd = fftw<T>::make(N, FFTW_FORWARD);
+		p.inv = fftw<T>::make(N, FFTW_BACKWARD);
+		p.rfwd = fftw<T>::make(N / 2, FFTW_FORWARD);
+		p.rinv = fftw<T>::make(N / 2, FFTW_BACKWARD);
+		p.split = split;
+		i = cache.insert(std::make_pair(N, p)).first;
+	}
+	return &i->second;
+}
+
+#define FFTW_G_FFT(T)							\
+template <> void g_fft<T>::init_plan()					\
+{									\
+	plan = get_plans<T>(FFT_size);					\
+}									\
+template <> void g_fft<T>::free_plan() { }				\
+template <> void g_fft<T>::ComplexFFT(std::complex<T> *buf)		\
+{									\
+	fftw<T>::execute(static_cast<fftw_plans<T> *>(plan)->fwd, buf);	\
+}									\
+template <> void g_fft<T>::InverseComplexFFT(std::complex<T> *buf)	\
+{									\
+	fftw<T>::execute(static_cast<fftw_plans<T> *>(plan)->inv, buf);	\
+	T scale = T(1) / FFT_size;					\
+	for (int i = 0; i < FFT_size; i++)				\
+		buf[i] *= scale;					\
+}									\
+template <> void g_fft<T>::RealFFT(std::complex<T> *buf)		\
+{									\
+	fftw_plans<T> *p = static_cast<fftw_plans<T> *>(plan);		\
+	fftw<T>::execute(p->rfwd, buf);					\
+	real_split(buf, FFT_size / 2, p->split);			\
+}									\
+template <> void g_fft<T>::InverseRealFFT(std::complex<T> *buf)		\
+{									\
+	fftw_plans<T> *p = static_cast<fftw_plans<T> *>(plan);		\
+	real_unsplit(buf, FFT_size / 2, p->split);			\
+	fftw<T>::execute(p->rinv, buf);					\
+	T scale = T(2) / FFT_size;					\
+	for (int i = 0; i < FFT_size / 2; i++)				\
+		buf[i] *= scale;					\
+}
+
+FFTW_G_FFT(float)
+
+#else // !USE_FFTW
+
+//------------------------------------------------------------------------------
+// Two complex floats at a time
+//------------------------------------------------------------------------------
+
+#if defined(__SSE__)
+typedef __m128 v4f;
+static inline v4f v_load(const float *p) { return _mm_loadu_ps(p); }
+static inline void v_store(float *p, v4f a) { _mm_storeu_ps(p, a); }
+static inline v4f v_add(v4f a, v4f b) { return _mm_add_ps(a, b); }
+static inline v4f v_sub(v4f a, v4f b) { return _mm_sub_ps(a, b); }
+static inline v4f v_mul(v4f a, v4f b) { return _mm_mul_ps(a, b); }
+// (re, im) -> (im, re)
+static inline v4f v_swap(v4f a) { return _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)); }
+// (re, im) -> (re, -im)
+static inline v4f v_conj(v4f a) { return _mm_xor_ps(a, _mm_set_ps(-0.0f, 0.0f, -0.0f, 0.0f)); }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+typedef float32x4_t v4f;
+static inline v4f v_load(const float *p) { return vld1q_f32(p); }
+static inline void v_store(float *p, v4f a) { vst1q_f32(p, a); }
+static inline v4f v_add(v4f a, v4f b) { return vaddq_f32(a, b); }
+static inline v4f v_sub(v4f a, v4f b) { return vsubq_f32(a, b); }
+static inline v4f v_mul(v4f a, v4f b) { return vmulq_f32(a, b); }
+static inline v4f v_swap(v4f a) { return vrev64q_f32(a); }
+static inline v4f v_conj(v4f a)
+{
+	static const float s[4] = { 1.0f, -1.0f, 1.0f, -1.0f };
+	return vmulq_f32(a, vld1q_f32(s));
+}
+#else
+struct v4f { float f[4]; };
+static inline v4f v_load(const float *p) { v4f a = { { p[0], p[1], p[2], p[3] } }; return a; }
+static inline void v_store(float *p, v4f a) { for (int i = 0; i < 4; i++) p[i] = a.f[i]; }
+static inline v4f v_add(v4f a, v4f b) { for (int i = 0; i < 4; i++) a.f[i] += b.f[i]; return a; }
+static inline v4f v_sub(v4f a, v4f b) { for (int i = 0; i < 4; i++) a.f[i] -= b.f[i]; return a; }
+static inline v4f v_mul(v4f a, v4f b) { for (int i = 0; i < 4; i++) a.f[i] *= b.f[i]; return a; }
+static inline v4f v_swap(v4f a) { v4f b = { { a.f[1], a.f[0], a.f[3], a.f[2] } }; return b; }
+static inline v4f v_conj(v4f a) { a.f[1] = -a.f[1]; a.f[3] = -a.f[3]; return a; }
+#endif
+
+// a * w, with w held as wr = (re, re) and wi = (-im, im)
+static inline v4f v_cmul(v4f a, v4f wr, v4f wi)
+{
+	return v_add(v_mul(a, wr), v_mul(v_swap(a), wi));
+}
+
+// a * -j
+static inline v4f v_mulmj(v4f a)
+{
+	return v_conj(v_swap(a));
+}
+
+//------------------------------------------------------------------------------
+// Radix-4 decimation in time, in place, after a bit reversal.  Each stage
+// combines four transforms of L points a, b, c, d (in bit reversed order)
+// into one of 4L points, for j < L:
+//	p0 = a + W2L^j b	p1 = a - W2L^j b
+//	q0 = c + W2L^j d	q1 = c - W2L^j d
+//	X[j]      = p0 + W4L^j q0	X[j + 2L] = p0 - W4L^j q0
+//	X[j + L]  = p1 - j W4L^j q1	X[j + 3L] = p1 + j W4L^j q1
+// which is two radix-2 stages done in one pass over the data.  An odd log2
+// size starts with one radix-2 stage.
+//------------------------------------------------------------------------------
+
+struct fft_kernel {
+	int n;
+	std::vector<int> swaps;		// bit reversal, as pairs of indices
+	bool radix2;			// first stage is radix-2
+	int L0;				// L of the first radix-4 stage needing twiddles
+	// for each stage from L0: W2L^j then W4L^j, for j in pairs, each as
+	// (re, re, re, re) and (-im, im, -im, im)
+	std::vector<float> twiddles;
+};
+
+static const fft_kernel *get_kernel(int n)
+{
+	static std::map<int, fft_kernel> cache;
+
+	guard_lock lock(&plans_mutex);
+	fft_kernel& k = cache[n];
+	if (k.n)
+		return &k;
+
+	int m = 0;
+	while ((1 << m) < n) m++;
+
+	for (int i = 0, j = 0; i < n; i++) {
+		if (i < j) {
+			k.swaps.push_back(i);
+			k.swaps.push_back(j);
+		}
+		int bit = n >> 1;
+		for (; j & bit; bit >>= 1)
+			j ^= bit;
+		j |= bit;
+	}
+
+	k.radix2 = m & 1;
+	k.L0 = k.radix2 ? 2 : 4;
+	for (int L = k.L0; 4 * L <= n; L *= 4) {
+		for (int j = 0; j < L; j += 2) {
+			for (int s = 2; s <= 4; s += 2) {
+				double a0 = -2.0 * M_PI * j / (s * L);
+				double a1 = -2.0 * M_PI * (j + 1) / (s * L);
+				float w[8] = {
+					(float)cos(a0), (float)cos(a0), (float)cos(a1), (float)cos(a1),
+					(float)-sin(a0), (float)sin(a0), (float)-sin(a1), (float)sin(a1)
+				};
+				k.twiddles.insert(k.twiddles.end(), w, w + 8);
+			}
+		}
+	}
+	k.n = n;
+
+	return &k;
+}
+
+static void kernel_fft(const fft_kernel *k, std::complex<float> *buf)
+{
+	int n = k->n;
+	float *x = reinterpret_cast<float *>(buf);
+
+	for (size_t i = 0; i < k->swaps.size(); i += 2)
+		std::swap(buf[k->swaps[i]], buf[k->swaps[i + 1]]);
+
+	int L;
+	if (k->radix2) {
+		for (int i = 0; i < n; i += 2) {
+			std::complex<float> a = buf[i], b = buf[i + 1];
+			buf[i] = a + b;
+			buf[i + 1] = a - b;
+		}
+		L = 2;
+	}
+	else {
+// L = 1, all twiddles are 1
+		for (int i = 0; i < n; i += 4) {
+			std::complex<float> a = buf[i], b = buf[i + 1], c = buf[i + 2], d = buf[i + 3];
+			std::complex<float> p0 = a + b, p1 = a - b, q0 = c + d, q1 = c - d;
+			q1 = std::complex<float>(q1.imag(), -q1.real()); // -j q1
+			buf[i] = p0 + q0;
+			buf[i + 2] = p0 - q0;
+			buf[i + 1] = p1 + q1;
+			buf[i + 3] = p1 - q1;
+		}
+		L = 4;
+	}
+
+	const float *tw = k->twiddles.empty() ? 0 : &k->twiddles[0];
+	for (; 4 * L <= n; L *= 4) {
+		const float *w = tw;
+		for (int g = 0; g < n; g += 4 * L) {
+			float *a = x + 2 * g;
+			float *b = a + 2 * L;
+			float *c = b + 2 * L;
+			float *d = c + 2 * L;
+			w = tw;
+			for (int j = 0; j < 2 * L; j += 4, w += 16) {
+				v4f w1r = v_load(w), w1i = v_load(w + 4);
+				v4f w2r = v_load(w + 8), w2i = v_load(w + 12);
+
+				v4f va = v_load(a + j);
+				v4f vb = v_cmul(v_load(b + j), w1r, w1i);
+				v4f vc = v_load(c + j);
+				v4f vd = v_cmul(v_load(d + j), w1r, w1i);
+
+				v4f p0 = v_add(va, vb), p1 = v_sub(va, vb);
+				v4f q0 = v_cmul(v_add(vc, vd), w2r, w2i);
+				v4f q1 = v_mulmj(v_cmul(v_sub(vc, vd), w2r, w2i));
+
+				v_store(a + j, v_add(p0, q0));
+				v_store(c + j, v_sub(p0, q0));
+				v_store(b + j, v_add(p1, q1));
+				v_store(d + j, v_sub(p1, q1));
+			}
+		}
+		tw = w;
+	}
+}
+
+// IFFT(x) = conj(FFT(conj(x))) / n
+static void kernel_ifft(const fft_kernel *k, std::complex<float> *buf, float scale)
+{
+	int n = k->n;
+	for (int i = 0; i < n; i++)
+		buf[i] = conj(buf[i]);
+	kernel_fft(k, buf);
+	for (int i = 0; i < n; i++)
+		buf[i] = conj(buf[i]) * scale;
+}
+
+struct float_plan {
+	const fft_kernel *full;			// N points
+	const fft_kernel *half;			// N/2 points
+	const std::complex<float> *split;
+};
+
+template <> void g_fft<float>::init_plan()
+{
+	float_plan *p = new float_plan;
+	p->full = get_kernel(FFT_size);
+	p->half = get_kernel(FFT_size / 2);
+	p->split = split_twiddles<float>(FFT_size);
+	plan = p;
+}
+
+template <> void g_fft<float>::free_plan()
+{
+	delete static_cast<float_plan *>(plan);
+}
+
+template <> void g_fft<float>::ComplexFFT(std::complex<float> *buf)
+{
+	kernel_fft(static_cast<float_plan *>(plan)->full, buf);
+}
+
+template <> void g_fft<float>::InverseComplexFFT(std::complex<float> *buf)
+{
+	kernel_ifft(static_cast<float_plan *>(plan)->full, buf, 1.0f / FFT_size);
+}
+
+template <> void g_fft<float>::RealFFT(std::complex<float> *buf)
+{
+	float_plan *p = static_cast<float_plan *>(plan);
+	kernel_fft(p->half, buf);
+	real_split(buf, FFT_size / 2, p->split);
+}
+
+template <> void g_fft<float>::InverseRealFFT(std::complex<float> *buf)
+{
+	float_plan *p = static_cast<float_plan *>(plan);
+	real_unsplit(buf, FFT_size / 2, p->split);
+	kernel_ifft(p->half, buf, 2.0f / FFT_size);
+}
+
+#endif // USE_FFTW
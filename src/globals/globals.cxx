@@ -31,6 +31,7 @@
 #include <cstdlib>
 #include <cerrno>
 #include <cstdio>
+#include <strings.h>
 
 #include "gettext.h"
 #include "globals.h"
@@ -185,6 +186,19 @@ const struct mode_info_t mode_info[NUM_MODES] = {
 
 };
 
+trx_mode mode_by_name(const char* name)
+{
+	char* p;
+	long id = strtol(name, &p, 10);
+	if (*name && *p == '\0')
+		return (id >= 0 && id < NUM_MODES) ? id : NUM_MODES;
+
+	for (trx_mode m = 0; m < NUM_MODES; m++)
+		if (!strcasecmp(name, mode_info[m].sname))
+			return m;
+	return NUM_MODES;
+}
+
 std::ostream& operator<<(std::ostream& s, const qrg_mode_t& m)
 {
 	return s << m.rfcarrier << ' ' << m.rmode << ' ' << m.carrier << ' ' << mode_info[m.mode].sname;
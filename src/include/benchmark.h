@@ -2,22 +2,35 @@
 #define BENCHMARK_H_
 
 #include <string>
+#include <vector>
 #include <sys/types.h>
 #include "globals.h"
 
+// Parameters for the modem benchmark suite, run by dl-fldigi-decode.
+// Every modem in `modems' (if empty, every mode that decoder_mode_ok() accepts:
+// RTTY, PSK, DominoEX and THOR) is run `runs' times
+// over the synthetic inputs and every recorded input file, and the fastest
+// run is the one that is reported and compared with the baseline.
 struct benchmark_params {
-	trx_mode modem;
+	bool enabled;
 	int freq;
 	bool afc, sql;
 	double sqlevel;
-	double src_ratio;
-	int src_type;
-	std::string input, output, buffer;
 	size_t samples;
+	double tolerance;
+	int runs;
+	std::vector<trx_mode> modems;
+	std::vector<std::string> inputs;
+	std::string output, baseline;
 };
 extern struct benchmark_params benchmark;
 
 int setup_benchmark(void);
 void do_benchmark(void);
 
+// The modems' transmitters, which make the "signal" input, take their text
+// from benchmark_tx_char() and hand their output to benchmark_modulated()
+int benchmark_tx_char(void);
+void benchmark_modulated(const double* buf, int len);
+
 #endif
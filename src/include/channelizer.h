@@ -0,0 +1,78 @@
+// ----------------------------------------------------------------------------
+// channelizer.h  --  polyphase FFT filter bank
+//
+// This file is part of fldigi.
+//
+// Fldigi is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Fldigi is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with fldigi.  If not, see <http://www.gnu.org/licenses/>.
+// ----------------------------------------------------------------------------
+
+#ifndef CHANNELIZER_H
+#define CHANNELIZER_H
+
+#include "complex.h"
+#include "gfft.h"
+
+// Splits a real input into `bins' complex streams, one centred on each
+// multiple of samplerate / bins, all decimated by `decimate'.  Every
+// output block costs one lowpass prototype of `taps' coefficients and one
+// `bins' point FFT, however many of the streams are used.
+//
+// bins must be a power of 2.  cutoff is the -6 dB point of the prototype
+// lowpass as a fraction of the sample rate.
+//
+// The streams are not mixed down.  A signal at frequency f is recovered from
+// bin(nearest(f)) by multiplying it with exp(j * 2pi * f * n), n counting input
+// samples, so a caller that keeps that phase may move between bins freely.
+
+class channelizer {
+public:
+	channelizer(int bins, int taps, int decimate, double cutoff);
+	~channelizer();
+
+	void clear();
+	// Adds one input sample.  Returns true when a block of outputs is due;
+	// process() must then be called before bin() is used.
+	bool push(double in) {
+		inptr = (inptr == 0 ? ntaps : inptr) - 1;
+		hist[inptr] = hist[inptr + ntaps] = in;
+		if (++count < dec)
+			return false;
+		count = 0;
+		return true;
+	}
+	void process();
+
+	// Output of bin k
+	const cmplx& bin(int k) const { return out[k]; }
+	// Nearest bin to frequency f, a fraction of the sample rate
+	int nearest(double f) const;
+
+	int bins() const { return nbins; }
+	int decimation() const { return dec; }
+
+private:
+	int nbins;
+	int ntaps;
+	int dec;
+
+	double *coeff;
+	double *hist;
+	int inptr;
+	int count;
+
+	g_fft<double> *fft;
+	cmplx *out;
+};
+
+#endif
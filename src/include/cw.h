@@ -30,10 +30,12 @@
 
 #include <cstring>
 #include <string>
+#include <vector>
 
 #include "modem.h"
 #include "filters.h"
 #include "fftfilt.h"
+#include "nco.h"
 #include "mbuffer.h"
 
 
@@ -108,8 +110,9 @@ protected:
 	int			symbollen;		// length of a dot in sound samples (tx)
 	int			fsymlen;        	// length of extra interelement space (farnsworth)
 	double		phaseacc;		// used by NCO for rx/tx tones
-	double		FFTphase;
-	double		FIRphase;
+	C_NCO		FFTosc;
+	C_NCO		FIRosc;
+	std::vector<cmplx>	rxmix;		// rx block mixed to baseband
 	double		FFTvalue;
 	double		FIRvalue;
 	unsigned int	smpl_ctr;		// sample counter for timing cw rx
@@ -133,6 +136,8 @@ protected:
 
 	CW_RX_STATE		cw_receive_state;	// Indicates receive state 
 	CW_RX_STATE		old_cw_receive_state;
+	bool			space_sent;			// for word space logic
+	int				last_element;		// length of last dot/dash
 	CW_EVENT		cw_event;			// functions used by cw process routine 
 	 
 	double pipe[MAX_PIPE_SIZE+1];			// storage for sync scope data
@@ -203,7 +208,6 @@ protected:
 	void	update_tracking(int dot, int dash);
 	
 	void	makeshape();
-	cmplx mixer(cmplx in);
 
 	static const SOM_TABLE som_table[];
 	float cw_buffer[512];
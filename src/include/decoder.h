@@ -0,0 +1,64 @@
+// ----------------------------------------------------------------------------
+// decoder.h
+//
+// This file is part of fldigi.
+//
+// Fldigi is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Fldigi is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with fldigi.  If not, see <http://www.gnu.org/licenses/>.
+// ----------------------------------------------------------------------------
+
+#ifndef DECODER_H_
+#define DECODER_H_
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <sys/types.h>
+#include "globals.h"
+
+namespace Json { class Value; }
+
+// Number of samples passed to rx_process() at a time
+#define DECODER_BLOCKSIZE 4096
+
+// Parameters for the offline decoder (dl-fldigi-decode).  An input of "-"
+// reads raw signed 16-bit mono PCM at `rate' Hz from stdin.
+struct decoder_params {
+	trx_mode modem;
+	int freq;
+	bool afc, sql;
+	double sqlevel;
+	int rate;
+	int src_type;
+	int jobs;
+	bool telemetry;
+	std::vector<std::string> inputs;
+	std::string output_dir;
+
+	// per-process state, set up by setup_decoder()
+	std::string input;
+	FILE* out;
+};
+extern struct decoder_params decoder;
+
+// The decoder runs the modems that need no widgets: RTTY, PSK, DominoEX and
+// THOR
+bool decoder_mode_ok(trx_mode mode);
+
+int setup_decoder(void);
+void do_decode(void);
+
+void decoder_put_char(unsigned int data);
+void decoder_put_telemetry(const Json::Value& data);
+
+#endif
@@ -23,7 +23,8 @@ enum changed_groups
     CH_INFO = 0x02,
     CH_LOCATION_MODE = 0x04,
     CH_STATIONARY_LOCATION = 0x08,
-    CH_GPS_SETTINGS = 0x10
+    CH_GPS_SETTINGS = 0x10,
+    CH_SSDV_SETTINGS = 0x20
 };
 
 extern bool hab_ui_exists, shutting_down;
@@ -41,6 +42,9 @@ void commit();
 
 void status(const std::string &message);
 void status_important(const std::string &message);
+/* The same, for threads that mustn't take the Fl lock: the status bar is
+ * updated later by the main thread */
+void post_status(const std::string &message, bool important=false);
 
 } /* namespace dl_fldigi */
 
@@ -0,0 +1,33 @@
+#ifndef DL_FLDIGI_EXTRACTOR_H
+#define DL_FLDIGI_EXTRACTOR_H
+
+namespace dl_fldigi {
+namespace extractor {
+
+/*
+ * Finds UKHAS "$$...*CHECKSUM" sentences in the decoded text of the active
+ * modem and of each extra modem, away from the modems' threads.
+ *
+ * put() and skipped() only write to a queue for the modem that calls them,
+ * without locking. The extractor thread frames sentences from the queues and
+ * hands every complete one to the modem's habitat extractor manager, which
+ * parses and uploads it as before.  Their XOR or CRC16-CCITT checksums are
+ * checked only for the log; a fragment cut short by another "$$", or too
+ * long to be a sentence, is only shown as bad.
+ *
+ * dl-fldigi-decode has no extractor thread, and does all of this on the
+ * calling thread instead.
+ */
+
+void init();                    /* Before any modem is started */
+void start();
+void cleanup();
+
+/* From the modem's own thread */
+void put(unsigned char c, bool baudot=false);
+void skipped(int n);
+
+} /* namespace extractor */
+} /* namespace dl_fldigi */
+
+#endif /* DL_FLDIGI_EXTRACTOR_H */
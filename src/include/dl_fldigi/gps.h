@@ -38,8 +38,9 @@ class GPSThread : public EZ::SimpleThread
     void warning(const std::string &message);
 
     void read();
-    void update_ui(const string &time_str, double lat, double lon, double alt);
-    void upload(const string &time_str, double lat, double lon, double alt);
+    void update_ui(const string &time_str, double lat, double lon, double alt,
+                   bool uploaded);
+    bool upload(const string &time_str, double lat, double lon, double alt);
 
 public:
     GPSThread(const std::string &d, int b, int r)
@@ -35,9 +35,6 @@ public:
     /* Update UI */
     void got_flights(const std::vector<Json::Value> &flights);
     void got_payloads(const std::vector<Json::Value> &payloads);
-
-    /* Modify run() to help us shutdown the thread */
-    void *run();
 };
 
 class DExtractorManager : public habitat::ExtractorManager
@@ -53,6 +50,15 @@ public:
 extern DExtractorManager *extrmgr;
 extern DUploaderThread *uthr;
 
+/* From the extractor thread (see extractor.h): passes a complete sentence,
+ * received at audio_freq by the active modem (-1) or an extra modem, to that
+ * modem's extractor manager; or shows a fragment that never ended */
+void sentence(int modem, const std::string &s, bool baudot, int audio_freq,
+              bool reversed);
+void bad_sentence(int modem, const std::string &s);
+/* Sets the payload of every extractor manager */
+void payload(const Json::Value *data);
+
 void init();
 void start();
 void cleanup();
@@ -0,0 +1,38 @@
+#ifndef DL_FLDIGI_SPOOL_H
+#define DL_FLDIGI_SPOOL_H
+
+#include <string>
+#include "jsoncpp.h"
+
+namespace dl_fldigi {
+namespace spool {
+
+/*
+ * Telemetry and listener documents are appended to a spool file in HomeDir
+ * and uploaded to habitat by one thread, in batches: all of a batch's
+ * listener documents go in a single _bulk_docs request, and its payload
+ * telemetry goes through habitat's add_listener update handler a few
+ * documents at a time over shared connections. Nothing is lost while
+ * offline; the spool drains once settings() is called again.
+ *
+ * The documents are built the same way as habitat::Uploader builds them.
+ */
+
+void start();
+void cleanup();
+
+/* Start uploading, or stop and only spool */
+void settings(const std::string &callsign, const std::string &couch_uri,
+              const std::string &couch_db);
+void reset();
+
+/* These may be called from any thread. time_created -1 means now. */
+void payload_telemetry(const std::string &data, const Json::Value &metadata,
+                       int time_created=-1);
+void listener_doc(const std::string &type, const Json::Value &data,
+                  int time_created=-1);
+
+} /* namespace spool */
+} /* namespace dl_fldigi */
+
+#endif /* DL_FLDIGI_SPOOL_H */
@@ -0,0 +1,30 @@
+#ifndef DL_FLDIGI_SSDV_UPLOAD_H
+#define DL_FLDIGI_SSDV_UPLOAD_H
+
+#include <stdint.h>
+
+namespace dl_fldigi {
+namespace ssdv_upload {
+
+/*
+ * Decoded SSDV packets are posted to progdefaults.ssdv_packet_url by one
+ * thread, a few at a time through a curl multi handle that keeps its
+ * connections open between packets.
+ *
+ * Every packet is appended to a spool file in HomeDir until the queue has
+ * drained, so packets received while offline, or while the server can't be
+ * reached, are sent once it can be, even after a restart. A failed upload
+ * is retried with a growing delay.
+ */
+
+void start();                   /* From ready(), once the config is loaded */
+void cleanup();
+void online(bool value);
+void settings();                /* After the URL changes */
+void packet(const uint8_t *pkt, int fixes);    /* May be called from any
+                                                * thread */
+
+} /* namespace ssdv_upload */
+} /* namespace dl_fldigi */
+
+#endif /* DL_FLDIGI_SSDV_UPLOAD_H */
@@ -0,0 +1,38 @@
+#ifndef DL_FLDIGI_STATION_H
+#define DL_FLDIGI_STATION_H
+
+#include <string>
+#include "dl_fldigi/location.h"
+
+namespace dl_fldigi {
+namespace station {
+
+/*
+ * A copy of the settings the uploader, extractor, GPS and SSDV threads need, so
+ * that they can read them without taking the FLTK lock.
+ *
+ * The main thread publish()es a new snapshot whenever one of them might
+ * have changed, and a snapshot is never modified once published. Any
+ * thread may get() the current one without locking; the reference stays
+ * valid until cleanup(), since snapshots are only replaced when the user
+ * changes something and the old ones are kept until then.
+ */
+
+struct snapshot
+{
+    bool online;
+    std::string callsign, habitat_uri, habitat_db;
+    std::string ssdv_packet_url;
+    enum location::location_mode location_mode;
+
+    snapshot() : online(false), location_mode(location::LOC_STATIONARY) {};
+};
+
+void publish();                 /* Main thread only */
+const snapshot &get();
+void cleanup();
+
+} /* namespace station */
+} /* namespace dl_fldigi */
+
+#endif /* DL_FLDIGI_STATION_H */
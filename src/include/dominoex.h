@@ -31,6 +31,7 @@
 #include "modem.h"
 #include "filters.h"
 #include "fftfilt.h"
+#include "nco.h"
 #include "dominovar.h"
 #include "mbuffer.h"
 
@@ -65,7 +66,7 @@ public:
 	};
 protected:
 // common variables
-	double	phase[MAXFFTS + 1];
+	C_NCO	osc[MAXFFTS + 1];
 	double	txphase;
 	int		symlen;
 	int		doublespaced;
@@ -24,6 +24,8 @@ protected:
 	cmplx *freqdata;
 	cmplx *ovlbuf;
 	cmplx *output;
+	cmplx *shifted;
+	int nshift;
 	int inptr;
 	int pass;
 	int window;
@@ -38,6 +40,9 @@ protected:
 				 0.08 * cos(4.0 * M_PI * i / len));
 	}
 	void init_filter();
+	void shift_filter();
+	void real_transform();
+	int process(cmplx *out);
 
 public:
 	fftfilt(double f1, double f2, int len);
@@ -55,6 +60,28 @@ public:
 	void rtty_filter(double);
 
 	int run(const cmplx& in, cmplx **out);
+// Block versions.  out must have room for len + flen/2 values; returns the
+// number of outputs written, a multiple of flen/2.
+	int run(const cmplx *in, int len, cmplx *out);
+// Real input, using a half length real FFT.  With shift() this filters
+// the positive frequencies of a real signal only.
+	int run(const double *in, int len, cmplx *out);
+
+// Moves the passband up to the FFT bin nearest f, a fraction of the
+// sample rate.  The outputs are not mixed back down.
+	void shift(double f);
+
+// Shared input transform.  transform() collects real input as run() does,
+// and returns true when it has transformed a block; run(src, out) then
+// filters that block of src, which must be the same length, with this
+// filter's response.  Any number of filters fed the same input cost one
+// forward FFT between them.  src's own response is not used.
+	bool transform(double in);
+	int run(const fftfilt& src, cmplx **out);
+
+// FFT plans are shared by all filters of the same length
+	static g_fft<double> *get_fft(int len);
+	static void release_fft(int len);
 };
 
 #endif
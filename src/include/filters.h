@@ -30,6 +30,12 @@
 
 #include "complex.h"
 
+#if defined(__AVX__) || defined(__SSE2__)
+#  include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#  include <arm_neon.h>
+#endif
+
 //=====================================================================
 // FIR filters
 //=====================================================================
@@ -70,6 +76,33 @@ private:
 	}
 	inline double mac(const double *a, const double *b, unsigned int size) {
 		double sum = 0.0;
+		// Two vector accumulators, as with the four subsums of the scalar
+		// version, so that each add does not wait for the one before it.
+#if defined(__AVX__)
+		__m256d s1 = _mm256_setzero_pd(), s2 = _mm256_setzero_pd();
+		for (; size > 7; size -= 8, a += 8, b += 8) {
+			s1 = _mm256_add_pd(s1, _mm256_mul_pd(_mm256_loadu_pd(a), _mm256_loadu_pd(b)));
+			s2 = _mm256_add_pd(s2, _mm256_mul_pd(_mm256_loadu_pd(a + 4), _mm256_loadu_pd(b + 4)));
+		}
+		s1 = _mm256_add_pd(s1, s2);
+		__m128d s = _mm_add_pd(_mm256_castpd256_pd128(s1), _mm256_extractf128_pd(s1, 1));
+		sum = _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+#elif defined(__SSE2__)
+		__m128d s1 = _mm_setzero_pd(), s2 = _mm_setzero_pd();
+		for (; size > 3; size -= 4, a += 4, b += 4) {
+			s1 = _mm_add_pd(s1, _mm_mul_pd(_mm_loadu_pd(a), _mm_loadu_pd(b)));
+			s2 = _mm_add_pd(s2, _mm_mul_pd(_mm_loadu_pd(a + 2), _mm_loadu_pd(b + 2)));
+		}
+		s1 = _mm_add_pd(s1, s2);
+		sum = _mm_cvtsd_f64(_mm_add_sd(s1, _mm_unpackhi_pd(s1, s1)));
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+		float64x2_t s1 = vdupq_n_f64(0.0), s2 = vdupq_n_f64(0.0);
+		for (; size > 3; size -= 4, a += 4, b += 4) {
+			s1 = vfmaq_f64(s1, vld1q_f64(a), vld1q_f64(b));
+			s2 = vfmaq_f64(s2, vld1q_f64(a + 2), vld1q_f64(b + 2));
+		}
+		sum = vaddvq_f64(vaddq_f64(s1, s2));
+#else
 		double sum2 = 0.0;
 		double sum3 = 0.0;
 		double sum4 = 0.0;
@@ -82,9 +115,11 @@ private:
 			sum3 += a[2] * b[2];
 			sum4 += a[3] * b[3];
 		}
+		sum += sum2 + sum3 + sum4;
+#endif
 		for (; size; --size)
 			sum += (*a++) * (*b++);
-		return sum + sum2 + sum3 + sum4 ;
+		return sum;
 	}
 
 protected:
@@ -99,6 +134,7 @@ public:
 	double *bp_FIR(int len, int hilbert, double f1, double f2);
 	void dump();
 	int run (const cmplx &in, cmplx &out);
+	int run (const cmplx *in, cmplx *out, int len);
 	int Irun (const double &in, double &out);
 	int Qrun (const double &in, double &out);
 };
@@ -45,6 +45,7 @@
 #include "flslider2.h"
 #include "psk_browser.h"
 #include "re.h"
+#include "modem.h"
 
 extern fre_t seek_re;
 
@@ -205,6 +206,11 @@ extern void set_scope_clear_axis();
 
 extern void set_CWwpm();
 extern void put_rx_char(unsigned int data, int style = FTextBase::RECV, bool extracted = false);
+// A modem thread calls batch_rx_chars() before rx_process() and
+// flush_rx_chars() after it; the characters that it passes to put_rx_char()
+// in between reach the main thread in one request.
+extern void batch_rx_chars(void);
+extern void flush_rx_chars(void);
 extern void put_rx_ssdv(unsigned int data, int lost);
 extern void put_sec_char( char chr );
 
@@ -281,9 +287,12 @@ extern void setSqlOnOff(bool b);
 extern bool QueryAfcOnOff();
 extern bool QuerySqlOnOff();
 
+extern modem* create_modem(trx_mode mode);
 extern void init_modem(trx_mode mode, int freq = 0);
 extern void init_modem_sync(trx_mode mode, int freq = 0);
 extern void init_modem_squelch(trx_mode mode, int freq = 0);
+extern void start_extra_modem(trx_mode mode, int freq = 0,
+			      const modem_settings& settings = modem_settings());
 
 extern void start_tx();
 extern void abort_tx();
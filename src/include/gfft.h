@@ -47,6 +47,8 @@
 #ifndef CGREEN_FFT_H
 #define CGREEN_FFT_H
 
+#include <config.h>
+
 #include <complex>
 
 template <typename FFT_TYPE>
@@ -73,6 +75,12 @@ private:
 
 	FFT_TYPE	*Utbl;
 	short		*BRLow;
+	short		*BRLowReal;
+
+// state of a specialised implementation, see filters/gfft.cxx
+	void		*plan;
+	void init_plan() { plan = 0; }
+	void free_plan() { }
 
 	void fftInit();
 	int ConvertFFTSize(int);
@@ -123,8 +131,10 @@ public:
 		if (M > 268435456) M = 268435456;
 		FFT_size = M;
 		fftInit();
+		init_plan();
 	}
 	~g_fft() {
+		free_plan();
 		for (int i = 0; i < 32; i++) {
 			if (FFT_table_1[i] != 0) delete [] FFT_table_1[i];
 			if (FFT_table_2[i] != 0) delete [] FFT_table_2[i];
@@ -139,6 +149,19 @@ public:
 	FFT_TYPE GetInverseRealFFTScale();
 };
 
+// g_fft<float> is implemented in filters/gfft.cxx, and does not build the
+// tables that the template code below needs.
+#define G_FFT_SPECIALISE(T)						\
+	template <> void g_fft<T>::fftInit();				\
+	template <> void g_fft<T>::init_plan();				\
+	template <> void g_fft<T>::free_plan();				\
+	template <> void g_fft<T>::ComplexFFT(std::complex<T> *buf);	\
+	template <> void g_fft<T>::InverseComplexFFT(std::complex<T> *buf); \
+	template <> void g_fft<T>::RealFFT(std::complex<T> *buf);	\
+	template <> void g_fft<T>::InverseRealFFT(std::complex<T> *buf);
+
+G_FFT_SPECIALISE(float)
+
 //------------------------------------------------------------------------------
 //	Compute Utbl, the cosine table for ffts
 //	of size (pow(2,M)/4 +1)
@@ -3256,11 +3279,15 @@ void g_fft<FFT_TYPE>::fftInit()
 	FFT_table_2[FFT_N/2] = new short[POW2(FFT_N/2 - 1)];
 	fftBRInit(FFT_N, FFT_table_2[FFT_N/2]);
 
-	FFT_table_2[(FFT_N - 1) / 2] = new short[POW2((FFT_N - 1) / 2 - 1)];
-	fftBRInit(FFT_N - 1, FFT_table_2[(FFT_N - 1) / 2]);
+// the real ffts use a complex fft of half the size
+	if (FFT_table_2[(FFT_N - 1) / 2] == 0) {
+		FFT_table_2[(FFT_N - 1) / 2] = new short[POW2((FFT_N - 1) / 2 - 1)];
+		fftBRInit(FFT_N - 1, FFT_table_2[(FFT_N - 1) / 2]);
+	}
 
 	Utbl = ((FFT_TYPE**) FFT_table_1)[FFT_N];
 	BRLow = ((short**) FFT_table_2)[FFT_N / 2];
+	BRLowReal = ((short**) FFT_table_2)[(FFT_N - 1) / 2];
 
 }
 
@@ -3348,7 +3375,7 @@ void g_fft<FFT_TYPE>::RealFFT(std::complex<FFT_TYPE> *buf)
 {
 	void *ptr = buf;
 	FFT_TYPE *nbuf = static_cast<FFT_TYPE *>(ptr);
-	rffts1(nbuf, FFT_N, Utbl, BRLow);
+	rffts1(nbuf, FFT_N, Utbl, BRLowReal);
 }
 
 //------------------------------------------------------------------------------
@@ -3365,7 +3392,7 @@ void g_fft<FFT_TYPE>::InverseRealFFT(std::complex<FFT_TYPE> *buf)
 {
 	void *ptr = buf;
 	FFT_TYPE *nbuf = static_cast<FFT_TYPE *>(ptr);
-	riffts1(nbuf, FFT_N, Utbl, BRLow);
+	riffts1(nbuf, FFT_N, Utbl, BRLowReal);
 }
 
 //------------------------------------------------------------------------------
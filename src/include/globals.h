@@ -221,6 +221,9 @@ struct mode_info_t {
 };
 extern const struct mode_info_t mode_info[NUM_MODES];
 
+// Returns the mode whose number or short name is `name', or NUM_MODES
+trx_mode mode_by_name(const char* name);
+
 class qrg_mode_t
 {
 public:
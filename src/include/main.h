@@ -78,6 +78,7 @@ extern int			arq_get_char();
 extern void			arq_init();
 extern void			arq_close();
 extern void			WriteARQ(unsigned char);
+extern void			WriteARQ(const char *data, size_t len);
 extern void			checkTLF();
 
 void check_nbems_dirs(void);
@@ -34,6 +34,7 @@
 #include "globals.h"
 #include "modem.h"
 #include "filters.h"
+#include "nco.h"
 #include "interleave.h"
 #include "viterbi.h"
 #include "complex.h"
@@ -144,6 +145,7 @@ enum {
 protected:
 // general
 	double phaseacc;
+	C_NCO rxosc;
 	int symlen;
 	int symbits;
 	int numtones;
@@ -18,9 +18,18 @@
 
 #define TWOPI (2.0 * M_PI)
 
+/// Receive settings that an extra modem carries for itself instead of reading
+/// them from progdefaults.  A negative value leaves the progdefaults one.
+struct modem_settings {
+	double	rtty_baud;
+	double	rtty_shift;	// Hz
+	int	rtty_stop;	// as progdefaults.rtty_stop: 0, 1, 2 for 1, 1.5, 2 bits
+	modem_settings() : rtty_baud(-1.0), rtty_shift(-1.0), rtty_stop(-1) { }
+};
+
 class modem {
 public:
-	static double	frequency;
+	double		frequency;
 	static double	tx_frequency;
 	static bool	freqlock;
 protected:
@@ -58,6 +67,8 @@ protected:
 	double outbuf[OUTBUFSIZE];
 
 	bool	historyON;
+	bool	extra;
+	modem_settings settings;
 	Digiscope::scope_mode scopemode;
 
 	int scptr;
@@ -93,6 +104,13 @@ public:
 	void		HistoryON(bool val) {historyON = val;}
 	bool		HistoryON() const { return historyON;}
 
+	/// Extra modems receive alongside the active modem (see trx_add_modem)
+	/// and leave the transmit frequency and main window alone.
+	void		set_extra(bool val) { extra = val; }
+	bool		is_extra() const { return extra; }
+	/// Takes effect at the next restart()
+	void		set_settings(const modem_settings& s) { settings = s; }
+
 	/// Inlined const getters are faster and smaller.
 	trx_mode	get_mode() const { return mode; };
 	const char	*get_mode_name() const { return mode_info[get_mode()].sname;}
@@ -0,0 +1,102 @@
+// ----------------------------------------------------------------------------
+// nco.h  --  numerically controlled oscillator
+//
+// This file is part of fldigi.
+//
+// Fldigi is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Fldigi is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with fldigi.  If not, see <http://www.gnu.org/licenses/>.
+// ----------------------------------------------------------------------------
+
+#ifndef NCO_H
+#define NCO_H
+
+#include <cmath>
+#include "complex.h"
+
+// samples between renormalisations of the rotator
+#define NCO_RENORM 256
+
+// A complex rotator that is advanced by one complex multiplication per sample
+// in place of cos() and sin() of a phase accumulator.  The step is only
+// recomputed when it changes, so callers whose frequency follows the AFC may
+// set it on every sample.  Rounding would let the magnitude of the rotator
+// drift, so it is pulled back to 1 every NCO_RENORM samples.
+
+class C_NCO {
+public:
+	C_NCO() : rot(1.0, 0.0), inc(1.0, 0.0), step(0.0), count(0) { }
+
+	// phase advance per sample, in radians
+	void set_step(double dphi) {
+		if (dphi == step)
+			return;
+		step = dphi;
+		inc = cmplx(cos(dphi), sin(dphi));
+	}
+	void set_freq(double f, double samplerate) { set_step(2.0 * M_PI * f / samplerate); }
+	void reset() { rot = cmplx(1.0, 0.0); count = 0; }
+
+	// Returns exp(j * phase) and advances the phase by one step
+	cmplx next() {
+		cmplx z = rot;
+		rot *= inc;
+		if (++count == NCO_RENORM)
+			renorm();
+		return z;
+	}
+	cmplx mix(const cmplx& in) { return in * next(); }
+
+	// out[i] = in[i] * exp(j * phase) for a block of samples
+	void mix(cmplx *out, const double *in, int len) {
+		while (len > 0) {
+			int n = len < NCO_RENORM - count ? len : NCO_RENORM - count;
+			for (int i = 0; i < n; i++) {
+				out[i] = in[i] * rot;
+				rot *= inc;
+			}
+			out += n;
+			in += n;
+			len -= n;
+			if ((count += n) == NCO_RENORM)
+				renorm();
+		}
+	}
+	void mix(cmplx *out, const cmplx *in, int len) {
+		while (len > 0) {
+			int n = len < NCO_RENORM - count ? len : NCO_RENORM - count;
+			for (int i = 0; i < n; i++) {
+				out[i] = in[i] * rot;
+				rot *= inc;
+			}
+			out += n;
+			in += n;
+			len -= n;
+			if ((count += n) == NCO_RENORM)
+				renorm();
+		}
+	}
+
+private:
+	// first order correction, enough for the error left after NCO_RENORM steps
+	void renorm() {
+		rot *= 0.5 * (3.0 - norm(rot));
+		count = 0;
+	}
+
+	cmplx rot;
+	cmplx inc;
+	double step;
+	int count;
+};
+
+#endif
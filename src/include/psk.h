@@ -24,11 +24,14 @@
 #ifndef _PSK_H
 #define _PSK_H
 
+#include <vector>
+
 #include "complex.h"
 #include "modem.h"
 #include "globals.h"
 #include "viterbi.h"
 #include "filters.h"
+#include "nco.h"
 #include "pskcoeff.h"
 #include "pskvaricode.h"
 #include "viewpsk.h"
@@ -68,6 +71,8 @@ private:
 	double 			inter_carrier; // Frequency gap betweeb carriers
 
 // rx variables & functions
+	C_NCO			rxnco[MAX_CARRIERS];
+	std::vector<cmplx>	rxmix;
 	C_FIR_filter		*fir1[MAX_CARRIERS];
 	C_FIR_filter		*fir2[MAX_CARRIERS];
 //	C_FIR_filter		*fir3;
@@ -114,6 +119,7 @@ private:
 	int				dcdbits;
 	cmplx			quality;
 	int				acquire;
+	double			averageamp;
 
 	viewpsk*		pskviewer;
 	pskeval*		evalpsk;
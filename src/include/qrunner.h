@@ -99,19 +99,21 @@ public:
         void attach(void);
         void detach(void);
 
+        // The doorbell is only rung when the queue goes from empty to
+        // non-empty; execute() then runs everything that is queued.
         template <typename F>
         bool request(const F& f)
         {
                 if (fifo->push(f)) {
-#ifdef NDEBUG
-                        if (unlikely(QRUNNER_WRITE(pfd[1], "", 1) != 1))
-                                throw qexception(errno);
-#else
-                        assert(QRUNNER_WRITE(pfd[1], "", 1) == 1);
-#endif
+                        size_t depth = fifo->size();
+                        if (unlikely(depth > hwm))
+                                hwm = depth;
+                        if (__sync_fetch_and_or(&pending, 1) == 0)
+                                ring();
                         return true;
                 }
 
+                ndropped++;
 #ifndef NDEBUG
 //Remi's extra debugging info		LOG_ERROR("qrunner: thread %" PRIdPTR " fifo full!", GET_THREAD_ID());
 		LOG_ERROR("qrunner: thread %" PRIdPTR " fifo full at %s!", GET_THREAD_ID(),typeid(F).name() );
@@ -151,12 +153,20 @@ public:
 
         void drop(void) { fifo->drop(); }
         size_t size(void) { return fifo->size(); }
+        // Largest number of queued requests, and number of requests
+        // dropped because the queue was full
+        size_t high_water(void) { return hwm; }
+        size_t dropped(void) { return ndropped; }
 
 protected:
+        void ring(void);
+
         fqueue *fifo;
         int pfd[2];
         bool attached;
 	bool inprog;
+        volatile int pending;
+        size_t hwm, ndropped;
 public:
 	bool drop_flag;
 };
@@ -164,7 +174,7 @@ public:
 
 extern qrunner *cbq[NUM_QRUNNER_THREADS];
 
-#if BENCHMARK_MODE
+#if DECODER_MODE
 #define REQ(...) ((void)0)
 #define REQ_DROP(...) ((void)0)
 #define REQ_SYNC(...) ((void)0)
@@ -227,7 +237,7 @@ extern qrunner *cbq[NUM_QRUNNER_THREADS];
 		if ((GET_THREAD_ID() != FLMAIN_TID))		\
 			cbq[GET_THREAD_ID()]->drop_flag = v_;	\
 	} while (0)
-#endif // BENCHMARK_MODE
+#endif // DECODER_MODE
 
 #endif // QRUNNER_H_
 
@@ -47,38 +47,60 @@
 #include <cstring>
 #include "util.h"
 
+#ifndef RB_CACHE_LINE
+#  define RB_CACHE_LINE 64
+#endif
+
+// A mirrored ringbuffer maps its memory twice, back to back, so that the
+// vectors returned by get_rv, get_wv and get_rv_at never wrap: v[1].len is
+// always 0.  This needs the buffer to be a whole number of pages, and
+// mmap; if mirroring is not possible the buffer is an ordinary one, so
+// callers must still handle two part vectors.
 template <typename T>
 class ringbuffer
 {
 protected:
         size_t size, big_mask, small_mask;
         T* buf;
-        volatile size_t ridx, widx;
+        bool mirror;
+        // keep the indices on cache lines of their own, so that an update
+        // by one side does not evict the other side's index or the fields
+        // above
+        char pad0_[RB_CACHE_LINE];
+        volatile size_t widx;
+        char pad1_[RB_CACHE_LINE - sizeof(size_t)];
+        volatile size_t ridx;
+        char pad2_[RB_CACHE_LINE - sizeof(size_t)];
 public:
         typedef T value_type;
         typedef struct { value_type* buf; size_t len; } vector_type;
 
 public:
-        ringbuffer(size_t s)
-                : ridx(0), widx(0)
+        ringbuffer(size_t s, bool mirrored = false)
+                : widx(0), ridx(0)
         {
                 assert(powerof2(s));
 
                 size = s;
                 big_mask = size * 2 - 1;
                 small_mask = size - 1;
-                buf = new T[size];
+                buf = mirrored ? static_cast<T*>(mirror_alloc(size * sizeof(T))) : 0;
+                mirror = buf != 0;
+                if (!buf)
+                        buf = new T[size];
         }
         ~ringbuffer()
         {
-                delete [] buf;
+                if (mirror)
+                        mirror_free(buf, size * sizeof(T));
+                else
+                        delete [] buf;
         }
 
 
         size_t read_space(void)
         {
-                read_memory_barrier();
-                return (widx - ridx) & big_mask;
+                return (load_index(widx) - load_index(ridx)) & big_mask;
         }
         size_t write_space(void)
         {
@@ -87,36 +109,21 @@ public:
 
         void read_advance(size_t n)
         {
-                write_memory_barrier();
-                ridx = (ridx + n) & big_mask;
+                store_index(ridx, (ridx + n) & big_mask);
         }
         void write_advance(size_t n)
         {
-                write_memory_barrier();
-                widx = (widx + n) & big_mask;
+                store_index(widx, (widx + n) & big_mask);
         }
 
         size_t get_rv(vector_type v[2], size_t n = 0)
         {
                 size_t rspace = read_space();
-                size_t index = ridx & small_mask;
 
                 if (n == 0 || n > rspace)
                         n = rspace;
 
-                if (index + n > size) { // two part vector
-                        v[0].buf = buf + index;
-                        v[0].len = size - index;
-                        v[1].buf = buf;
-                        v[1].len = n - v[0].len;
-                }
-                else {
-                        v[0].buf = buf + index;
-                        v[0].len = n;
-                        v[1].len = 0;
-                }
-
-                return n;
+                return vectors(v, ridx, n);
         }
         size_t read(T* dst, size_t n)
         {
@@ -142,27 +149,33 @@ public:
                 return n;
         }
 
+        // For readers that keep their own cursor instead of using the read
+        // pointer.  `idx' counts elements written, starting from a value
+        // returned by write_index(); nothing stops the writer from
+        // overwriting the data, so such readers must keep well behind it.
+        size_t write_index(void)
+        {
+                return load_index(widx);
+        }
+        size_t get_rv_at(vector_type v[2], size_t idx, size_t n)
+        {
+                return vectors(v, idx, n);
+        }
+        // Elements written since idx; idx must be less than 2 * length()
+        // behind the writer
+        size_t read_space_at(size_t idx)
+        {
+                return (load_index(widx) - idx) & big_mask;
+        }
+
         size_t get_wv(vector_type v[2], size_t n = 0)
         {
                 size_t wspace = write_space();
-                size_t index = widx & small_mask;
 
                 if (n == 0 || n > wspace)
                         n = wspace;
 
-                if (index + n > size) { // two part vector
-                        v[0].buf = buf + index;
-                        v[0].len = size - index;
-                        v[1].buf = buf;
-                        v[1].len = n - v[0].len;
-                }
-                else {
-                        v[0].buf = buf + index;
-                        v[0].len = n;
-                        v[1].len = 0;
-                }
-
-                return n;
+                return vectors(v, widx, n);
         }
         size_t write(const T* src, size_t n)
         {
@@ -194,6 +207,50 @@ public:
         void reset(void) { ridx = widx = 0; }
         size_t length(void) { return size; }
         size_t bytes(void) { return size * sizeof(T); }
+        bool mirrored(void) { return mirror; }
+
+protected:
+        // The reader publishes ridx and the writer widx, each with release
+        // semantics, and each loads the other's index with acquire semantics
+        static size_t load_index(const volatile size_t& i)
+        {
+#if defined(__ATOMIC_ACQUIRE)
+                return __atomic_load_n(&i, __ATOMIC_ACQUIRE);
+#else
+                size_t v = i;
+                read_memory_barrier();
+                return v;
+#endif
+        }
+        static void store_index(volatile size_t& i, size_t v)
+        {
+#if defined(__ATOMIC_RELEASE)
+                __atomic_store_n(&i, v, __ATOMIC_RELEASE);
+#else
+                write_memory_barrier();
+                i = v;
+#endif
+        }
+
+        // Fills v with the n elements that start at index idx
+        size_t vectors(vector_type v[2], size_t idx, size_t n)
+        {
+                size_t index = idx & small_mask;
+
+                if (index + n > size && !mirror) { // two part vector
+                        v[0].buf = buf + index;
+                        v[0].len = size - index;
+                        v[1].buf = buf;
+                        v[1].len = n - v[0].len;
+                }
+                else {
+                        v[0].buf = buf + index;
+                        v[0].len = n;
+                        v[1].len = 0;
+                }
+
+                return n;
+        }
 };
 
 #endif // RINGBUFFER_H
@@ -43,6 +43,7 @@
 
 #include <string>
 
+#include <stdint.h>
 #include <samplerate.h>
 
 #include "ringbuffer.h"
@@ -70,11 +71,22 @@ enum {
 	RSID_BANDWIDTH_WIDE,
 };
 
-typedef double rs_fft_type;
+// single precision is ample for finding the RSID tones
+typedef float rs_fft_type;
 typedef std::complex<rs_fft_type> rs_cpx_type;
 
 struct RSIDs { unsigned short rs; trx_mode mode; const char* name; };
 
+// A detection, passed from the thread that runs receive() to the trx thread.
+// pos is the receive position at which it was made, in the units of the
+// position passed to receive().
+struct rsid_event {
+	int bin;
+	int symbol;
+	int extended;
+	size_t pos;
+};
+
 class cRsId {
 
 protected:
@@ -84,6 +96,9 @@ private:
 	// Table of precalculated Reed Solomon symbols
 	unsigned char   *pCodes1;
 	unsigned char   *pCodes2;
+	// The same codes packed as bucket words, see bucket_planes
+	uint64_t		*pWords1;
+	uint64_t		*pWords2;
 
 	bool found1;
 	bool found2;
@@ -116,7 +131,14 @@ private:
 	int		iPrevBin;
 	int		iPrevSymbol;
 
-	int		fft_buckets[RSID_NTIMES][RSID_FFT_SIZE];
+	// Newest time slice of buckets
+	int		fft_buckets[RSID_FFT_SIZE];
+	// The last RSID_NSYMBOLS buckets of each bin, every other time slice,
+	// as 4 bit planes in the 16 bit lanes of a word; bit i of lane b is
+	// bit b of symbol i.  One set ends with the newest slice, the other
+	// with the one before, and cur_planes is the index of the first.
+	uint64_t	bucket_planes[2][RSID_FFT_SIZE];
+	int		cur_planes;
 
 	bool	bPrevTimeSliceValid2;
 	int		iPrevDistance2;
@@ -128,6 +150,11 @@ private:
 	SRC_DATA	src_data;
 	int			inptr;
 	static long	src_callback(void* cb_data, float** data);
+	// position of the input being searched
+	size_t		rxpos;
+
+// detections waiting for the trx thread
+	ringbuffer<rsid_event>	events;
 
 // transmit
 	double	*outbuf;
@@ -138,18 +165,23 @@ private:
 private:
 	void	Encode(int code, unsigned char *rsid);
 	void	search(void);
+	void	post(int iBin, int iSymbol, int extended);
 	void	setup_mode(int m);
 
 	void	CalculateBuckets(const rs_fft_type *pSpectrum, int iBegin, int iEnd);
-	inline int		HammingDistance(int iBucket, unsigned char *p2);
-	bool	search_amp( int &bin_out, int &symbol_out, unsigned char *pcode_table );
+	static uint64_t	PackSymbols(const unsigned char *rsid);
+	void	UpdatePlanes(void);
+	inline int		HammingDistance(int iBucket, uint64_t code);
+	bool	search_amp( int &bin_out, int &symbol_out, const uint64_t *pcode_table );
 	void	apply ( int iBin, int iSymbol, int extended );
 
 public:
 	cRsId();
 	~cRsId();
 	void	reset();
-	void	receive(const float* buf, size_t len);
+	void	receive(const float* buf, size_t len, size_t pos);
+	void	apply_pending(size_t pos);
+	void	clear_pending(void);
 	void	send(bool postidle);
 	bool	assigned(trx_mode mode);
 
@@ -30,12 +30,14 @@
 #define _RTTY_H
 
 #include <iostream>
+#include <vector>
 
 #include "complex.h"
 #include "modem.h"
 #include "globals.h"
 #include "filters.h"
 #include "fftfilt.h"
+#include "nco.h"
 #include "digiscope.h"
 
 #define	RTTY_SampleRate	8000
@@ -114,6 +116,8 @@ private:
 	double		samplerate;
 };
 
+class view_rtty;
+
 //enum TTY_MODE { LETTERS, FIGURES };
 
 class rtty : public modem {
@@ -155,15 +159,21 @@ private:
 
 	bool		bit_buf[MAXBITS];
 
-	double mark_phase;
-	double space_phase;
+	C_NCO mark_osc;
+	C_NCO space_osc;
 	fftfilt *mark_filt;
 	fftfilt *space_filt;
+	std::vector<cmplx> mark_buf;
+	std::vector<cmplx> space_buf;
 
 	double *pipe;
 	double *dsppipe;
 	int pipeptr;
 
+	view_rtty *rttyviewer;
+	int showxy;
+	int bitcount;
+
 	cmplx mark_history[MAXPIPE];
 	cmplx space_history[MAXPIPE];
 
@@ -217,7 +227,7 @@ private:
 	void Update_syncscope();
 
 	double IF_freq;
-	inline cmplx mixer(double &phase, double f, cmplx in);
+	inline cmplx mixer(C_NCO &osc, double f, cmplx in);
 
 	unsigned char Bit_reverse(unsigned char in, int n);
 	int decode_char();
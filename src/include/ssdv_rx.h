@@ -4,6 +4,10 @@
 #ifndef _SSDV_RX_H
 #define _SSDV_RX_H
 
+#include <string>
+#include <vector>
+#include <pthread.h>
+
 #include <FL/Fl_Double_Window.H>
 #include <FL/Fl_Box.H>
 #include <FL/Fl_Image.H>
@@ -11,6 +15,7 @@
 #include <FL/Fl_Scroll.H>
 
 #include "ssdv.h"
+#include "ringbuffer.h"
 
 class ssdv_rx : public Fl_Double_Window
 {
@@ -30,6 +35,54 @@ private:
 	
 	Fl_Progress *flprogress;
 	
+	/* Image shown in the window, owned by the GUI thread */
+	uint8_t *image;
+	int image_shown_width;
+	int image_shown_height;
+	
+	/* The SSDV thread takes the bytes passed to put_byte(), finds and
+	 * corrects the packets, and decodes and renders the image. Only the
+	 * rows of the rendered image that changed are handed to the GUI
+	 * thread, which take_update() copies into place. */
+	struct rx_byte {
+		uint8_t byte;
+		int lost;
+	};
+	
+	ringbuffer<rx_byte> *input;
+	int input_lost;
+	
+	pthread_t rx_thread;
+	pthread_mutex_t rx_mutex;
+	pthread_cond_t rx_cond;
+	bool rx_running;
+	bool rx_quit;
+	bool rx_pending;
+	
+	/* Details shown below the image */
+	struct rx_status {
+		uint32_t callsign;
+		int image_id;
+		int width;
+		int height;
+		int received;
+		int lost;
+		int errors;
+		int mcu_id;
+		int mcu_count;
+	};
+	
+	/* Handed to the GUI thread, guarded by rx_mutex */
+	rx_status status;
+	bool status_ready;
+	std::vector<std::string> messages;
+	uint8_t *frame;
+	int frame_width;
+	int frame_height;
+	int frame_row;  /* First row changed since the last take_update(), or -1 */
+	
+	/* The rest is only used by the SSDV thread */
+	
 	/* RX buffer */
 	static const int BUFFER_SIZE = SSDV_PKT_SIZE * 2;
 	
@@ -41,8 +94,21 @@ private:
 	/* Packet and RGB image buffer */
 	uint8_t *packets;
 	int packets_len;
-	uint8_t *image;
-	size_t image_len;
+	uint8_t *rgb;
+	size_t rgb_len;
+	
+	/* Decoder state, fed with packets 0 to dec_next - 1 */
+	ssdv_t dec;
+	bool dec_ok;
+	int dec_next;
+	
+	/* First image row changed since the last update_image() */
+	int dirty_row;
+	
+	/* The image is saved and rendered at most once per UPDATE_INTERVAL */
+	static const double UPDATE_INTERVAL;
+	struct timespec update_due;
+	bool update_dirty;
 	
 	/* Last packet details */
 	ssdv_packet_info_t pkt_info;
@@ -59,16 +125,28 @@ private:
 	int image_errors;
 	
 	/* Private functions */
+	static void *rx_loop(void *arg);
+	void rx_process();
+	void process_byte(uint8_t byte, int lost);
 	void feed_buffer(uint8_t byte, uint8_t erasure);
 	void clear_buffer();
-	void upload_packet(int fixes);
 	void save_image(uint8_t *jpeg, size_t length);
 	void render_image(uint8_t *jpeg, size_t length);
+	void reset_decoder();
+	void feed_decoder(int last);
+	void mark_dirty(int mcu_id);
+	void update_image();
+	void request_update(bool now);
+	void publish(const char *msg);
+	void notify();
+	void take_update();
 	
 public:
 	ssdv_rx(int w, int h, const char *title);
 	~ssdv_rx();
 	
+	/* Queues a received byte for the SSDV thread. May be called from any
+	 * thread. */
 	void put_byte(uint8_t byte, int lost);
 };
 
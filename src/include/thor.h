@@ -137,6 +137,21 @@ protected:
 	
 	int fec_confidence;
 
+// soft decoder history
+	int		lastc;
+	int		lastmag;
+	int		nowmag;
+	int		prev1rawdoppler;
+	double	lastdoppler;
+	double	nowdoppler;
+	bool	lastCWI[MAXPATHS];
+	bool	nextCWI[MAXPATHS];
+
+// preamble detector
+	int		preamblecheck;
+	int		twocount;
+	bool	neg16seen;
+
 // tx variables
 	int txstate;
 	int txprevtone;
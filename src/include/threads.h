@@ -39,7 +39,9 @@ int pthread_cond_timedwait_rel(pthread_cond_t* cond, pthread_mutex_t* mutex, dou
 
 enum {
 	INVALID_TID = -1,
-	TRX_TID, QRZ_TID, RIGCTL_TID, NORIGCTL_TID, EQSL_TID, ADIF_RW_TID,
+	TRX_TID, RXMODEM_TID, RSID_TID, DTMF_TID, WF_TID, SSDV_TID, EXTRACT_TID,
+	EXTRA_MODEM_TID, EXTRA_MODEM_LAST_TID = EXTRA_MODEM_TID + 3,
+	QRZ_TID, RIGCTL_TID, NORIGCTL_TID, EQSL_TID, ADIF_RW_TID,
 	XMLRPC_TID,
 	ARQ_TID, ARQSOCKET_TID,
 	FLMAIN_TID,
@@ -43,6 +43,28 @@ extern	void	trx_tune();
 extern	void	trx_receive();
 
 extern	void	trx_reset(void);
+extern	void	trx_rx_flush(void);
+
+// Extra modems receive the same audio as the active modem, each on its own
+// thread, until they are removed.  Each has its own modem_settings, so that
+// two RTTY modems can run at different speeds.  trx_add_modem returns the
+// new modem's index, or -1 if there is no free slot.
+#define NUM_EXTRA_MODEMS (EXTRA_MODEM_LAST_TID - EXTRA_MODEM_TID + 1)
+extern	int	trx_add_modem(trx_mode mode, int freq,
+			      const modem_settings& settings = modem_settings());
+extern	void	trx_remove_modem(int i);
+extern	bool	trx_extra_mode_ok(trx_mode mode);
+
+// Returns the index of the extra modem that runs on this thread, or -1
+inline int trx_extra_modem(void)
+{
+	int t = GET_THREAD_ID();
+	return t >= EXTRA_MODEM_TID && t <= EXTRA_MODEM_LAST_TID ? t - EXTRA_MODEM_TID : -1;
+}
+
+// Returns the modem whose receive runs on this thread: one of the extra
+// modems, or active_modem
+extern	modem*	trx_rx_modem(void);
 
 extern	void	trx_wait_state(void);
 
@@ -159,6 +159,12 @@ void restore_signals(void);
 
 void MilliSleep(long msecs);
 
+/* Returns 2 * len bytes in which the second len bytes are the first len bytes
+ * mapped again, or NULL if len is not a whole number of pages or the mapping
+ * is not supported */
+void* mirror_alloc(size_t len);
+void mirror_free(void* p, size_t len);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -32,6 +32,8 @@
 #include "globals.h"
 #include "filters.h"
 #include "fftfilt.h"
+#include "channelizer.h"
+#include "nco.h"
 #include "digiscope.h"
 
 #define	VIEW_RTTY_SampleRate	8000
@@ -40,6 +42,10 @@
 
 #define MAX_CHANNELS 30
 
+// channelizer bins and prototype length
+#define VIEW_RTTY_BINS 64
+#define VIEW_RTTY_TAPS 256
+
 enum CHANNEL_STATE {IDLE, SRCHG, RCVNG, WAITING};
 
 struct RTTY_CHANNEL {
@@ -57,8 +63,8 @@ struct RTTY_CHANNEL {
 
 	bool		bit_buf[MAXBITS];
 
-	double mark_phase;
-	double space_phase;
+	C_NCO mark_osc;
+	C_NCO space_osc;
 
 	double		metric;
 
@@ -121,6 +127,11 @@ private:
 
 	RTTY_CHANNEL	channel[MAX_CHANNELS];
 
+	channelizer	*chan;
+	int			decimate;
+// shared transform of the input when there is no decimation
+	fftfilt		*input;
+
 	double		rtty_squelch;
 	double		rtty_shift;
 	double      rtty_BW;
@@ -139,12 +150,13 @@ private:
 
 	void clear_syncscope();
 	void update_syncscope();
-	cmplx mixer(double &phase, double f, cmplx in);
+	cmplx mixer(C_NCO &osc, double f, cmplx in);
 
 	unsigned char bitreverse(unsigned char in, int n);
 	int decode_char(int ch);
 	int rttyparity(unsigned int);
 	bool rx(int ch, bool bit);
+	void demodulate(int ch, cmplx *zp_mark, cmplx *zp_space, int n);
 
 	int rttyxprocess();
 	char baudot_dec(int ch, unsigned char data);
@@ -27,6 +27,8 @@
 #include "modem.h"
 #include "globals.h"
 #include "filters.h"
+#include "channelizer.h"
+#include "nco.h"
 #include "pskeval.h"
 
 //=====================================================================
@@ -37,10 +39,13 @@
 #define VSIGSEARCH 5
 #define VWAITCOUNT 4
 #define NULLFREQ 1e6
+// channelizer bins and prototype length
+#define VCHANBINS 64
+#define VCHANTAPS 256
 //=====================================================================
 
 struct CHANNEL {
-	double			phaseacc;
+	C_NCO			osc;
 	cmplx			prevsymbol;
 	cmplx			quality;
 	unsigned int	shreg;
@@ -51,7 +56,6 @@ struct CHANNEL {
 	double			phase;
 	double			syncbuf[16];
 
-	C_FIR_filter	*fir1;
 	C_FIR_filter	*fir2;
 	
 	int				bits;
@@ -83,6 +87,7 @@ private:
 	bool		browser_changed;
 
 	CHANNEL		channel[MAXCHANNELS];
+	channelizer	*chan;
 	int			nchannels;
 	int			lowfreq;
 
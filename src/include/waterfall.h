@@ -30,7 +30,12 @@
 #include <FL/Fl_Counter.H>
 #include <FL/Fl_Box.H>
 
+#include <pthread.h>
+
 #include "gfft.h"
+#include "ringbuffer.h"
+#include "nco.h"
+#include "filters.h"
 #include "fldigi-config.h"
 #include "digiscope.h"
 #include "flslider2.h"
@@ -58,9 +63,10 @@ struct RGBI {
 };
 
 // you can change the basic fft processing type by a simple change in the
-// following typedef.  change to float if you need to skimp on cpu cycles.
+// following typedef.  g_fft<float> is the faster of the two and double
+// precision gains nothing on the display.
 
-typedef double wf_fft_type;
+typedef float wf_fft_type;
 typedef std::complex<wf_fft_type> wf_cpx_type;
 
 extern	RGBI	mag2RGBI[256];
@@ -70,6 +76,7 @@ enum WFmode {
 	WATERFALL,
 	SPECTRUM,
 	SCOPE,
+	ZOOM,
 	NUM_WF_MODES
 };
 
@@ -91,15 +98,11 @@ public:
 	int setMag(int m);
 	void setOffset(int v);
 
-	void Mode(WFmode M) {
-		mode = M;
-	}
+	void Mode(WFmode M);
 	WFmode Mode() {
 		return mode;
 	}
-	int cursorFreq(int xpos) {
-		return (offset + step * xpos);
-	}
+	int cursorFreq(int xpos);
 	void Ampspan(double AmpSpn) {
 		ampspan = (int)AmpSpn;
 	}
@@ -147,8 +150,7 @@ public:
 	inline void  makeNotch_(int notch_frequency);
 	inline void makeMarker_(int width, const RGB* color, int freq, const RGB* clrMin, RGB* clrM, const RGB* clrMax);
 	void makeMarker();
-	void process_analog(wf_fft_type *sig, int len);
-	void processFFT();
+	void process_analog(double *sig, int len);
 	void sig_data( double *sig, int len, int sr );
 	void rfcarrier(long long f) {
 		rfc = f;
@@ -201,6 +203,7 @@ private:
 	bool	cursormoved;
 	WFspeed	wfspeed;
 	int		srate;
+	int		in_srate;
 	RGBI	*fft_img;
 	RGB		*markerimage;
 	RGB		RGBmarker;
@@ -214,23 +217,100 @@ private:
 
 	wf_cpx_type *wfbuf;
 
+// fft_db and fft_img are rings of image_height rows; the newest row is
+// ring_top() and older rows follow it, wrapping at image_height.
 	short int	*fft_db;
 	int			ptrFFTbuff;
+	int			palette_gen;
+	int			img_palette;
+	int			img_stale;
+	int			img_offset;
+	int			img_step;
+	int			img_width;
+	bool		img_averaging;
 	double		*circbuff;
 	int			ptrCB;
 	wf_fft_type	*pwr;
 	g_fft<wf_fft_type> *wfft;
 	int     prefilter;
 
+// The waterfall thread turns the audio passed to sig_data() into finished
+// rows, which take_rows() copies into the history on the GUI thread.
+	struct wf_row {
+		short int	*db;
+		RGBI		*img;
+		wf_fft_type	*pwr;
+		int			offset;
+		int			step;
+		int			width;
+		bool		averaging;
+		int			palette;
+		bool		zoom;
+		double		centre;
+		int			zmag;
+	};
+	wf_row		*rows;
+	size_t		rows_head;
+	size_t		rows_tail;
+	ringbuffer<double> *wf_input;
+	double		*scopebuf;
+	bool		scope_ready;
+	pthread_t	wf_thread;
+	pthread_mutex_t wf_mutex;
+	pthread_cond_t	wf_cond;
+	bool		wf_running;
+	bool		wf_quit;
+	bool		wf_pending;
+
+	static void *wf_loop(void *arg);
+	void wf_process();
+	bool wf_block(const double *sig, int len, int sr, wf_row *row);
+	bool processFFT(wf_row *row);
+
+// In ZOOM mode the band around zoom_centre is mixed down, decimated and
+// given its own ZOOM_LEN point FFT.  zp_* are the waterfall thread's copies
+// of the GUI settings.
+	double		zoom_centre;
+	bool		zp_on;
+	double		zp_centre;
+	int			zp_mag;
+	double		zoom_at;
+	int			zoom_dec;
+	int			zoom_srate;
+	C_NCO		zoom_nco;
+	C_FIR_filter *zoom_filt;
+	cmplx		*zoom_buf;
+	int			zoom_ptr;
+	wf_cpx_type	*zoom_fbuf;
+	double		*zoom_window;
+	g_fft<wf_fft_type> *zoom_fft;
+
+	static double zoom_hzpp(int m);
+	void zoom_input(const double *sig, int len);
+	void zoom_row(wf_row *row);
+	void makeWindow(int v);
+	void take_rows();
+	void update_freq();
+
 
 	int checkMag();
 	void checkWidth();
 	void initMarkers();
 	void makeScale();
 	void drawScale();
+	void drawZoomScale();
 	void drawMarker();
 
 	int	 log2disp(int v);
+	int  ring_top() { return (ptrFFTbuff + 1) % image_height; }
+	int  view_offset() { return mode == ZOOM ? 0 : offset; }
+	int  view_step() { return mode == ZOOM ? 1 : step; }
+	int  freq2x(double f);
+	void clear_history();
+	void update_row(int row);
+	static void colour_row(const short int *db, RGBI *img, int offset, int step,
+			       int width, bool averaging);
+	void drawoverlays();
 	void drawcolorWF();
 	void drawgrayWF();
 	void drawspectrum();
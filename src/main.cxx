@@ -29,6 +29,8 @@
 #include <iostream>
 #include <iomanip>
 #include <sstream>
+#include <vector>
+#include <utility>
 #include <cstdlib>
 #include <getopt.h>
 #include <sys/types.h>
@@ -109,8 +111,10 @@
 
 #include "xmlrpc.h"
 
-#if BENCHMARK_MODE
+#if DECODER_MODE
+	#include "decoder.h"
 	#include "benchmark.h"
+	#include "dl_fldigi/hbtint.h"
 #endif
 
 #include "icons.h"
@@ -179,8 +183,17 @@ cLogfile	*Maillogfile = (cLogfile *)0;
 FILE	*server;
 FILE	*client;
 bool	mailserver = false, mailclient = false, arqmode = false;
+#if !DECODER_MODE
 static bool show_cpucheck = false;
 static bool iconified = false;
+struct extra_modem_arg {
+	trx_mode mode;
+	int freq;
+	modem_settings settings;
+};
+static vector<extra_modem_arg> extra_modems;
+static bool parse_modem_settings(const string& opts, modem_settings& s);
+#endif
 
 string option_help, version_text, build_text;
 
@@ -191,10 +204,12 @@ void generate_option_help(void);
 int parse_args(int argc, char **argv, int& idx);
 void generate_version_text(void);
 void debug_exec(char** argv);
+#if !DECODER_MODE
 void set_platform_ui(void);
 double speed_test(int converter, unsigned repeat);
-static void setup_signal_handlers(void);
 static void checkdirectories(void);
+#endif
+static void setup_signal_handlers(void);
 
 static void arg_error(const char* name, const char* arg, bool missing);
 static void fatal_error(string);
@@ -207,6 +222,7 @@ static void fatal_error(string);
 #  define SHOW_WIZARD_BEFORE_MAIN_WINDOW 0
 #endif
 
+#if !DECODER_MODE
 void start_process(string executable)
 {
 	if (!executable.empty()) {
@@ -232,9 +248,10 @@ void start_process(string executable)
 			CloseHandle(pi.hThread);
 			free(cmd);
 #else
+			// other threads may be running: the child must not
+			// touch stdio or run the atexit handlers
 			execl("/bin/sh", "sh", "-c", executable.c_str(), (char *)NULL);
-			perror("execl");
-			exit(EXIT_FAILURE);
+			_exit(EXIT_FAILURE);
 		}
 #endif
 	}
@@ -299,7 +316,75 @@ void delayed_startup(void *)
 		cb_mnuCheckUpdate((Fl_Widget *)0, NULL);
 
 }
+#endif // !DECODER_MODE
 
+#if DECODER_MODE
+// dl-fldigi-decode never opens a display: it reads the configuration, sets up
+// the telemetry extractor and runs the decoder or the benchmark
+int main(int argc, char ** argv)
+{
+	active_modem = new NULLMODEM;
+
+	appname = argv[0];
+
+	debug_exec(argv);
+
+	CREATE_THREAD_ID(); // only call this once
+	SET_THREAD_ID(FLMAIN_TID);
+
+	set_unexpected(handle_unexpected);
+	set_terminate(diediedie);
+	setup_signal_handlers();
+
+	generate_version_text();
+	{
+#ifdef __WOE32__
+		const char* home = getenv("USERPROFILE");
+#else
+		const char* home = getenv("HOME");
+#endif
+		if (BaseDir.empty() && home)
+			BaseDir.assign(home).append("/");
+#ifdef __WOE32__
+		if (HomeDir.empty()) HomeDir.assign(BaseDir).append("dl-fldigi.files/");
+#else
+		if (HomeDir.empty()) HomeDir.assign(BaseDir).append(".dl-fldigi/");
+#endif
+	}
+
+	dl_fldigi::hbtint::init();
+
+	generate_option_help();
+
+	for (int arg_idx = 1; arg_idx < argc; )
+		if (parse_args(argc, argv, arg_idx) == 0)
+			arg_error(argv[0], argv[arg_idx], false);
+
+	if (mkdir(HomeDir.c_str(), 0777) == -1 && errno != EEXIST)
+		fatal_error(string(_("Could not make directory ")).append(HomeDir));
+
+	try {
+		debug::start(string(HomeDir).append("status_log.txt").c_str());
+		time_t t = time(NULL);
+		LOG(debug::QUIET_LEVEL, debug::LOG_OTHER, _("%s log started on %s"), PACKAGE_STRING, ctime(&t));
+		LOG_THREAD_ID();
+	}
+	catch (const char* error) {
+		cerr << error << '\n';
+		debug::stop();
+	}
+
+	LOG_INFO("appname: %s", appname.c_str());
+	LOG_INFO("HomeDir: %s", HomeDir.c_str());
+
+	progdefaults.readDefaultsXML();
+	progStatus.loadLastState();
+
+	if (benchmark.enabled)
+		return setup_benchmark();
+	return setup_decoder();
+}
+#else
 int main(int argc, char ** argv)
 {
 //	null_modem = new NULLMODEM;
@@ -524,10 +609,6 @@ int main(int argc, char ** argv)
 	if (progdefaults.XmlRigFilename.empty())
 		progdefaults.XmlRigFilename = xmlfname;
 
-#if BENCHMARK_MODE
-	return setup_benchmark();
-#endif
-
 	FSEL::create();
 
 #if FLDIGI_FLTK_API_MAJOR == 1 && FLDIGI_FLTK_API_MINOR < 3
@@ -556,6 +637,9 @@ int main(int argc, char ** argv)
 
 	progdefaults.initInterface();
 	trx_start();
+	for (size_t i = 0; i < extra_modems.size(); i++)
+		start_extra_modem(extra_modems[i].mode, extra_modems[i].freq,
+				  extra_modems[i].settings);
 
 #if SHOW_WIZARD_BEFORE_MAIN_WINDOW
 	if (!have_config) {
@@ -618,6 +702,9 @@ void exit_process() {
 		pskrep_stop();
 
 	for (int i = 0; i < NUM_QRUNNER_THREADS; i++) {
+		if (cbq[i]->high_water())
+			LOG_DEBUG("qrunner %d: high water %" PRIuSZ ", dropped %" PRIuSZ,
+				  i, cbq[i]->high_water(), cbq[i]->dropped());
 		cbq[i]->detach();
 		delete cbq[i];
 	}
@@ -625,6 +712,7 @@ void exit_process() {
 	FSEL::destroy();
 
 }
+#endif // DECODER_MODE
 
 void generate_option_help(void) {
 	ostringstream help;
@@ -700,13 +788,66 @@ void generate_option_help(void) {
 	     << "    Allow only the methods whose names match REGEX\n\n"
 	     << "  --xmlrpc-deny REGEX\n"
 	     << "    Allow only the methods whose names don't match REGEX\n\n"
+#if !DECODER_MODE
 	     << "  --xmlrpc-list\n"
 	     << "    List all available methods\n\n"
+#endif
 
-#if BENCHMARK_MODE
-	     << "  --benchmark-modem ID\n"
-	     << "    Specify the modem\n"
-	     << "    Default: " << mode_info[benchmark.modem].sname << "\n\n"
+#if !DECODER_MODE
+	     << "  --extra-modem MODE[:FREQ[:OPTIONS]]\n"
+	     << "    Also receive MODE, given by name or id, at audio frequency FREQ\n"
+	     << "    in a window of its own; may be given up to " << NUM_EXTRA_MODEMS << " times\n"
+	     << "    OPTIONS override the configuration for this modem only:\n"
+	     << "    baud=N,shift=N,stop=1|1.5|2 for RTTY, e.g. RTTY:1500:baud=300,shift=850\n\n"
+#endif
+
+#if DECODER_MODE
+	     << "  --decode-input FILE\n"
+	     << "    Decode FILE, which may be any format supported by libsndfile\n"
+	     << "    \"-\" reads raw signed 16-bit mono samples from stdin\n"
+	     << "    May be given more than once\n\n"
+	     << "  --decode-modem MODE\n"
+	     << "    Specify the modem by name or id: an RTTY, PSK, DominoEX\n"
+	     << "    or THOR mode\n"
+	     << "    Default: the last mode used by " << PACKAGE_NAME << "\n\n"
+	     << "  --decode-frequency FREQ\n"
+	     << "    Specify the modem frequency\n"
+	     << "    Default: the last frequency used\n\n"
+	     << "  --decode-afc BOOLEAN\n"
+	     << "    Set modem AFC\n"
+	     << "    Default: " << decoder.afc
+	     << " (" << boolalpha << decoder.afc << noboolalpha << ")\n\n"
+	     << "  --decode-squelch BOOLEAN\n"
+	     << "    Set modem squelch; RTTY measures its signal on the waterfall,\n"
+	     << "    so with the squelch on it decodes nothing\n"
+	     << "    Default: " << decoder.sql
+	     << " (" << boolalpha << decoder.sql << noboolalpha << ")\n\n"
+	     << "  --decode-squelch-level LEVEL\n"
+	     << "    Set modem squelch level\n"
+	     << "    Default: " << decoder.sqlevel << " (%)\n\n"
+	     << "  --decode-rate RATE\n"
+	     << "    Treat inputs as raw signed 16-bit mono samples at RATE Hz\n"
+	     << "    Default: the modem sample rate for stdin\n\n"
+	     << "  --decode-src-type TYPE\n"
+	     << "    Specify the sample rate conversion type\n"
+	     << "    Default: " << decoder.src_type << " (" << src_get_name(decoder.src_type) << ")\n\n"
+	     << "  --decode-telemetry\n"
+	     << "    Write one JSON object per extracted telemetry sentence\n"
+	     << "    instead of the decoded text\n\n"
+	     << "  --decode-jobs N\n"
+	     << "    Decode up to N inputs in parallel\n"
+	     << "    Default: the number of processors\n\n"
+	     << "  --decode-output-dir DIRECTORY\n"
+	     << "    With more than one input, write the output for each input\n"
+	     << "    to a file named after it in DIRECTORY\n"
+	     << "    Default: the current directory\n\n"
+
+	     << "  --benchmark\n"
+	     << "    Run the modem benchmark suite instead of decoding and write\n"
+	     << "    the results as JSON\n\n"
+	     << "  --benchmark-modem MODE\n"
+	     << "    Benchmark MODE, given by name or id; may be given more than once\n"
+	     << "    Default: all RTTY, PSK, DominoEX and THOR modes\n\n"
 	     << "  --benchmark-frequency FREQ\n"
 	     << "    Specify the modem frequency\n"
 	     << "    Default: " << benchmark.freq << "\n\n"
@@ -721,27 +862,25 @@ void generate_option_help(void) {
 	     << "  --benchmark-squelch-level LEVEL\n"
 	     << "    Set modem squelch level\n"
 	     << "    Default: " << benchmark.sqlevel << " (%)\n\n"
-	     << "  --benchmark-input INPUT\n"
-	     << "    Specify the input\n"
-	     << "    Must be a positive integer indicating the number of samples\n"
-		"    of silence to generate as the input"
-#  if USE_SNDFILE
-		", or a filename containing\n"
-		"    non-digit characters"
-#endif
-		"\n\n"
-
+	     << "  --benchmark-samples N\n"
+	     << "    Length of the synthetic silence, noise and signal inputs\n"
+	     << "    Default: " << benchmark.samples << "\n\n"
+	     << "  --benchmark-input FILE\n"
+	     << "    Also run every modem over the recording in FILE\n"
+	     << "    May be given more than once\n\n"
 	     << "  --benchmark-output FILE\n"
-	     << "    Specify the output data file\n"
-	     << "    Default: decoder output is discarded\n\n"
-	     << "  --benchmark-src-ratio RATIO\n"
-	     << "    Specify the sample rate conversion ratio\n"
-	     << "    Default: 1.0 (input is not resampled)\n\n"
-	     << "  --benchmark-src-type TYPE\n"
-	     << "    Specify the sample rate conversion type\n"
-	     << "    Default: " << benchmark.src_type << " (" << src_get_name(benchmark.src_type) << ")\n\n"
-#endif
-
+	     << "    Write the results to FILE\n"
+	     << "    Default: stdout\n\n"
+	     << "  --benchmark-baseline FILE\n"
+	     << "    Compare the results with those in FILE, a previous output,\n"
+	     << "    and fail if any modem has become slower\n\n"
+	     << "  --benchmark-tolerance PERCENT\n"
+	     << "    Slowdown allowed before a result counts as a regression\n"
+	     << "    Default: " << benchmark.tolerance << "\n\n"
+	     << "  --benchmark-runs N\n"
+	     << "    Run every modem N times over each input and keep the fastest run\n"
+	     << "    Default: " << benchmark.runs << "\n\n"
+#else
 	     << "  --cpu-speed-test\n"
 	     << "    Perform the CPU speed test, show results in the event log\n"
 	     << "    and possibly change options.\n\n"
@@ -760,6 +899,7 @@ void generate_option_help(void) {
 
 	     << "  --window-height PIXELS\n"
 	     << "    Set the window height\n\n"
+#endif
 
 	     << "  --debug-level LEVEL\n"
 	     << "    Set the event log verbosity\n\n"
@@ -779,6 +919,7 @@ void generate_option_help(void) {
 	     << "  --help\n"
 	     << "    Print this option help\n\n";
 
+#if !DECODER_MODE
 // Fl::help looks ugly so we'll write our own
 
 	help << "Standard FLTK options:\n\n"
@@ -824,16 +965,20 @@ void generate_option_help(void) {
 	     << ':' << FL_NORMAL_SIZE << "\n\n"
 
 		;
+#endif
 
 	option_help = help.str();
 }
 
+#if !DECODER_MODE
 void exit_cb(void*) { fl_digi_main->do_callback(); }
+#endif
 
 int parse_args(int argc, char **argv, int& idx)
 {
 	// Only handle long options
 	if (!(strlen(argv[idx]) >= 2 && strncmp(argv[idx], "--", 2) == 0)) {
+#if !DECODER_MODE
 		// Store the window title. We may need this early in the initialisation
 		// process, before FLTK uses it to set the main window title.
 		if (main_window_title.empty() && argc > idx &&
@@ -841,6 +986,7 @@ int parse_args(int argc, char **argv, int& idx)
 			main_window_title = argv[idx + 1];
 		else if (!strcmp(argv[idx], "-i") || !strcmp(argv[idx], "-iconic"))
 			iconified = true;
+#endif
 		return 0;
 	}
 
@@ -851,27 +997,39 @@ int parse_args(int argc, char **argv, int& idx)
 	       OPT_HOME_DIR,
 	       OPT_CONFIG_DIR,
 	       OPT_ARQ_ADDRESS, OPT_ARQ_PORT,
+#if !DECODER_MODE
 	       OPT_SHOW_CPU_CHECK,
+#endif
 	       OPT_FLMSG_DIR,
 	       OPT_AUTOSEND_DIR,
 
 	       OPT_CONFIG_XMLRPC_ADDRESS, OPT_CONFIG_XMLRPC_PORT,
-	       OPT_CONFIG_XMLRPC_ALLOW, OPT_CONFIG_XMLRPC_DENY, OPT_CONFIG_XMLRPC_LIST,
+	       OPT_CONFIG_XMLRPC_ALLOW, OPT_CONFIG_XMLRPC_DENY,
 
-#if BENCHMARK_MODE
-	       OPT_BENCHMARK_MODEM, OPT_BENCHMARK_AFC, OPT_BENCHMARK_SQL, OPT_BENCHMARK_SQLEVEL,
-	       OPT_BENCHMARK_FREQ, OPT_BENCHMARK_INPUT, OPT_BENCHMARK_OUTPUT,
-	       OPT_BENCHMARK_SRC_RATIO, OPT_BENCHMARK_SRC_TYPE,
+#if !DECODER_MODE
+	       OPT_CONFIG_XMLRPC_LIST,
+	       OPT_EXTRA_MODEM,
+#else
+	       OPT_DECODE_INPUT, OPT_DECODE_MODEM, OPT_DECODE_FREQ, OPT_DECODE_AFC,
+	       OPT_DECODE_SQL, OPT_DECODE_SQLEVEL, OPT_DECODE_RATE, OPT_DECODE_SRC_TYPE,
+	       OPT_DECODE_TELEMETRY, OPT_DECODE_JOBS, OPT_DECODE_OUTPUT_DIR,
+
+	       OPT_BENCHMARK, OPT_BENCHMARK_MODEM, OPT_BENCHMARK_FREQ, OPT_BENCHMARK_AFC,
+	       OPT_BENCHMARK_SQL, OPT_BENCHMARK_SQLEVEL, OPT_BENCHMARK_SAMPLES,
+	       OPT_BENCHMARK_INPUT, OPT_BENCHMARK_OUTPUT, OPT_BENCHMARK_BASELINE,
+	       OPT_BENCHMARK_TOLERANCE, OPT_BENCHMARK_RUNS,
 #endif
 
+#if !DECODER_MODE
                OPT_FONT, OPT_WFALL_HEIGHT,
                OPT_WINDOW_WIDTH, OPT_WINDOW_HEIGHT, OPT_WFALL_ONLY,
                OPT_HAB,
+	       OPT_NOISE, OPT_EXIT_AFTER,
+#endif
 #if USE_PORTAUDIO
                OPT_FRAMES_PER_BUFFER,
 #endif
-	       OPT_NOISE, OPT_DEBUG_LEVEL, OPT_DEBUG_PSKMAIL, OPT_DEBUG_AUDIO,
-               OPT_EXIT_AFTER,
+	       OPT_DEBUG_LEVEL, OPT_DEBUG_PSKMAIL, OPT_DEBUG_AUDIO,
                OPT_DEPRECATED, OPT_HELP, OPT_VERSION, OPT_BUILD_INFO };
 
 	static const char shortopts[] = ":";
@@ -888,26 +1046,46 @@ int parse_args(int argc, char **argv, int& idx)
 		{ "flmsg-dir", 1, 0, OPT_FLMSG_DIR },
 		{ "auto-dir", 1, 0, OPT_AUTOSEND_DIR },
 
+#if !DECODER_MODE
 		{ "cpu-speed-test", 0, 0, OPT_SHOW_CPU_CHECK },
+#endif
 
 		{ "xmlrpc-server-address", 1, 0, OPT_CONFIG_XMLRPC_ADDRESS },
 		{ "xmlrpc-server-port",    1, 0, OPT_CONFIG_XMLRPC_PORT },
 		{ "xmlrpc-allow",          1, 0, OPT_CONFIG_XMLRPC_ALLOW },
 		{ "xmlrpc-deny",           1, 0, OPT_CONFIG_XMLRPC_DENY },
-		{ "xmlrpc-list",           0, 0, OPT_CONFIG_XMLRPC_LIST },
 
-#if BENCHMARK_MODE
+#if !DECODER_MODE
+		{ "xmlrpc-list",           0, 0, OPT_CONFIG_XMLRPC_LIST },
+		{ "extra-modem", 1, 0, OPT_EXTRA_MODEM },
+#else
+		{ "decode-input", 1, 0, OPT_DECODE_INPUT },
+		{ "decode-modem", 1, 0, OPT_DECODE_MODEM },
+		{ "decode-frequency", 1, 0, OPT_DECODE_FREQ },
+		{ "decode-afc", 1, 0, OPT_DECODE_AFC },
+		{ "decode-squelch", 1, 0, OPT_DECODE_SQL },
+		{ "decode-squelch-level", 1, 0, OPT_DECODE_SQLEVEL },
+		{ "decode-rate", 1, 0, OPT_DECODE_RATE },
+		{ "decode-src-type", 1, 0, OPT_DECODE_SRC_TYPE },
+		{ "decode-telemetry", 0, 0, OPT_DECODE_TELEMETRY },
+		{ "decode-jobs", 1, 0, OPT_DECODE_JOBS },
+		{ "decode-output-dir", 1, 0, OPT_DECODE_OUTPUT_DIR },
+
+		{ "benchmark", 0, 0, OPT_BENCHMARK },
 		{ "benchmark-modem", 1, 0, OPT_BENCHMARK_MODEM },
 		{ "benchmark-frequency", 1, 0, OPT_BENCHMARK_FREQ },
 		{ "benchmark-afc", 1, 0, OPT_BENCHMARK_AFC },
 		{ "benchmark-squelch", 1, 0, OPT_BENCHMARK_SQL },
 		{ "benchmark-squelch-level", 1, 0, OPT_BENCHMARK_SQLEVEL },
+		{ "benchmark-samples", 1, 0, OPT_BENCHMARK_SAMPLES },
 		{ "benchmark-input", 1, 0, OPT_BENCHMARK_INPUT },
 		{ "benchmark-output", 1, 0, OPT_BENCHMARK_OUTPUT },
-		{ "benchmark-src-ratio", 1, 0, OPT_BENCHMARK_SRC_RATIO },
-		{ "benchmark-src-type", 1, 0, OPT_BENCHMARK_SRC_TYPE },
+		{ "benchmark-baseline", 1, 0, OPT_BENCHMARK_BASELINE },
+		{ "benchmark-tolerance", 1, 0, OPT_BENCHMARK_TOLERANCE },
+		{ "benchmark-runs", 1, 0, OPT_BENCHMARK_RUNS },
 #endif
 
+#if !DECODER_MODE
 		{ "font",	   1, 0, OPT_FONT },
 
 		{ "wfall-height",  1, 0, OPT_WFALL_HEIGHT },
@@ -916,13 +1094,13 @@ int parse_args(int argc, char **argv, int& idx)
 		{ "wfall-only",    0, 0, OPT_WFALL_ONLY },
 		{ "hab",		   0, 0, OPT_HAB },
 		{ "wo",            0, 0, OPT_WFALL_ONLY },
+		{ "exit-after",    1, 0, OPT_EXIT_AFTER },
+		{ "noise", 0, 0, OPT_NOISE },
+#endif
 
 #if USE_PORTAUDIO
 		{ "frames-per-buffer",1, 0, OPT_FRAMES_PER_BUFFER },
 #endif
-		{ "exit-after",    1, 0, OPT_EXIT_AFTER },
-
-		{ "noise", 0, 0, OPT_NOISE },
 		{ "debug-level",   1, 0, OPT_DEBUG_LEVEL },
 		{ "debug-pskmail", 0, 0, OPT_DEBUG_PSKMAIL },
 		{ "debug-audio", 0, 0, OPT_DEBUG_AUDIO },
@@ -1023,16 +1201,111 @@ int parse_args(int argc, char **argv, int& idx)
 			else
 				progdefaults.xmlrpc_deny = optarg;
 			break;
+#if !DECODER_MODE
 		case OPT_CONFIG_XMLRPC_LIST:
 			XML_RPC_Server::list_methods(cout);
 			exit(EXIT_SUCCESS);
 
-#if BENCHMARK_MODE
+		case OPT_EXTRA_MODEM:
+		{
+			string arg = optarg;
+			string::size_type colon = arg.find(':');
+			extra_modem_arg e;
+			e.mode = mode_by_name(arg.substr(0, colon).c_str());
+			if (e.mode == NUM_MODES) {
+				fatal_error(_("Bad modem id"));
+			}
+			e.freq = 0;
+			if (colon != string::npos) {
+				string::size_type opts = arg.find(':', colon + 1);
+				string f = arg.substr(colon + 1, opts == string::npos ? opts : opts - colon - 1);
+				// an empty FREQ leaves the default, so that OPTIONS can be given alone
+				if (!f.empty() && (e.freq = strtol(f.c_str(), NULL, 10)) <= 0) {
+					fatal_error(_("Bad frequency"));
+				}
+				if (opts != string::npos &&
+				    !parse_modem_settings(arg.substr(opts + 1), e.settings)) {
+					fatal_error(_("Bad modem options"));
+				}
+			}
+			extra_modems.push_back(e);
+		}
+			break;
+#else
+		case OPT_DECODE_INPUT:
+			decoder.inputs.push_back(optarg);
+			break;
+
+		case OPT_DECODE_MODEM:
+			decoder.modem = mode_by_name(optarg);
+			if (decoder.modem == NUM_MODES) {
+				fatal_error(_("Bad modem id"));
+			}
+			if (!decoder_mode_ok(decoder.modem)) {
+				fatal_error(_("Unsupported modem"));
+			}
+			break;
+
+		case OPT_DECODE_FREQ:
+			decoder.freq = strtol(optarg, NULL, 10);
+			if (decoder.freq < 0) {
+				fatal_error(_("Bad frequency"));
+			}
+			break;
+
+		case OPT_DECODE_AFC:
+			decoder.afc = strtol(optarg, NULL, 10);
+			break;
+
+		case OPT_DECODE_SQL:
+			decoder.sql = strtol(optarg, NULL, 10);
+			break;
+
+		case OPT_DECODE_SQLEVEL:
+			decoder.sqlevel = strtod(optarg, NULL);
+			break;
+
+		case OPT_DECODE_RATE:
+			decoder.rate = strtol(optarg, NULL, 10);
+			if (decoder.rate <= 0) {
+				fatal_error(_("Bad sample rate"));
+			}
+			break;
+
+		case OPT_DECODE_SRC_TYPE:
+			decoder.src_type = strtol(optarg, NULL, 10);
+			break;
+
+		case OPT_DECODE_TELEMETRY:
+			decoder.telemetry = true;
+			break;
+
+		case OPT_DECODE_JOBS:
+			decoder.jobs = strtol(optarg, NULL, 10);
+			if (decoder.jobs < 0) {
+				fatal_error(_("Bad number of jobs"));
+			}
+			break;
+
+		case OPT_DECODE_OUTPUT_DIR:
+			decoder.output_dir = optarg;
+			break;
+
+		case OPT_BENCHMARK:
+			benchmark.enabled = true;
+			break;
+
 		case OPT_BENCHMARK_MODEM:
-			benchmark.modem = strtol(optarg, NULL, 10);
-			if (!(benchmark.modem >= 0 && benchmark.modem < NUM_MODES)) {
+		{
+			trx_mode m = mode_by_name(optarg);
+			if (m == NUM_MODES) {
 				fatal_error(_("Bad modem id"));
 			}
+			if (!decoder_mode_ok(m)) {
+				fatal_error(_("Unsupported modem"));
+			}
+			benchmark.modems.push_back(m);
+		}
 			break;
 
 		case OPT_BENCHMARK_FREQ:
@@ -1054,23 +1327,35 @@ int parse_args(int argc, char **argv, int& idx)
 			benchmark.sqlevel = strtod(optarg, NULL);
 			break;
 
+		case OPT_BENCHMARK_SAMPLES:
+			benchmark.samples = strtol(optarg, NULL, 10);
+			break;
+
 		case OPT_BENCHMARK_INPUT:
-			benchmark.input = optarg;
+			benchmark.inputs.push_back(optarg);
 			break;
 
 		case OPT_BENCHMARK_OUTPUT:
 			benchmark.output = optarg;
 			break;
 
-		case OPT_BENCHMARK_SRC_RATIO:
-			benchmark.src_ratio = strtod(optarg, NULL);
+		case OPT_BENCHMARK_BASELINE:
+			benchmark.baseline = optarg;
 			break;
 
-		case OPT_BENCHMARK_SRC_TYPE:
-			benchmark.src_type = strtol(optarg, NULL, 10);
+		case OPT_BENCHMARK_TOLERANCE:
+			benchmark.tolerance = strtod(optarg, NULL);
+			break;
+
+		case OPT_BENCHMARK_RUNS:
+			benchmark.runs = strtol(optarg, NULL, 10);
+			if (benchmark.runs < 1) {
+				fatal_error(_("Bad number of runs"));
+			}
 			break;
 #endif
 
+#if !DECODER_MODE
 		case OPT_FONT:
 		{
 			char *p;
@@ -1095,12 +1380,6 @@ int parse_args(int argc, char **argv, int& idx)
 			HNOM = strtol(optarg, NULL, 10);
 			break;
 
-#if USE_PORTAUDIO
-		case OPT_FRAMES_PER_BUFFER:
-			progdefaults.PortFramesPerBuffer = strtol(optarg, 0, 10);
-			break;
-#endif // USE_PORTAUDIO
-
 		case OPT_EXIT_AFTER:
 			Fl::add_timeout(strtod(optarg, 0), exit_cb);
 			break;
@@ -1120,6 +1399,13 @@ int parse_args(int argc, char **argv, int& idx)
 		case OPT_SHOW_CPU_CHECK:
 			show_cpucheck = true;
 			break;
+#endif
+
+#if USE_PORTAUDIO
+		case OPT_FRAMES_PER_BUFFER:
+			progdefaults.PortFramesPerBuffer = strtol(optarg, 0, 10);
+			break;
+#endif // USE_PORTAUDIO
 
 		case OPT_DEBUG_LEVEL:
 		{
@@ -1257,6 +1543,7 @@ void debug_exec(char** argv)
 #endif
 }
 
+#if !DECODER_MODE
 void set_platform_ui(void)
 {
 #if defined(__APPLE__)
@@ -1320,6 +1607,7 @@ double speed_test(int converter, unsigned repeat)
 	t0 = t1 - t0;
 	return repeat / (t0.tv_sec + t0.tv_nsec/1e9);
 }
+#endif // !DECODER_MODE
 
 static void setup_signal_handlers(void)
 {
@@ -1327,13 +1615,16 @@ static void setup_signal_handlers(void)
 	struct sigaction action;
 	memset(&action, 0, sizeof(struct sigaction));
 
-	// no child stopped notifications, no zombies
+	// no child stopped notifications, no zombies; the decoder waits for
+	// its worker processes, so it keeps them
+#if !DECODER_MODE
 	action.sa_handler = SIG_DFL;
 	action.sa_flags = SA_NOCLDSTOP;
 #ifdef SA_NOCLDWAIT
 	action.sa_flags |= SA_NOCLDWAIT;
 #endif
 	sigaction(SIGCHLD, &action, NULL);
+#endif
 	action.sa_flags = 0;
 
 	action.sa_handler = handle_signal;
@@ -1357,19 +1648,26 @@ static void setup_signal_handlers(void)
 
 // Show an error dialog and print to cerr if available.
 // On win32 Fl::fatal displays its own error window.
+// The decoder has no display, and only prints the error.
 static void fatal_error(string sz_error)
 {
 	string s = "Fatal error!\n";
 	s.append(sz_error).append("\n").append(strerror(errno));
 
+#if DECODER_MODE
+	cerr << s << '\n';
+	exit(EXIT_FAILURE);
+#else
 // Win32 will display a MessageBox error message
 #if !defined(__WOE32__)
 	fl_message_font(FL_HELVETICA, FL_NORMAL_SIZE);
 	fl_alert2("%s", s.c_str());
 #endif
 	Fl::fatal(s.c_str());
+#endif
 }
 
+#if !DECODER_MODE
 static void checkdirectories(void)
 {
 	struct DIRS {
@@ -1408,6 +1706,7 @@ static void checkdirectories(void)
 	}
 
 }
+#endif
 
 bool nbems_dirs_checked = false;
 
@@ -1486,6 +1785,47 @@ void check_data_dir(void)
 }
 
 // Print an error message and exit.
+#if !DECODER_MODE
+// Parses the comma separated name=value OPTIONS of --extra-modem
+static bool parse_modem_settings(const string& opts, modem_settings& s)
+{
+	string::size_type i = 0;
+	while (i < opts.length()) {
+		string::size_type comma = opts.find(',', i);
+		string opt = opts.substr(i, comma == string::npos ? comma : comma - i);
+		i = comma == string::npos ? opts.length() : comma + 1;
+
+		string::size_type eq = opt.find('=');
+		if (eq == string::npos)
+			return false;
+		string name = opt.substr(0, eq);
+		const char* val = opt.c_str() + eq + 1;
+		char* end;
+		double v = strtod(val, &end);
+		if (end == val || *end || v <= 0.0)
+			return false;
+
+		if (name == "baud")
+			s.rtty_baud = v;
+		else if (name == "shift")
+			s.rtty_shift = v;
+		else if (name == "stop") {
+			if (v == 1.0)
+				s.rtty_stop = 0;
+			else if (v == 1.5)
+				s.rtty_stop = 1;
+			else if (v == 2.0)
+				s.rtty_stop = 2;
+			else
+				return false;
+		}
+		else
+			return false;
+	}
+	return true;
+}
+#endif
+
 static void arg_error(const char* name, const char* arg, bool missing)
 {
 	ostringstream msg;
@@ -1504,6 +1844,7 @@ static void arg_error(const char* name, const char* arg, bool missing)
 	fatal_error(msg.str());
 }
 
+#if !DECODER_MODE
 /// Sets or resets the KML parameters, and loads existing files.
 void kml_init(bool load_files)
 {
@@ -1545,6 +1886,7 @@ void kml_init(bool load_files)
 		LOG_WARN("Cannot publish user position:%s", exc.what() );
 	}
 }
+#endif
 
 /// Tests if a directory exists.
 int directory_is_created( const char * strdir )
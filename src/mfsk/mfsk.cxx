@@ -668,18 +668,11 @@ void mfsk::softdecode(cmplx *bins)
 
 cmplx mfsk::mixer(cmplx in, double f)
 {
-	cmplx z;
-
 // Basetone is a nominal 1000 Hz
 	f -= tonespacing * basetone + bandwidth / 2;
 
-	z = in * cmplx( cos(phaseacc), sin(phaseacc) );
-
-	phaseacc -= TWOPI * f / samplerate;
-	if (phaseacc > TWOPI) phaseacc -= TWOPI;
-	if (phaseacc < -TWOPI) phaseacc += TWOPI;
-
-	return z;
+	rxosc.set_step(-TWOPI * f / samplerate);
+	return rxosc.mix(in);
 }
 
 // finds the tone bin with the largest signal level
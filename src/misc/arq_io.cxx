@@ -788,6 +788,12 @@ void WriteARQ(const char *data)
 	tosend.append(data);
 }
 
+void WriteARQ(const char *data, size_t len)
+{
+	guard_lock tosend_lock(&tosend_mutex);
+	tosend.append(data, len);
+}
+
 static void *arq_loop(void *args)
 {
 	static unsigned char szACK = 0x06;
@@ -22,25 +22,24 @@
 
 #include <config.h>
 
+#include <iostream>
 #include <fstream>
 #include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 #include <cstdlib>
+#include <cmath>
 
 #include <inttypes.h>
-#include <sys/time.h>
 #include <time.h>
 
-#ifndef __MINGW32__
-#  include <sys/resource.h>
-#else
-#  include "compat.h"
-#endif
-
 #if USE_SNDFILE
 #  include <sndfile.h>
 #endif
+#include <samplerate.h>
 
 #include "fl_digi.h"
 #include "modem.h"
@@ -48,243 +47,352 @@
 #include "timeops.h"
 #include "configuration.h"
 #include "status.h"
+#include "util.h"
 #include "debug.h"
+#include "jsoncpp.h"
+#include "decoder.h"
 
 #include "benchmark.h"
 
 using namespace std;
 
-struct benchmark_params benchmark = { MODE_PSK31, 1000, false, false, 0.0, 1.0, SRC_SINC_FASTEST };
+struct benchmark_params benchmark = { false, 1000, false, false, 0.0, 1 << 19, 10.0, 5 };
+
+// Inputs that are generated rather than read from a file.  "signal" is the
+// modem's own transmission of tx_text, with the noise added.
+static const char* synthetic_inputs[] = { "silence", "noise", "signal" };
+
+static const char tx_text[] =
+	"$$BENCHMARK,1234,12:34:56,52.21347,0.09214,12345,7,21.5*5A3C\n";
+
+// The transmitter's output while make_synthetic() runs it, and its position
+// in tx_text
+static vector<double>* modulated = 0;
+static size_t tx_pos;
+
+// The run that the trx thread is to perform next, and its result
+static struct {
+	string input;
+	bool synthetic;
+	Json::Value result;
+} run;
+
+// rx_process() is called with blocks of this size, as in the receive loop
+#define BENCHMARK_BLOCKSIZE SCBLOCKSIZE
+
+// Only the modes that dl-fldigi-decode can run.  CW, MFSK, Olivia, Contestia,
+// MT63, Hell, THROB, WEFAX, NAVTEX and the analysis modes read their settings
+// from widgets, or keep state in them, while they receive, and the decoder
+// has no widgets.
+static bool receive_mode(trx_mode m)
+{
+	return m != MODE_NULL && decoder_mode_ok(m);
+}
 
+static Json::Value compare_baseline(const Json::Value& results, bool& regressed);
 
 int setup_benchmark(void)
 {
 	ENSURE_THREAD(FLMAIN_TID);
 
-	if (benchmark.input.empty()) {
-		LOG_ERROR("Missing input");
-		return 1;
-	}
-	else {
-		char* p;
-		benchmark.samples = (size_t)strtol(benchmark.input.c_str(), &p, 10);
-		if (*p != '\0') { // invalid char in input string
-#if USE_SNDFILE
-			// treat as filename
-			benchmark.samples = 0;
-#else
-			LOG_ERROR("Bad input string, \"%s\"", benchmark.input.c_str());
-			return 1;
-#endif
-		}
-	}
-	if (!benchmark.output.empty())
-		benchmark.buffer.reserve(BUFSIZ);
-
 	progdefaults.rsid = false;
 	progdefaults.StartAtSweetSpot = false;
 
-	if (benchmark.modem != NUM_MODES)
-		progStatus.lastmode = benchmark.modem;
-	if (benchmark.freq)
-		progStatus.carrier = benchmark.freq;
+	// nothing but tx_text is transmitted
+	progdefaults.CWid = progdefaults.macroCWid = false;
+	progdefaults.sendid = progdefaults.macroid = false;
+	progdefaults.sendtextid = progdefaults.macrotextid = false;
+	progdefaults.pretone = 0.0;
+	progdefaults.PTTrightchannel = false;
+
 	progStatus.afconoff = benchmark.afc;
 	progStatus.sqlonoff = benchmark.sql;
 	progStatus.sldrSquelchValue = benchmark.sqlevel;
 
-	debug::level = debug::INFO_LEVEL;
-	TRX_WAIT(STATE_ENDED, trx_start(); init_modem(progStatus.lastmode));
-	if (!benchmark.output.empty()) {
-		ofstream out(benchmark.output.c_str());
-		if (out)
-			out << benchmark.buffer;
-	}
+	// decoded text is discarded
+	decoder.out = 0;
+	decoder.telemetry = false;
 
-	return 0;
-}
+	if (benchmark.modems.empty())
+		for (trx_mode m = 0; m < NUM_MODES; m++)
+			if (receive_mode(m))
+				benchmark.modems.push_back(m);
 
-#if USE_SNDFILE
-SNDFILE* infile = 0;
-#endif
+	vector<pair<string, bool> > inputs;
+	for (size_t i = 0; i < sizeof(synthetic_inputs) / sizeof(*synthetic_inputs); i++)
+		inputs.push_back(make_pair(string(synthetic_inputs[i]), true));
+	for (size_t i = 0; i < benchmark.inputs.size(); i++)
+		inputs.push_back(make_pair(benchmark.inputs[i], false));
 
-static size_t do_rx(struct rusage ru[2], struct timespec wall_time[2]);
-static size_t do_rx_src(struct rusage ru[2], struct timespec wall_time[2]);
+	debug::level = debug::INFO_LEVEL;
 
-void do_benchmark(void)
-{
-	ENSURE_THREAD(TRX_TID);
+	Json::Value results(Json::arrayValue);
+	for (size_t i = 0; i < benchmark.modems.size(); i++) {
+		for (size_t j = 0; j < inputs.size(); j++) {
+			run.input = inputs[j].first;
+			run.synthetic = inputs[j].second;
+			run.result = Json::Value::null;
 
-	if (benchmark.src_ratio != 1.0)
-		LOG_INFO("modem=%" PRIdPTR " (%s) rate=%d ratio=%f converter=%d (\"%s\")",
-			 active_modem->get_mode(), mode_info[active_modem->get_mode()].sname,
-			 active_modem->get_samplerate(),
-			 benchmark.src_ratio, benchmark.src_type, src_get_name(benchmark.src_type));
-	else
-		LOG_INFO("modem=%" PRIdPTR " (%s) rate=%d", active_modem->get_mode(),
-			 mode_info[active_modem->get_mode()].sname, active_modem->get_samplerate());
+			TRX_WAIT(STATE_ENDED, trx_start(); init_modem(benchmark.modems[i], benchmark.freq));
 
-#if USE_SNDFILE
-	if (!benchmark.samples) {
-		SF_INFO info = { 0, 0, 0, 0, 0, 0 };
-		if ((infile = sf_open(benchmark.input.c_str(), SFM_READ, &info)) == NULL) {
-			LOG_ERROR("Could not open input file \"%s\"", benchmark.input.c_str());
-			return;
+			if (!run.result.isNull())
+				results.append(run.result);
 		}
 	}
-#endif
 
-	struct rusage ru[2];
-	struct timespec wall_time[2];
-	size_t nproc, nrx;
-	if (benchmark.src_ratio == 1.0)
-		nrx = nproc = do_rx(ru, wall_time);
-	else {
-		nproc = do_rx_src(ru, wall_time);
-		nrx = (size_t)(nproc * benchmark.src_ratio);
-	}
-	ru[1].ru_utime -= ru[0].ru_utime;
-	wall_time[1] -= wall_time[0];
+	Json::Value doc(Json::objectValue);
+	doc["version"] = PACKAGE_VERSION;
+	doc["block_size"] = BENCHMARK_BLOCKSIZE;
+	doc["runs"] = benchmark.runs;
+	doc["results"] = results;
 
-#if USE_SNDFILE
-	if (infile) {
-		sf_close(infile);
-		infile = 0;
+	bool regressed = false;
+	if (!benchmark.baseline.empty())
+		doc["regressions"] = compare_baseline(results, regressed);
+
+	Json::StyledWriter writer;
+	if (benchmark.output.empty())
+		cout << writer.write(doc);
+	else {
+		ofstream out(benchmark.output.c_str());
+		if (!(out << writer.write(doc))) {
+			LOG_ERROR("Could not write \"%s\"", benchmark.output.c_str());
+			return 1;
+		}
 	}
-#endif
 
-	LOG_INFO("processed: %" PRIuSZ " samples (decoded %" PRIuSZ ") in %.3f seconds", nproc, nrx,
-		 wall_time[1].tv_sec + wall_time[1].tv_nsec / 1e9);
-	double speed = nproc / (ru[1].ru_utime.tv_sec + ru[1].ru_utime.tv_usec / 1e6);
-	LOG_INFO("cpu time : %" PRIdMAX ".%03" PRIdMAX "; speed=%.3f samples/s; factor=%.3f",
-		 (intmax_t)ru[1].ru_utime.tv_sec, (intmax_t)ru[1].ru_utime.tv_usec / 1000,
-		 speed, speed / active_modem->get_samplerate());
+	return regressed;
 }
 
 // ----------------------------------------------------------------------------
 
-static size_t do_rx(struct rusage ru[2], struct timespec wall_time[2])
+int benchmark_tx_char(void)
 {
-	size_t nread;
-	size_t inlen = 1 << 19;
-	double* inbuf = new double[inlen];
+	if (!modulated || modulated->size() >= benchmark.samples)
+		return GET_TX_CHAR_ETX;
 
-#if USE_SNDFILE
-	if (infile) {
-		nread = 0;
-		clock_gettime(CLOCK_MONOTONIC, &wall_time[0]);
-		getrusage(RUSAGE_SELF, &ru[0]);
-
-		for (size_t n; (n = sf_readf_double(infile, inbuf, inlen)); nread += n)
-			active_modem->rx_process(inbuf, n);
-	}
-	else
-#endif
-	{
-		memset(inbuf, 0, sizeof(double) * inlen);
-		clock_gettime(CLOCK_MONOTONIC, &wall_time[0]);
-		getrusage(RUSAGE_SELF, &ru[0]);
-
-		for (nread = benchmark.samples; nread > inlen; nread -= inlen)
-			active_modem->rx_process(inbuf, inlen);
-		if (nread)
-			active_modem->rx_process(inbuf, nread);
-		nread = benchmark.samples;
-	}
-
-	getrusage(RUSAGE_SELF, &ru[1]);
-	clock_gettime(CLOCK_MONOTONIC, &wall_time[1]);
-
-	delete [] inbuf;
-	return nread;
+	int c = (unsigned char)tx_text[tx_pos++];
+	if (tx_pos == sizeof(tx_text) - 1)
+		tx_pos = 0;
+	return c;
 }
 
-
-size_t inlen = 1 << 19;
-static float* inbuf = 0;
-static long src_read(void* arg, float** data)
+void benchmark_modulated(const double* buf, int len)
 {
-	*data = inbuf;
-	return inlen;
+	if (modulated)
+		modulated->insert(modulated->end(), buf, buf + len);
 }
-#if USE_SNDFILE
-static long src_readf(void* arg, float** data)
+
+// Fills `buf' with the named synthetic input.  The noise is generated from a
+// fixed seed, and the signal from fixed text, so that every run sees the same
+// samples.
+static void make_synthetic(const string& name, vector<double>& buf)
 {
-	long n = (long)sf_readf_float(infile, inbuf, inlen);
-	*data = n ? inbuf : 0;
-	return n;
+	buf.assign(benchmark.samples, 0.0);
+	if (name == "silence")
+		return;
+
+	if (name == "signal") {
+		vector<double> tx;
+		tx.reserve(benchmark.samples + SCBLOCKSIZE);
+		modulated = &tx;
+		tx_pos = 0;
+		active_modem->tx_init(0);
+		while (active_modem->tx_process() >= 0)
+			;
+		modulated = 0;
+
+		for (size_t i = 0; i < buf.size() && i < tx.size(); i++)
+			buf[i] = 0.5 * tx[i];
+	}
+
+	uint32_t s = 0x12345678;
+	for (size_t i = 0; i < buf.size(); i += 2) {
+		double u[2];
+		for (int k = 0; k < 2; k++) { // xorshift32
+			s ^= s << 13; s ^= s >> 17; s ^= s << 5;
+			u[k] = (s + 1.0) / 4294967296.0;
+		}
+		double r = 0.1 * sqrt(-2.0 * log(u[0]));
+		buf[i] += r * cos(2.0 * M_PI * u[1]);
+		if (i + 1 < buf.size())
+			buf[i + 1] += r * sin(2.0 * M_PI * u[1]);
+	}
 }
-#endif
 
-static size_t do_rx_src(struct rusage ru[2], struct timespec wall_time[2])
+// Reads the first channel of `name' into `buf', resampled to `samplerate'
+static bool read_recorded(const string& name, int samplerate, vector<double>& buf)
 {
-	int err;
-	SRC_STATE* src_state;
-
 #if USE_SNDFILE
-	if (infile)
-		src_state = src_callback_new(src_readf, benchmark.src_type, 1, &err, NULL);
-	else
-#endif
-		src_state = src_callback_new(src_read, benchmark.src_type, 1, &err, NULL);
-
-	if (!src_state) {
-		LOG_ERROR("src_callback_new error %d: %s", err, src_strerror(err));
-		return 0;
+	SF_INFO info;
+	memset(&info, 0, sizeof(info));
+	SNDFILE* infile = sf_open(name.c_str(), SFM_READ, &info);
+	if (!infile) {
+		LOG_ERROR("Could not open input file \"%s\": %s", name.c_str(), sf_strerror(NULL));
+		return false;
+	}
+	if (info.frames <= 0) {
+		LOG_ERROR("Input file \"%s\" is empty", name.c_str());
+		sf_close(infile);
+		return false;
 	}
 
-	inbuf = new float[inlen];
-	size_t outlen = (size_t)floor(inlen * benchmark.src_ratio);
-	float* outbuf = new float[outlen];
-	double* rxbuf = new double[outlen];
-
-	long n;
-	size_t nread;
-#if USE_SNDFILE
-	if (infile) { // read until src returns 0
-		nread = 0;
-		clock_gettime(CLOCK_MONOTONIC, &wall_time[0]);
-		getrusage(RUSAGE_SELF, &ru[0]);
-
-		while ((n = src_callback_read(src_state, benchmark.src_ratio, outlen, outbuf))) {
-			for (long i = 0; i < n; i++)
-				rxbuf[i] = outbuf[i];
-			active_modem->rx_process(rxbuf, n);
-			nread += n;
+	vector<float> frames((size_t)info.frames * info.channels);
+	sf_count_t n = sf_readf_float(infile, &frames[0], info.frames);
+	sf_close(infile);
+
+	vector<float> in((size_t)n);
+	for (sf_count_t i = 0; i < n; i++)
+		in[i] = frames[i * info.channels];
+
+	if (info.samplerate != samplerate) {
+		double ratio = (double)samplerate / info.samplerate;
+		vector<float> out((size_t)ceil(in.size() * ratio) + 1);
+		SRC_DATA src;
+		src.data_in = &in[0];
+		src.input_frames = in.size();
+		src.data_out = &out[0];
+		src.output_frames = out.size();
+		src.src_ratio = ratio;
+		int err = src_simple(&src, SRC_SINC_FASTEST, 1);
+		if (err) {
+			LOG_ERROR("src_simple error %d: %s", err, src_strerror(err));
+			return false;
 		}
-
-		nread = (size_t)round(nread * benchmark.src_ratio);
+		out.resize(src.output_frames_gen);
+		in.swap(out);
 	}
-	else
+
+	buf.assign(in.begin(), in.end());
+	return true;
+#else
+	LOG_ERROR("Cannot read \"%s\": built without libsndfile", name.c_str());
+	return false;
 #endif
-	{ // read benchmark.samples * benchmark.src_ratio
-		nread = (size_t)round(benchmark.samples * benchmark.src_ratio);
-		clock_gettime(CLOCK_MONOTONIC, &wall_time[0]);
-		getrusage(RUSAGE_SELF, &ru[0]);
-
-		while (nread > outlen) {
-			if ((n = src_callback_read(src_state, benchmark.src_ratio, outlen, outbuf)) == 0)
-				break;
-			for (long i = 0; i < n; i++)
-				rxbuf[i] = outbuf[i];
-			active_modem->rx_process(rxbuf, n);
-			nread -= (size_t)n;
+}
+
+static double percentile(vector<double>& v, double p)
+{
+	if (v.empty())
+		return 0.0;
+	size_t k = (size_t)(p * (v.size() - 1) + 0.5);
+	nth_element(v.begin(), v.begin() + k, v.end());
+	return v[k];
+}
+
+// Called by the trx thread in place of the sound card receive loop
+void do_benchmark(void)
+{
+	ENSURE_THREAD(TRX_TID);
+
+	trx_mode mode = active_modem->get_mode();
+	int samplerate = active_modem->get_samplerate();
+
+	vector<double> input;
+	if (run.synthetic)
+		make_synthetic(run.input, input);
+	else if (!read_recorded(run.input, samplerate, input))
+		return;
+
+	// The fastest run is reported, as the one least disturbed by the rest
+	// of the system
+	vector<double> latency, best_latency, totals;
+	latency.reserve(input.size() / BENCHMARK_BLOCKSIZE + 1);
+	double total = 0.0;
+
+	for (int n = 0; n < benchmark.runs; n++) {
+		active_modem->rx_init();
+		latency.clear();
+
+		struct timespec t[2];
+		double run_total = 0.0;
+		for (size_t i = 0; i < input.size(); i += BENCHMARK_BLOCKSIZE) {
+			int len = (int)min((size_t)BENCHMARK_BLOCKSIZE, input.size() - i);
+			clock_gettime(CLOCK_MONOTONIC, &t[0]);
+			active_modem->rx_process(&input[i], len);
+			clock_gettime(CLOCK_MONOTONIC, &t[1]);
+			t[1] -= t[0];
+			double dt = t[1].tv_sec + t[1].tv_nsec / 1e9;
+			latency.push_back(dt);
+			run_total += dt;
 		}
-		if (nread) {
-			if ((n = src_callback_read(src_state, benchmark.src_ratio, nread, outbuf))) {
-				for (long i = 0; i < n; i++)
-					rxbuf[i] = outbuf[i];
-				active_modem->rx_process(rxbuf, n);
-			}
+
+		totals.push_back(run_total);
+		if (n == 0 || run_total < total) {
+			total = run_total;
+			best_latency.swap(latency);
 		}
-		nread = benchmark.samples;
 	}
 
-	getrusage(RUSAGE_SELF, &ru[1]);
-	clock_gettime(CLOCK_MONOTONIC, &wall_time[1]);
+	double speed = total > 0.0 ? input.size() / total : 0.0;
+	double median = percentile(totals, 0.50);
+
+	Json::Value& r = run.result = Json::Value(Json::objectValue);
+	r["modem"] = mode_info[mode].sname;
+	r["input"] = run.input;
+	r["samplerate"] = samplerate;
+	r["samples"] = (Json::UInt)input.size();
+	r["runs"] = benchmark.runs;
+	r["seconds"] = total;
+	r["seconds_median"] = median;
+	r["samples_per_second"] = speed;
+	r["realtime_factor"] = speed / samplerate;
+	r["latency_p50_us"] = percentile(best_latency, 0.50) * 1e6;
+	r["latency_p99_us"] = percentile(best_latency, 0.99) * 1e6;
+
+	LOG_INFO("modem=%s input=%s: %" PRIuSZ " samples in %.3f s; speed=%.0f samples/s; factor=%.1f",
+		 mode_info[mode].sname, run.input.c_str(), input.size(), total,
+		 speed, speed / samplerate);
+}
+
+// ----------------------------------------------------------------------------
 
-	delete [] inbuf;
-	delete [] outbuf;
-	delete [] rxbuf;
+// Returns the results that are slower than the baseline by more than
+// benchmark.tolerance percent.  Both sides are the fastest of their runs, so a
+// single run slowed by the rest of the system is not taken for a regression.
+// Runs that are not in the baseline are ignored.
+static Json::Value compare_baseline(const Json::Value& results, bool& regressed)
+{
+	Json::Value regressions(Json::arrayValue);
+
+	ifstream in(benchmark.baseline.c_str());
+	Json::Value base;
+	Json::Reader reader;
+	if (!in || !reader.parse(in, base) || !base["results"].isArray()) {
+		LOG_ERROR("Could not read baseline \"%s\"", benchmark.baseline.c_str());
+		regressed = true;
+		return regressions;
+	}
+
+	map<string, double> base_speed;
+	const Json::Value& br = base["results"];
+	for (Json::Value::ArrayIndex i = 0; i < br.size(); i++)
+		base_speed[br[i]["modem"].asString() + '\n' + br[i]["input"].asString()] =
+			br[i]["samples_per_second"].asDouble();
+
+	for (Json::Value::ArrayIndex i = 0; i < results.size(); i++) {
+		const Json::Value& r = results[i];
+		map<string, double>::const_iterator b =
+			base_speed.find(r["modem"].asString() + '\n' + r["input"].asString());
+		if (b == base_speed.end() || b->second <= 0.0)
+			continue;
+
+		double speed = r["samples_per_second"].asDouble();
+		double change = 100.0 * (speed - b->second) / b->second;
+		if (change >= -benchmark.tolerance)
+			continue;
+
+		LOG_ERROR("modem=%s input=%s: %.1f%% slower than baseline",
+			  r["modem"].asCString(), r["input"].asCString(), -change);
+		Json::Value reg(Json::objectValue);
+		reg["modem"] = r["modem"];
+		reg["input"] = r["input"];
+		reg["baseline_samples_per_second"] = b->second;
+		reg["samples_per_second"] = speed;
+		reg["change_percent"] = change;
+		regressions.append(reg);
+		regressed = true;
+	}
 
-	return nread;
+	return regressions;
 }
@@ -382,6 +382,9 @@ bool configuration::readDefaultsXML()
 	return true;
 }
 
+// The rest sets up and reads the configuration dialog and the rig interface,
+// which dl-fldigi-decode does not have
+#if !DECODER_MODE
 void configuration::loadDefaults()
 {
 // RTTY
@@ -993,3 +996,4 @@ void configuration::initFonts(void)
 		FreqControlFontnbr = font_number(FreqControlFontName.c_str());
 
 }
+#endif // !DECODER_MODE
@@ -91,6 +91,7 @@ static const char* prefix[] = {
 	_("Quiet"), _("Error"), _("Warning"), _("Info"), _("Verbose"), _("Debug")
 };
 
+#if !DECODER_MODE
 static void slider_cb(Fl_Widget* w, void*);
 static void src_menu_cb(Fl_Widget* w, void*);
 
@@ -106,6 +107,7 @@ Fl_Menu_Item src_menu[] = {
 	{ _("Other"), 0, 0, 0, FL_MENU_TOGGLE | FL_MENU_VALUE },
 	{ 0 }
 };
+#endif
 #include <iostream>
 void debug::rotate_log(const char* filename)
 {
@@ -134,6 +136,8 @@ void debug::start(const char* filename)
 	rotate_log(filename);
 	inst = new debug(filename);
 
+	// dl-fldigi-decode has no display: it only writes the log file
+#if !DECODER_MODE
 	window = new Fl_Double_Window(600, 200, _("Event log"));
 	window->xclass(PACKAGE_TARNAME);
 
@@ -161,6 +165,7 @@ void debug::start(const char* filename)
 	dbg_buffer.clear();
 
 	window->end();
+#endif
 }
 
 void debug::stop(void)
@@ -209,7 +214,11 @@ void debug::log(level_e level, const char* func, const char* srcf, int line, con
 	fflush(wfile);
 #endif
 
+#if !DECODER_MODE
 	Fl::awake(sync_text, (void*)nw);
+#else
+	(void)nw;
+#endif
 }
 
 void debug::elog(const char* func, const char* srcf, int line, const char* text)
@@ -219,7 +228,8 @@ void debug::elog(const char* func, const char* srcf, int line, const char* text)
 
 void debug::show(void)
 {
-	window->show();
+	if (window)
+		window->show();
 }
 
 static char buf[BUFSIZ+1];
@@ -279,6 +289,7 @@ debug::~debug()
 	if (rfile) fclose(rfile);
 }
 
+#if !DECODER_MODE
 static void slider_cb(Fl_Widget* w, void*)
 {
 	debug::level = (debug::level_e)((Fl_Slider*)w)->value();
@@ -296,4 +307,4 @@ static void clear_cb(Fl_Widget* w, void*)
 	btext->clear();
 	dbg_buffer.clear();
 }
-
+#endif
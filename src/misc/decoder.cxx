@@ -0,0 +1,359 @@
+// ----------------------------------------------------------------------------
+//      decoder.cxx  --  offline decoder for recorded audio
+//
+// This file is part of fldigi.
+//
+// fldigi is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// fldigi is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// ----------------------------------------------------------------------------
+
+// The decoder is built from the modem, filter and extractor sources of
+// dl-fldigi with DECODER_MODE defined.  This compiles out the qrunner
+// requests, the sound card and the waterfall, so the modems run as fast as
+// the input can be read, and no display is needed.  decoder_ui.cxx stands in
+// for the main window.
+//
+// The modems are process-wide singletons, so several inputs are decoded in
+// parallel by forking one worker process per input.
+
+#include <config.h>
+
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <cmath>
+
+#include <inttypes.h>
+#include <unistd.h>
+#include <sys/types.h>
+#ifndef __WOE32__
+#  include <sys/wait.h>
+#endif
+
+#if USE_SNDFILE
+#  include <sndfile.h>
+#endif
+#include <samplerate.h>
+
+#include "fl_digi.h"
+#include "modem.h"
+#include "trx.h"
+#include "configuration.h"
+#include "status.h"
+#include "util.h"
+#include "debug.h"
+#include "jsoncpp.h"
+
+#include "decoder.h"
+
+using namespace std;
+
+struct decoder_params decoder = { NUM_MODES, 0, false, false, 0.0, 0, SRC_SINC_FASTEST, 0, false };
+
+static int decode_status;
+
+// Decode one input to `out' in this process
+static int decode_input(const string& input, FILE* out)
+{
+	decoder.input = input;
+	decoder.out = out;
+	decode_status = 0;
+
+	TRX_WAIT(STATE_ENDED, trx_start(); init_modem(progStatus.lastmode));
+
+	if (fflush(out) != 0) {
+		LOG_PERROR("fflush");
+		decode_status = 1;
+	}
+	return decode_status;
+}
+
+#ifndef __WOE32__
+static string output_name(const string& input)
+{
+	string name = decoder.output_dir;
+	if (!name.empty() && *name.rbegin() != '/')
+		name += '/';
+
+	string::size_type p = input.rfind('/');
+	name.append(p == string::npos ? input : input.substr(p + 1));
+	if (name.empty() || input == "-")
+		name.append("stdin");
+
+	return name.append(decoder.telemetry ? ".json" : ".txt");
+}
+
+static void decode_child(const string& input)
+{
+	string name = output_name(input);
+	FILE* out = fopen(name.c_str(), "w");
+	if (!out) {
+		LOG_ERROR("Could not open output file \"%s\": %s", name.c_str(), strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	int ret = decode_input(input, out);
+	if (fclose(out) != 0)
+		ret = 1;
+	exit(ret ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+#endif
+
+int setup_decoder(void)
+{
+	ENSURE_THREAD(FLMAIN_TID);
+
+	if (decoder.inputs.empty()) {
+		LOG_ERROR("Missing input");
+		return 1;
+	}
+
+	progdefaults.rsid = false;
+	progdefaults.StartAtSweetSpot = false;
+
+	if (decoder.modem != NUM_MODES)
+		progStatus.lastmode = decoder.modem;
+	if (!decoder_mode_ok(progStatus.lastmode)) {
+		LOG_ERROR("Mode %s is not supported, give one with --decode-modem",
+			  mode_info[progStatus.lastmode].sname);
+		return 1;
+	}
+	if (decoder.freq)
+		progStatus.carrier = decoder.freq;
+	progStatus.afconoff = decoder.afc;
+	progStatus.sqlonoff = decoder.sql;
+	progStatus.sldrSquelchValue = decoder.sqlevel;
+
+	if (decoder.inputs.size() == 1)
+		return decode_input(decoder.inputs[0], stdout);
+
+#ifndef __WOE32__
+	size_t jobs = decoder.jobs;
+	if (jobs == 0) {
+		long n = sysconf(_SC_NPROCESSORS_ONLN);
+		jobs = n > 0 ? n : 1;
+	}
+
+	int ret = 0;
+	size_t next = 0, running = 0;
+	fflush(NULL);
+	while (next < decoder.inputs.size() || running) {
+		if (running < jobs && next < decoder.inputs.size()) {
+			pid_t pid = fork();
+			if (pid == 0)
+				decode_child(decoder.inputs[next]);
+			else if (pid == -1) {
+				LOG_PERROR("fork");
+				ret = 1;
+				if (running == 0)
+					break;
+				jobs = running;
+			}
+			else {
+				LOG_INFO("decoding \"%s\" in process %d", decoder.inputs[next].c_str(), (int)pid);
+				next++;
+				running++;
+			}
+			continue;
+		}
+
+		int status;
+		pid_t pid = wait(&status);
+		if (pid == -1) {
+			if (errno == EINTR)
+				continue;
+			LOG_PERROR("wait");
+			return 1;
+		}
+		running--;
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+			LOG_ERROR("decoder process %d failed", (int)pid);
+			ret = 1;
+		}
+	}
+
+	return ret;
+#else
+	int ret = 0;
+	for (size_t i = 0; i < decoder.inputs.size(); i++)
+		ret |= decode_input(decoder.inputs[i], stdout);
+	return ret;
+#endif
+}
+
+// ----------------------------------------------------------------------------
+
+// Input readers return up to `len' mono samples in `buf', or 0 at the end of
+// the input.
+
+#if USE_SNDFILE
+static SNDFILE* infile;
+static SF_INFO infile_info;
+static float* inframes;
+#else
+static FILE* infile;
+static short* inframes;
+#endif
+
+static size_t read_input(float* buf, size_t len)
+{
+#if USE_SNDFILE
+	if (infile_info.channels == 1)
+		return (size_t)sf_readf_float(infile, buf, len);
+
+	size_t n = (size_t)sf_readf_float(infile, inframes, len);
+	for (size_t i = 0; i < n; i++) // use the first channel
+		buf[i] = inframes[i * infile_info.channels];
+	return n;
+#else
+	size_t n = fread(inframes, sizeof(*inframes), len, infile);
+	for (size_t i = 0; i < n; i++)
+		buf[i] = inframes[i] / 32768.0f;
+	return n;
+#endif
+}
+
+static bool open_input(int& rate)
+{
+	const char* name = decoder.input.c_str();
+	bool use_stdin = decoder.input == "-";
+
+#if USE_SNDFILE
+	memset(&infile_info, 0, sizeof(infile_info));
+	if (use_stdin || decoder.rate) {
+		// headerless input
+		infile_info.samplerate = decoder.rate ? decoder.rate : rate;
+		infile_info.channels = 1;
+		infile_info.format = SF_FORMAT_RAW | SF_FORMAT_PCM_16;
+	}
+	if (use_stdin)
+		infile = sf_open_fd(STDIN_FILENO, SFM_READ, &infile_info, 0);
+	else
+		infile = sf_open(name, SFM_READ, &infile_info);
+	if (!infile) {
+		LOG_ERROR("Could not open input \"%s\": %s", name, sf_strerror(NULL));
+		return false;
+	}
+	rate = infile_info.samplerate;
+	if (infile_info.channels > 1)
+		inframes = new float[DECODER_BLOCKSIZE * infile_info.channels];
+#else
+	if (use_stdin)
+		infile = stdin;
+	else if ((infile = fopen(name, "rb")) == NULL) {
+		LOG_ERROR("Could not open input \"%s\": %s", name, strerror(errno));
+		return false;
+	}
+	if (decoder.rate)
+		rate = decoder.rate;
+	inframes = new short[DECODER_BLOCKSIZE];
+#endif
+
+	return true;
+}
+
+static void close_input(void)
+{
+#if USE_SNDFILE
+	sf_close(infile);
+#else
+	if (infile != stdin)
+		fclose(infile);
+#endif
+	infile = 0;
+	delete [] inframes;
+	inframes = 0;
+}
+
+static float* srcbuf;
+static long src_read_input(void*, float** data)
+{
+	long n = (long)read_input(srcbuf, DECODER_BLOCKSIZE);
+	*data = n ? srcbuf : 0;
+	return n;
+}
+
+// Called by the trx thread in place of the sound card receive loop
+void do_decode(void)
+{
+	ENSURE_THREAD(TRX_TID);
+
+	int modem_rate = active_modem->get_samplerate();
+	int input_rate = modem_rate;
+	if (!open_input(input_rate)) {
+		decode_status = 1;
+		return;
+	}
+
+	LOG_INFO("modem=%" PRIdPTR " (%s) rate=%d input=\"%s\" rate=%d", active_modem->get_mode(),
+		 mode_info[active_modem->get_mode()].sname, modem_rate,
+		 decoder.input.c_str(), input_rate);
+
+	float fbuf[DECODER_BLOCKSIZE];
+	double dbuf[DECODER_BLOCKSIZE];
+	size_t n, nproc = 0;
+
+	active_modem->rx_init();
+
+	if (input_rate == modem_rate) {
+		while ((n = read_input(fbuf, DECODER_BLOCKSIZE))) {
+			for (size_t i = 0; i < n; i++)
+				dbuf[i] = fbuf[i];
+			active_modem->rx_process(dbuf, n);
+			nproc += n;
+		}
+	}
+	else {
+		int err;
+		SRC_STATE* src_state = src_callback_new(src_read_input, decoder.src_type, 1, &err, NULL);
+		if (!src_state) {
+			LOG_ERROR("src_callback_new error %d: %s", err, src_strerror(err));
+			close_input();
+			decode_status = 1;
+			return;
+		}
+		srcbuf = new float[DECODER_BLOCKSIZE];
+		double ratio = (double)modem_rate / input_rate;
+		long r;
+		while ((r = src_callback_read(src_state, ratio, DECODER_BLOCKSIZE, fbuf)) > 0) {
+			for (long i = 0; i < r; i++)
+				dbuf[i] = fbuf[i];
+			active_modem->rx_process(dbuf, r);
+			nproc += r;
+		}
+		src_delete(src_state);
+		delete [] srcbuf;
+		srcbuf = 0;
+	}
+
+	close_input();
+	LOG_INFO("decoded %" PRIuSZ " samples", nproc);
+}
+
+// ----------------------------------------------------------------------------
+
+void decoder_put_char(unsigned int data)
+{
+	if (decoder.out && !decoder.telemetry)
+		putc((char)data, decoder.out);
+}
+
+void decoder_put_telemetry(const Json::Value& data)
+{
+	if (!decoder.out || !decoder.telemetry)
+		return;
+
+	Json::FastWriter writer;
+	fputs(writer.write(data).c_str(), decoder.out);
+}
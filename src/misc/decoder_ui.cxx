@@ -0,0 +1,125 @@
+// ----------------------------------------------------------------------------
+//      decoder_ui.cxx  --  the main window functions, for dl-fldigi-decode
+//
+// This file is part of fldigi.
+//
+// fldigi is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// fldigi is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// ----------------------------------------------------------------------------
+
+// dl-fldigi-decode is linked with this file instead of fl_digi.cxx.  The
+// decoded text goes to the decoder's output, and everything that the modems
+// would show in the main window is dropped.
+
+#include <config.h>
+
+#include <inttypes.h>
+
+#include "fl_digi.h"
+#include "modem.h"
+#include "trx.h"
+#include "debug.h"
+
+#include "nullmodem.h"
+#include "rtty.h"
+#include "psk.h"
+#include "dominoex.h"
+#include "thor.h"
+
+#include "dl_fldigi/extractor.h"
+#include "decoder.h"
+#include "benchmark.h"
+
+bool withnoise = false;
+
+// The main window size, which the status file keeps
+int HNOM = DEFAULT_HNOM;
+int WNOM = 650;
+
+bool decoder_mode_ok(trx_mode mode)
+{
+	return mode == MODE_NULL || trx_extra_mode_ok(mode);
+}
+
+// Returns a new modem for `mode', which must be one that decoder_mode_ok()
+// accepts
+modem* create_modem(trx_mode mode)
+{
+	switch (mode) {
+	case MODE_NULL:
+		return new NULLMODEM;
+
+	case MODE_THOR4: case MODE_THOR5: case MODE_THOR8:
+	case MODE_THOR11:case MODE_THOR16: case MODE_THOR22:
+	case MODE_THOR25x4: case MODE_THOR50x1: case MODE_THOR50x2: case MODE_THOR100:
+		return new thor(mode);
+
+	case MODE_DOMINOEX4: case MODE_DOMINOEX5: case MODE_DOMINOEX8:
+	case MODE_DOMINOEX11: case MODE_DOMINOEX16: case MODE_DOMINOEX22:
+	case MODE_DOMINOEX44: case MODE_DOMINOEX88:
+		return new dominoex(mode);
+
+	case MODE_RTTY:
+		return new rtty(mode);
+
+	default: // all the PSK modes
+		return new psk(mode);
+	}
+}
+
+void init_modem(trx_mode mode, int freq)
+{
+	ENSURE_THREAD(FLMAIN_TID);
+
+	if (!decoder_mode_ok(mode)) {
+		LOG_ERROR("Unsupported mode: %" PRIdPTR, mode);
+		mode = MODE_PSK31;
+	}
+
+	trx_start_modem(*mode_info[mode].modem ? *mode_info[mode].modem :
+			*mode_info[mode].modem = create_modem(mode), freq);
+}
+
+// ----------------------------------------------------------------------------
+
+void put_rx_char(unsigned int data, int style, bool extracted)
+{
+	decoder_put_char(data);
+
+	if (!extracted)
+		dl_fldigi::extractor::put(data);
+}
+
+void batch_rx_chars(void) { }
+void flush_rx_chars(void) { }
+void put_rx_ssdv(unsigned int data, int lost) { }
+void put_sec_char(char chr) { }
+
+int get_tx_char(void) { return benchmark_tx_char(); }
+void put_echo_char(unsigned int data, int style) { }
+
+void put_status(const char *msg, double timeout, status_timeout action) { }
+void put_Status1(const char *msg, double timeout, status_timeout action) { }
+void put_Status2(const char *msg, double timeout, status_timeout action) { }
+void put_MODEstatus(const char* fmt, ...) { }
+void put_MODEstatus(trx_mode mode) { }
+
+void put_freq(double frequency) { }
+void put_Bandwidth(int bandwidth) { }
+void global_display_metric(double metric) { }
+
+void set_scope_mode(Digiscope::scope_mode md) { }
+void set_scope(double *data, int len, bool autoscale) { }
+void set_phase(double phase, double quality, bool highlight) { }
+void set_video(double *data, int len, bool dir) { }
+void set_zdata(cmplx *zarray, int len) { }
@@ -181,6 +181,8 @@ status progStatus = {
 	false				// bool bLastStateRead;
 };
 
+// The window and widget state is only kept by the GUI
+#if !DECODER_MODE
 void status::saveLastState()
 {
     int mX = fl_digi_main->x();
@@ -399,6 +401,7 @@ if (!bWF_only and !bHAB) {
 
 //	spref.set("xml_logbook", xml_logbook);
 }
+#endif // !DECODER_MODE
 
 void status::loadLastState()
 {
@@ -556,11 +559,14 @@ void status::loadLastState()
 	memset(strbuff, 0, sizeof(strbuff));
 	spref.get("browser_search", strbuff, browser_search.c_str(), sizeof(strbuff) - 1);
 	browser_search = strbuff;
+#if !DECODER_MODE
 	seek_re.recompile(browser_search.c_str());
+#endif
 
 //	spref.get("xml_logbook", i, xml_logbook); xml_logbook = i;
 }
 
+#if !DECODER_MODE
 void status::initLastState()
 {
 	if (!bLastStateRead)
@@ -704,3 +710,4 @@ void status::initLastState()
 //	set_server_label(xml_logbook);
 
 }
+#endif // !DECODER_MODE
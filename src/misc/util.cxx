@@ -355,6 +355,49 @@ void MilliSleep(long msecs)
 #endif
 }
 
+#ifndef __MINGW32__
+#  include <sys/mman.h>
+void* mirror_alloc(size_t len)
+{
+	long pagesize = sysconf(_SC_PAGESIZE);
+	if (len == 0 || pagesize <= 0 || len % pagesize)
+		return NULL;
+
+#  if HAVE_MEMFD_CREATE
+	int fd = memfd_create("ringbuffer", MFD_CLOEXEC);
+#  else
+	char name[] = "/tmp/fldigi-rb.XXXXXX";
+	int fd = mkstemp(name);
+	if (fd != -1)
+		unlink(name);
+#  endif
+	if (fd == -1)
+		return NULL;
+
+	// reserve the address space, then map the file over both halves
+	void* p = MAP_FAILED;
+	if (ftruncate(fd, len) == 0 &&
+	    (p = mmap(NULL, 2 * len, PROT_NONE, MAP_PRIVATE | MAP_ANON, -1, 0)) != MAP_FAILED) {
+		if (mmap(p, len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED ||
+		    mmap((char*)p + len, len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+			munmap(p, 2 * len);
+			p = MAP_FAILED;
+		}
+	}
+	close(fd);
+
+	return p == MAP_FAILED ? NULL : p;
+}
+
+void mirror_free(void* p, size_t len)
+{
+	munmap(p, 2 * len);
+}
+#else
+void* mirror_alloc(size_t len) { return NULL; }
+void mirror_free(void* p, size_t len) { }
+#endif // __MINGW32__
+
 /// Returns 0 if a process is running, 0 if not there and -1 if the test cannot be made.
 int test_process(int pid)
 {
@@ -104,6 +104,7 @@ void psk::rx_init()
 {
 	for (int car = 0; car < numcarriers; car++) {
 		phaseacc[car] = 0;
+		rxnco[car].reset();
 		prevsymbol[car] = cmplx (1.0, 0.0);
 	}
 	quality		= cmplx (0.0, 0.0);
@@ -135,7 +136,7 @@ void psk::rx_init()
 
 void psk::restart()
 {
-	if (numcarriers == 1)
+	if (pskviewer)
 		pskviewer->restart(mode);
 	evalpsk->setbw(sc_bw);
 }
@@ -694,12 +695,16 @@ psk::psk(trx_mode pskmode) : modem()
 		syncbuf[i] = 0.0;
 	E1 = E2 = E3 = 0.0;
 	acquire = 0;
+	averageamp = 0.0;
 
 	evalpsk = new pskeval;
-	if (numcarriers == 1) {
-		::pskviewer = pskviewer = new viewpsk(evalpsk, mode);
-	} else
-		::pskviewer = pskviewer = 0;
+	// only the active modem feeds the signal browser
+	if (numcarriers == 1 && !extra)
+		pskviewer = new viewpsk(evalpsk, mode);
+	else
+		pskviewer = 0;
+	if (!extra)
+		::pskviewer = pskviewer;
 
 }
 
@@ -880,6 +885,7 @@ void psk::rx_pskr(unsigned char symbol)
 	}
 }
 
+#if !DECODER_MODE
 void psk::searchDown()
 {
 	double srchfreq = frequency - sc_bw * 2;
@@ -915,6 +921,11 @@ void psk::searchUp()
 		srchfreq += sc_bw;
 	}
 }
+#else
+// There is no waterfall to search in the decoder
+void psk::searchDown() { }
+void psk::searchUp() { }
+#endif
 
 int waitcount = 0;
 
@@ -1013,8 +1024,6 @@ void psk::rx_symbol(cmplx symbol, int car)
 	double softamp;
 	double sigamp = norm(symbol);
 
-static double averageamp;
-
 	phase = arg ( conj(prevsymbol[car]) * symbol );
 	prevsymbol[car] = symbol;
 
@@ -1156,8 +1165,8 @@ void psk::signalquality()
 
 void psk::update_syncscope()
 {
-	static char msg1[15];
-	static char msg2[15];
+	char msg1[15];
+	char msg2[15];
 
 	display_metric(metric);
 
@@ -1167,7 +1176,7 @@ void psk::update_syncscope()
 	imd = 10.0*log10( imdratio );
 	snprintf(msg2, sizeof(msg2), "imd %3d dB", (int)(floor(imd)));
 
-	if (imdValid) {
+	if (imdValid && !extra) {
 		put_Status1(msg1, progdefaults.StatusTimeout, progdefaults.StatusDim ? STATUS_DIM : STATUS_CLEAR);
 		put_Status2(msg2, progdefaults.StatusTimeout, progdefaults.StatusDim ? STATUS_DIM : STATUS_CLEAR);
 	}
@@ -1182,9 +1191,11 @@ int psk::rx_process(const double *buf, int len)
 	bool can_rx_symbol = false;
 
 	if (numcarriers == 1) {
+#if !DECODER_MODE
 		if (!progdefaults.report_when_visible ||
 			 dlgViewer->visible() || progStatus.show_channels )
 			if (pskviewer && !bHistory) pskviewer->rx_process(buf, len);
+#endif
 		if (evalpsk)
 			evalpsk->sigdensity();
 	}
@@ -1196,30 +1207,34 @@ int psk::rx_process(const double *buf, int len)
 			delta[car] = TWOPI * frequencies[car] / samplerate;
 	}
 
-	while (len-- > 0) {
+	// Mix the whole block with the internal NCO for each carrier,
+	// then filter and downsample it in place
+	// by 16 (psk31, qpsk31)
+	// by  8 (psk63, qpsk63)
+	// by  4 (psk125, qpsk125)
+	// by  2 (psk250, qpsk250)
+	// by  1 (psk500, qpsk500) = no down sampling
+	// The first filters of all carriers decimate in step, so each
+	// returns the same number of samples.
+	int nout = 0;
+	rxmix.resize((size_t)numcarriers * len);
+	for (int car = 0; car < numcarriers; car++) {
+		rxnco[car].set_step(delta[car]);
+		rxnco[car].mix(&rxmix[car * len], buf, len);
+		nout = fir1[car]->run(&rxmix[car * len], &rxmix[car * len], len);
+	}
 
-	   for (int car = 0; car < numcarriers; car++) {
+	for (int smpl = 0; smpl < nout; smpl++) {
 
-		// Mix with the internal NCO
-		z = cmplx ( *buf * cos(phaseacc[car]), *buf * sin(phaseacc[car]) );
+	   for (int car = 0; car < numcarriers; car++) {
 
-		phaseacc[car] += delta[car];
-		if (phaseacc[car] > M_PI)
-			phaseacc[car] -= TWOPI;
+		z = rxmix[car * len + smpl];
 
-		// Filter and downsample
-		// by 16 (psk31, qpsk31)
-		// by  8 (psk63, qpsk63)
-		// by  4 (psk125, qpsk125)
-		// by  2 (psk250, qpsk250)
-		// by  1 (psk500, qpsk500) = no down sampling
-		// first filter
-		if (fir1[car]->run( z, z )) { // fir1 returns true every Nth sample
-		    // final filter
-		    fir2[car]->run( z, z2[car] ); // fir2 returns value on every sample
+		// final filter
+		fir2[car]->run( z, z2[car] ); // fir2 returns value on every sample
 
-		    //On last carrier processing
-		    if (car == numcarriers - 1) { 
+		//On last carrier processing
+		if (car == numcarriers - 1) { 
 
 			calcSN_IMD(z); //JD OR all carriers together check logic???
 
@@ -1334,9 +1349,8 @@ int psk::rx_process(const double *buf, int len)
 				update_syncscope();
 				afc();
 			}
-		    }
-
 		}
+
 	   }
 	   if (can_rx_symbol) {
 		for (int car = 0; car < numcarriers; car++) {
@@ -1344,7 +1358,6 @@ int psk::rx_process(const double *buf, int len)
 		}
 	   	can_rx_symbol = false;
 	   }
- 	   buf++;
 	}
 
 	if (sigsearch)
@@ -44,7 +44,10 @@ pskeval::~pskeval() {
 int countdown = 8;
 int rows = 0;
 
+// The signal density is taken from the waterfall, which dl-fldigi-decode does
+// not have; there, sigpeak() finds nothing
 void pskeval::sigdensity() {
+#if !DECODER_MODE
 	int ihbw = (int)(0.6*bw);
 	int ibw = 2 * ihbw;
 
@@ -75,6 +78,7 @@ void pskeval::sigdensity() {
 
 	if (sigmin < 1e-8) sigmin = 1e-8;
 	delete [] vals;
+#endif
 }
 
 double pskeval::sigpeak(int &f, int f1, int f2)
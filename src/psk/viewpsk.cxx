@@ -25,6 +25,10 @@
 // channels.  Each channel is separately decoded and the decoded characters
 // passed to the user interface routines for presentation.  The number of
 // channels can be up to and including 30.
+//
+// All channels share one polyphase filter bank which does the work of the
+// per channel mixer and first decimating filter, so the cost of a pass no
+// longer grows with the number of channels being decoded.
 
 #include <config.h>
 
@@ -52,10 +56,9 @@ extern waterfall *wf;
 
 viewpsk::viewpsk(pskeval* eval, trx_mode pskmode)
 {
-	for (int i = 0; i < MAXCHANNELS; i++) {
-		channel[i].fir1 = (C_FIR_filter *)0;
+	for (int i = 0; i < MAXCHANNELS; i++)
 		channel[i].fir2 = (C_FIR_filter *)0;
-	}
+	chan = 0;
 
 	evalpsk = eval;
 	viewmode = MODE_PREV;
@@ -64,10 +67,9 @@ viewpsk::viewpsk(pskeval* eval, trx_mode pskmode)
 
 viewpsk::~viewpsk()
 {
-	for (int i = 0; i < MAXCHANNELS; i++) {
-		if (channel[i].fir1) delete channel[i].fir1;
+	for (int i = 0; i < MAXCHANNELS; i++)
 		if (channel[i].fir2) delete channel[i].fir2;
-	}
+	delete chan;
 }
 
 void viewpsk::init()
@@ -76,7 +78,7 @@ void viewpsk::init()
 	lowfreq = progdefaults.LowFreqCutoff;
 
 	for (int i = 0; i < MAXCHANNELS; i++) {
-		channel[i].phaseacc = 0;
+		channel[i].osc.reset();
 		channel[i].prevsymbol = cmplx (1.0, 0.0);
 		channel[i].quality = cmplx (0.0, 0.0);
 		channel[i].shreg = 0;
@@ -103,7 +105,6 @@ void viewpsk::restart(trx_mode pskmode)
 	if (viewmode == pskmode) return;
 	viewmode = pskmode;
 
-	double			fir1c[64];
 	double			fir2c[64];
 
 	switch (viewmode) {
@@ -137,14 +138,9 @@ void viewpsk::restart(trx_mode pskmode)
 		break;
 	}
 
-	wsincfilt(fir1c, 1.0 / symbollen, true);	// creates fir1c matched sin(x)/x filter w blackman
 	wsincfilt(fir2c, 1.0 / 16.0, true);			// creates fir2c matched sin(x)/x filter w blackman
 
 	for (int i = 0; i < MAXCHANNELS; i++) {
-		if (channel[i].fir1) delete channel[i].fir1;
-		channel[i].fir1 = new C_FIR_filter();
-		channel[i].fir1->init(FIRLEN, symbollen / 16, fir1c, fir1c);
-
 		if (channel[i].fir2) delete channel[i].fir2;
 		channel[i].fir2 = new C_FIR_filter();
 		channel[i].fir2->init(FIRLEN, 1, fir2c, fir2c);
@@ -152,6 +148,13 @@ void viewpsk::restart(trx_mode pskmode)
 
 	bandwidth = VPSKSAMPLERATE / symbollen;
 
+// The prototype passes a signal up to half a bin away from the bin centre,
+// and its transition band ends below the decimated Nyquist frequency.
+	delete chan;
+	chan = new channelizer(VCHANBINS, VCHANTAPS, symbollen / 16,
+		(VPSKSAMPLERATE / (2.0 * VCHANBINS) + bandwidth) / VPSKSAMPLERATE +
+		2.75 / VCHANTAPS);
+
 	init();
 }
 
@@ -346,36 +349,43 @@ int viewpsk::rx_process(const double *buf, int len)
 	if (nchannels != progdefaults.VIEWERchannels || lowfreq != progdefaults.LowFreqCutoff)
 		init();
 
+	int dec = chan->decimation();
+	bool active = false;
+	for (int ch = 0; ch < nchannels; ch++)
+		if (channel[ch].frequency != NULLFREQ)
+			active = true;
+
 // process all channels
-	for (int ch = 0; ch < nchannels; ch++) {
-		if (channel[ch].frequency == NULLFREQ) continue;
-		for (int ptr = 0; ptr < len; ptr++) {
-// Mix with the internal NCO for each channel
-			z = cmplx ( buf[ptr] * cos(channel[ch].phaseacc), buf[ptr] * sin(channel[ch].phaseacc) );
-			channel[ch].phaseacc += 2.0 * M_PI * channel[ch].frequency / VPSKSAMPLERATE;
-// filter & decimate
-			if (channel[ch].fir1->run( z, z )) {
-				channel[ch].fir2->run( z, z2 );
-				idx = (int) channel[ch].bitclk;
-				sum = 0.0;
-				ampsum = 0.0;
-				channel[ch].syncbuf[idx] = 0.8 * channel[ch].syncbuf[idx] + 0.2 * abs(z2);
-
-				for (int i = 0; i < 8; i++) {
-					sum += (channel[ch].syncbuf[i] - channel[ch].syncbuf[i+8]);
-					ampsum += (channel[ch].syncbuf[i] + channel[ch].syncbuf[i+8]);
-				}
-				sum = (ampsum == 0 ? 0 : sum / ampsum);
+	for (int ptr = 0; ptr < len; ptr++) {
+		if (!chan->push(buf[ptr]) || !active)
+			continue;
+		chan->process();
+		for (int ch = 0; ch < nchannels; ch++) {
+			if (channel[ch].frequency == NULLFREQ) continue;
+// Take the channel's bin and finish mixing it with the internal NCO
+			channel[ch].osc.set_step(2.0 * M_PI * channel[ch].frequency * dec / VPSKSAMPLERATE);
+			z = channel[ch].osc.mix(chan->bin(chan->nearest(channel[ch].frequency / VPSKSAMPLERATE)));
+
+			channel[ch].fir2->run( z, z2 );
+			idx = (int) channel[ch].bitclk;
+			sum = 0.0;
+			ampsum = 0.0;
+			channel[ch].syncbuf[idx] = 0.8 * channel[ch].syncbuf[idx] + 0.2 * abs(z2);
+
+			for (int i = 0; i < 8; i++) {
+				sum += (channel[ch].syncbuf[i] - channel[ch].syncbuf[i+8]);
+				ampsum += (channel[ch].syncbuf[i] + channel[ch].syncbuf[i+8]);
+			}
+			sum = (ampsum == 0 ? 0 : sum / ampsum);
 
-				channel[ch].bitclk -= sum / 5.0;
-				channel[ch].bitclk += 1;
+			channel[ch].bitclk -= sum / 5.0;
+			channel[ch].bitclk += 1;
 
-				if (channel[ch].bitclk < 0) channel[ch].bitclk += 16.0;
-				if (channel[ch].bitclk >= 16.0) {
-					channel[ch].bitclk -= 16.0;
-					rx_symbol(ch, z2);
-					afc(ch);
-				}
+			if (channel[ch].bitclk < 0) channel[ch].bitclk += 16.0;
+			if (channel[ch].bitclk >= 16.0) {
+				channel[ch].bitclk -= 16.0;
+				rx_symbol(ch, z2);
+				afc(ch);
 			}
 		}
 	}
@@ -31,6 +31,10 @@
 #  include "compat.h"
 #endif
 #include <fcntl.h>
+#if HAVE_EVENTFD
+#  include <stdint.h>
+#  include <sys/eventfd.h>
+#endif
 
 #include <FL/Fl.H>
 
@@ -47,21 +51,26 @@
 #endif
 
 qrunner::qrunner()
-        : attached(false), inprog(false), drop_flag(false)
+        : attached(false), inprog(false), pending(0), hwm(0), ndropped(0), drop_flag(false)
 {
         fifo = new fqueue(FIFO_SIZE);
-#ifndef __WOE32__
-        if (pipe(pfd) == -1)
+#if HAVE_EVENTFD
+	if ((pfd[0] = pfd[1] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == -1)
+		throw qexception(errno);
 #else
+#  ifndef __WOE32__
+        if (pipe(pfd) == -1)
+#  else
 	if (socketpair(PF_INET, SOCK_STREAM, 0, pfd) == -1)
-#endif
+#  endif
                 throw qexception(errno);
 	set_cloexec(pfd[0], 1);
 	set_cloexec(pfd[1], 1);
 	if (set_nonblock(pfd[0], 1) == -1)
 		throw qexception(errno);
-#ifdef __WOE32__
+#  ifdef __WOE32__
 	set_nodelay(pfd[1], 1);
+#  endif
 #endif
 }
 
@@ -69,10 +78,22 @@ qrunner::~qrunner()
 {
         detach();
         close(pfd[0]);
-        close(pfd[1]);
+        if (pfd[1] != pfd[0])
+                close(pfd[1]);
         delete fifo;
 }
 
+void qrunner::ring(void)
+{
+#if HAVE_EVENTFD
+	uint64_t one = 1;
+	if (unlikely(write(pfd[1], &one, sizeof(one)) != sizeof(one)))
+#else
+	if (unlikely(QRUNNER_WRITE(pfd[1], "", 1) != 1))
+#endif
+		throw qexception(errno);
+}
+
 void qrunner::attach(void)
 {
         Fl::add_fd(pfd[0], FL_READ, qrunner::execute, this);
@@ -84,7 +105,7 @@ void qrunner::detach(void)
         Fl::remove_fd(pfd[0], FL_READ);
 }
 
-static unsigned char rbuf[FIFO_SIZE];
+static unsigned char rbuf[64];
 
 void qrunner::execute(int fd, void *arg)
 {
@@ -94,18 +115,15 @@ void qrunner::execute(int fd, void *arg)
 		return;
 	qr->inprog = true;
 
-	size_t n = QRUNNER_READ(fd, rbuf, FIFO_SIZE);
-	switch (n) {
-	case -1:
-		if (!QRUNNER_EAGAIN())
-			throw qexception(errno);
-		// else fall through
-	case 0:
-		break;
-	default:
-		while (n--)
-			qr->fifo->execute();
-	}
+	// Silence the doorbell and re-arm it before looking at the queue, so
+	// that a request queued from now on rings it again
+	if (QRUNNER_READ(fd, rbuf, sizeof(rbuf)) == -1 && !QRUNNER_EAGAIN())
+		throw qexception(errno);
+	__sync_fetch_and_and(&qr->pending, 0);
+
+	// Run what is queued now, but not the requests that those queue
+	for (size_t n = qr->fifo->size(); n && qr->fifo->execute(); n--)
+		;
 
 	qr->inprog = false;
 }
@@ -76,7 +76,7 @@ const int cRsId::indices[] = {
 	2, 4, 8, 9, 11, 15, 7, 14, 5, 10, 13, 3
 };
 
-cRsId::cRsId()
+cRsId::cRsId() : events(8)
 {
 	int error;
 	src_state = src_new(progdefaults.sample_converter, 1, &error);
@@ -118,6 +118,14 @@ cRsId::cRsId()
 		Encode(rsid_ids_2[i].rs, c);
 	}
 
+	pWords1 = new uint64_t[rsid_ids_size1];
+	for (int i = 0; i < rsid_ids_size1; i++)
+		pWords1[i] = PackSymbols(pCodes1 + i * RSID_NSYMBOLS);
+
+	pWords2 = new uint64_t[rsid_ids_size2];
+	for (int i = 0; i < rsid_ids_size2; i++)
+		pWords2[i] = PackSymbols(pCodes2 + i * RSID_NSYMBOLS);
+
 #if 0
 	printf("pcode 1\n");
 	printf(",rs, name, mode,0,1,2,3,4,5,6,7,8,9,10,11,12,13,14\n");
@@ -151,6 +159,8 @@ cRsId::~cRsId()
 {
 	delete [] pCodes1;
 	delete [] pCodes2;
+	delete [] pWords1;
+	delete [] pWords2;
 
 	delete [] outbuf;
 	delete rsfft;
@@ -167,7 +177,9 @@ void cRsId::reset()
 	memset(aInputSamples, 0, (RSID_ARRAY_SIZE * 2) * sizeof(float));
 	memset(aFFTcmplx, 0, RSID_ARRAY_SIZE * sizeof(rs_cpx_type));
 	memset(aFFTAmpl, 0, RSID_FFT_SIZE * sizeof(rs_fft_type));
-	memset(fft_buckets, 0, RSID_NTIMES * RSID_FFT_SIZE * sizeof(int));
+	memset(fft_buckets, 0, sizeof(fft_buckets));
+	memset(bucket_planes, 0, sizeof(bucket_planes));
+	cur_planes = 0;
 
 	int error = src_reset(src_state);
 	if (error)
@@ -217,11 +229,39 @@ void cRsId::CalculateBuckets(const rs_fft_type *pSpectrum, int iBegin, int iEnd)
 				iBucketMax = j;
 			}
 		}
-		fft_buckets[RSID_NTIMES - 1][i] = (iBucketMax - i) >> 1;
+		fft_buckets[i] = (iBucketMax - i) >> 1;
 	}
 }
 
-void cRsId::receive(const float* buf, size_t len)
+uint64_t cRsId::PackSymbols(const unsigned char *rsid)
+{
+	uint64_t w = 0;
+	for (int i = 0; i < RSID_NSYMBOLS; i++)
+		for (int b = 0; b < 4; b++)
+			if (rsid[i] & (1 << b))
+				w |= (uint64_t)1 << (16 * b + i);
+	return w;
+}
+
+// Adds the newest slice of buckets to the set that ends with the slice
+// before the last, which then becomes the newest set
+void cRsId::UpdatePlanes(void)
+{
+	cur_planes ^= 1;
+	uint64_t *p = bucket_planes[cur_planes];
+	// drop the oldest symbol of every lane, without letting the lowest
+	// bit of a lane into the top of the lane below, and put the newest
+	// in bit 14
+	for (int i = 0; i < RSID_FFT_SIZE; i++) {
+		uint64_t v = fft_buckets[i];
+		p[i] = ((p[i] >> 1) & 0x7fff7fff7fff7fffULL) |
+			(v & 1) << 14 | (v & 2) << 29 | (v & 4) << 44 | (v & 8) << 59;
+	}
+}
+
+// Called with the input at receive position pos, by the RSID stage thread or
+// by the trx thread
+void cRsId::receive(const float* buf, size_t len, size_t pos)
 {
 
 	if (len == 0) return;
@@ -258,6 +298,7 @@ void cRsId::receive(const float* buf, size_t len)
 		inptr += gend;
 		buf += used;
 		srclen -= used;
+		rxpos = pos + len - srclen;
 
 		while (inptr >= RSID_ARRAY_SIZE) {
 			search();
@@ -270,13 +311,14 @@ void cRsId::receive(const float* buf, size_t len)
 
 void cRsId::search(void)
 {
+	float bpf = 1.0 * RSID_ARRAY_SIZE / RSID_SAMPLE_RATE;
 	if (progdefaults.rsidWideSearch) {
+		// everything below the Nyquist frequency of the input
 		nBinLow = 3;
-		nBinHigh = RSID_FFT_SIZE - 32;
+		nBinHigh = (int)(active_modem->get_samplerate() / 2.0 * bpf);
 	}
 	else {
 		float centerfreq = active_modem->get_freq();
-		float bpf = 1.0 * RSID_ARRAY_SIZE / RSID_SAMPLE_RATE;
 		nBinLow = (int)((centerfreq  - 100.0 * 2) * bpf);
 		nBinHigh = (int)((centerfreq  + 100.0 * 2) * bpf);
 	}
@@ -318,13 +360,11 @@ void cRsId::search(void)
 		bucket_high = RSID_FFT_SIZE - bucket_low;
 	}
 
-	memmove(fft_buckets,
-			&(fft_buckets[1][0]),
-			(RSID_NTIMES - 1) * RSID_FFT_SIZE * sizeof(int));
-	memset(&(fft_buckets[RSID_NTIMES - 1][0]), 0, RSID_FFT_SIZE * sizeof(int));
+	memset(fft_buckets, 0, sizeof(fft_buckets));
 
 	CalculateBuckets ( aFFTAmpl, bucket_low,  bucket_high - RSID_NTIMES);
 	CalculateBuckets ( aFFTAmpl, bucket_low + 1, bucket_high - RSID_NTIMES);
+	UpdatePlanes();
 
 	int symbol_out_1 = -1;
 	int bin_out_1    = -1;
@@ -332,12 +372,12 @@ void cRsId::search(void)
 	int bin_out_2    = -1;
 
 	if (rsid_secondary_time_out == 0) {
-		found1 = search_amp(bin_out_1, symbol_out_1, pCodes1);
+		found1 = search_amp(bin_out_1, symbol_out_1, pWords1);
 		if (found1) {
 			if (symbol_out_1 != RSID_ESCAPE) {
 				if (bReverse)
 					bin_out_1 = 1024 - bin_out_1 - 31;
-				apply(bin_out_1, symbol_out_1, 0);
+				post(bin_out_1, symbol_out_1, 0);
 				reset();
 				return;
 			} else {
@@ -348,12 +388,12 @@ void cRsId::search(void)
 			return;
 	}
 
-	found2 = search_amp(bin_out_2, symbol_out_2, pCodes2);
+	found2 = search_amp(bin_out_2, symbol_out_2, pWords2);
 	if (found2) {
 		if (symbol_out_2 != RSID_NONE2) {
 			if (bReverse)
 				bin_out_2 = 1024 - bin_out_2 - 31;
-			apply(bin_out_2, symbol_out_2, 1);
+			post(bin_out_2, symbol_out_2, 1);
 		}
 		reset();
 	}
@@ -581,6 +621,36 @@ void cRsId::setup_mode(int iSymbol)
 	} // switch (iSymbol)
 }
 
+// Queues a detection for apply_pending()
+void cRsId::post(int iBin, int iSymbol, int extended)
+{
+	rsid_event ev = { iBin, iSymbol, extended, rxpos };
+	if (events.write(&ev, 1) == 0)
+		LOG_WARN("RSID: dropping code %d, the trx thread is not reading detections", iSymbol);
+}
+
+// Applies the queued detections.  pos is the current receive position.
+void cRsId::apply_pending(size_t pos)
+{
+	ENSURE_THREAD(TRX_TID);
+
+	rsid_event ev;
+	while (events.read(&ev, 1)) {
+		LOG_DEBUG("RSID: code %d detected %" PRIuSZ " samples ago",
+			  ev.symbol, pos - ev.pos);
+		apply(ev.bin, ev.symbol, ev.extended);
+	}
+}
+
+// Discards the queued detections, which were made in input that preceded
+// a transmission or a restart of the receiver
+void cRsId::clear_pending(void)
+{
+	ENSURE_THREAD(TRX_TID);
+
+	events.read_advance(events.read_space());
+}
+
 void cRsId::apply(int iBin, int iSymbol, int extended)
 {
 	ENSURE_THREAD(TRX_TID);
@@ -648,7 +718,7 @@ void cRsId::apply(int iBin, int iSymbol, int extended)
 			active_modem->get_mode(), 0LL, currfreq);
 
 	if(active_modem) // Currently only effects Olivia, Contestia and MT63.
-		active_modem->rx_flush();
+		trx_rx_flush();
 
 	setup_mode(iSymbol);
 
@@ -659,20 +729,15 @@ void cRsId::apply(int iBin, int iSymbol, int extended)
 
 }
 
-inline int cRsId::HammingDistance(int iBucket, unsigned char *p2)
+// Number of symbols that differ: a symbol differs if any of its 4 bit
+// planes does
+inline int cRsId::HammingDistance(int iBucket, uint64_t code)
 {
-	int dist = 0;
-	for (int i = 0, j = 1; i < RSID_NSYMBOLS; i++, j += 2) {
-		if (fft_buckets[j][iBucket] != p2[i]) {
-			++dist;
-			if (dist > hamming_resolution)
-				break;
-		}
-	}
-	return dist;
+	uint64_t x = bucket_planes[cur_planes][iBucket] ^ code;
+	return __builtin_popcountll((x | (x >> 16) | (x >> 32) | (x >> 48)) & 0x7fff);
 }
 
-bool cRsId::search_amp( int &bin_out, int &symbol_out, unsigned char *pcode)
+bool cRsId::search_amp( int &bin_out, int &symbol_out, const uint64_t *pcode)
 {
 	int i, j;
 	int iDistanceMin = 1000;  // infinity
@@ -683,7 +748,7 @@ bool cRsId::search_amp( int &bin_out, int &symbol_out, unsigned char *pcode)
 	int tblsize;
 	const RSIDs *prsid;
 
-	if (pcode == pCodes1) {
+	if (pcode == pWords1) {
 		tblsize = rsid_ids_size1;
 		prsid = rsid_ids_1;
 	} else {
@@ -691,9 +756,8 @@ bool cRsId::search_amp( int &bin_out, int &symbol_out, unsigned char *pcode)
 		prsid = rsid_ids_2;
 	}
 
-	unsigned char *pc = 0;
 	for (i = 0; i < tblsize; i++) {
-		pc = pcode + i * RSID_NSYMBOLS;
+		uint64_t pc = pcode[i];
 		for (j = nBinLow; j < nBinHigh - RSID_NTIMES; j++) {
 			iDistance = HammingDistance(j, pc);
 			if (iDistance < iDistanceMin) {
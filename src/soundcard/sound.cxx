@@ -1417,7 +1417,7 @@ void SoundPort::src_data_reset(unsigned dir)
 		}
 		if (!sd[dir].rb || sd[dir].rb->length() != rbsize) {
 				delete sd[dir].rb;
-				sd[dir].rb = new ringbuffer<float>(rbsize);
+				sd[dir].rb = new ringbuffer<float>(rbsize, true);
 		}
 }
 
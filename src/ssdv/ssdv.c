@@ -1283,12 +1283,56 @@ char ssdv_dec_get_jpeg(ssdv_t *s, uint8_t **jpeg, size_t *length)
 	return(SSDV_OK);
 }
 
+static char ssdv_dec_header_ok(uint8_t *packet)
+{
+	ssdv_packet_info_t p;
+	
+	ssdv_dec_header(&p, packet);
+	if(p.width == 0 || p.height == 0) return(0);
+	if(p.mcu_id != 0xFFFF)
+	{
+		if(p.mcu_id >= p.mcu_count) return(0);
+		if(p.mcu_offset >= SSDV_PKT_SIZE_PAYLOAD) return(0);
+	}
+	
+	return(1);
+}
+
+static char ssdv_dec_crc_ok(uint8_t *packet)
+{
+	uint32_t x;
+	uint8_t *c;
+	
+	x = crc32(&packet[1], SSDV_PKT_SIZE_CRCDATA);
+	c = &packet[1 + SSDV_PKT_SIZE_CRCDATA];
+	
+	return(c[0] == ((x >> 24) & 0xFF) &&
+	       c[1] == ((x >> 16) & 0xFF) &&
+	       c[2] == ((x >> 8) & 0xFF) &&
+	       c[3] == (x & 0xFF));
+}
+
+char ssdv_dec_is_candidate(uint8_t *packet, uint8_t *erasures)
+{
+	char sync, type;
+	
+	/* The sync and packet type bytes are fixed. With one of them
+	 * damaged the header must at least look right. */
+	sync = (packet[0] == 0x55 || (erasures && erasures[0]));
+	type = (packet[1] == 0x66 || (erasures && erasures[1]));
+	
+	if(sync && type) return(1);
+	if(sync || type) return(ssdv_dec_header_ok(packet));
+	
+	return(0);
+}
+
 char ssdv_dec_is_packet(uint8_t *packet, int *errors, uint8_t *erasures)
 {
 	uint8_t pkt[SSDV_PKT_SIZE];
-	ssdv_packet_info_t p;
+	uint8_t parity[SSDV_PKT_SIZE_RSCODES];
+	uint8_t *rscodes;
 	int eras_pos[32], no_eras;
-	uint32_t x;
 	int i;
 	
 	/* Testing is destructive, work on a copy */
@@ -1296,6 +1340,23 @@ char ssdv_dec_is_packet(uint8_t *packet, int *errors, uint8_t *erasures)
 	pkt[0] = 0x55;
 	pkt[1] = 0x66;
 	
+	/* If the checksum already matches, only the RS codes can be
+	 * damaged. Generating them again is cheaper than decoding. */
+	if(ssdv_dec_header_ok(pkt) && ssdv_dec_crc_ok(pkt))
+	{
+		rscodes = &pkt[SSDV_PKT_SIZE - SSDV_PKT_SIZE_RSCODES];
+		encode_rs_8(&pkt[1], parity, 0);
+		
+		for(i = 0, no_eras = 0; i < SSDV_PKT_SIZE_RSCODES; i++)
+			if(rscodes[i] != parity[i]) no_eras++;
+		
+		memcpy(rscodes, parity, SSDV_PKT_SIZE_RSCODES);
+		if(errors) *errors = no_eras;
+		memcpy(packet, pkt, SSDV_PKT_SIZE);
+		
+		return(0);
+	}
+	
 	/* Find the erasure positions */
 	no_eras = 0;
 	if(erasures)
@@ -1314,23 +1375,10 @@ char ssdv_dec_is_packet(uint8_t *packet, int *errors, uint8_t *erasures)
 	
 	/* Sanity checks */
 	if(pkt[1] != 0x66) return(-1);
-	
-	ssdv_dec_header(&p, pkt);
-	if(p.width == 0 || p.height == 0) return(-1);
-	if(p.mcu_id != 0xFFFF)
-	{
-		if(p.mcu_id >= p.mcu_count) return(-1);
-		if(p.mcu_offset >= SSDV_PKT_SIZE_PAYLOAD) return(-1);
-	}
+	if(!ssdv_dec_header_ok(pkt)) return(-1);
 	
 	/* Test the checksum */
-	x = crc32(&pkt[1], SSDV_PKT_SIZE_CRCDATA);
-	
-	i = 1 + SSDV_PKT_SIZE_CRCDATA;
-	if(pkt[i++] != ((x >> 24) & 0xFF)) return(-1);
-	if(pkt[i++] != ((x >> 16) & 0xFF)) return(-1);
-	if(pkt[i++] != ((x >> 8) & 0xFF)) return(-1);
-	if(pkt[i++] != (x & 0xFF)) return(-1);
+	if(!ssdv_dec_crc_ok(pkt)) return(-1);
 	
 	/* Appears to be a valid packet! Copy it back */
 	memcpy(packet, pkt, SSDV_PKT_SIZE);
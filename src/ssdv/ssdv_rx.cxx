@@ -5,7 +5,10 @@
 #include <setjmp.h>
 #include "ssdv_rx.h"
 
-#include <curl/curl.h>
+#include "threads.h"
+#include "qrunner.h"
+#include "timeops.h"
+#include "debug.h"
 
 /* For put_status() */
 #include "fl_digi.h"
@@ -13,14 +16,8 @@
 /* For progdefaults */
 #include "configuration.h"
 
-/* For online() getter */
-#include "dl_fldigi/dl_fldigi.h"
-
-/* Used for passing curl data to post thread */
-typedef struct {
-	CURL *curl;
-	struct curl_httppost* post;
-} ssdv_post_data_t;
+/* For the packet uploader */
+#include "dl_fldigi/ssdv_upload.h"
 
 #if 1
 
@@ -135,12 +132,49 @@ ssdv_error_exit (j_common_ptr cinfo)
 
 /**** END JPEG STUFF *****/
 
+/* Copies the decoder state in src to dst, with its own copy of the JPEG
+ * written so far and room to finish it, so that ssdv_dec_get_jpeg() can
+ * be called on dst while src carries on */
+static bool ssdv_dec_copy(ssdv_t *dst, const ssdv_t *src)
+{
+	size_t used = src->outp - src->out;
+	size_t len = used + src->mcu_count * 16 + 1024;
+	uint8_t *out = (uint8_t *) malloc(len);
+	if(!out) return(false);
+	memcpy(out, src->out, used);
+	
+	*dst = *src;
+	
+	/* The tables live in the struct itself */
+	for(int i = 0; i < 2; i++)
+	{
+		dst->sdqt[i] = dst->stbls + (src->sdqt[i] - src->stbls);
+		dst->ddqt[i] = dst->dtbls + (src->ddqt[i] - src->dtbls);
+		for(int j = 0; j < 2; j++)
+		{
+			dst->sdht[i][j] = dst->stbls + (src->sdht[i][j] - src->stbls);
+			dst->ddht[i][j] = dst->dtbls + (src->ddht[i][j] - src->dtbls);
+		}
+	}
+	
+	dst->out = out;
+	dst->outp = out + used;
+	dst->out_len = len - used;
+	
+	return(true);
+}
+
+const double ssdv_rx::UPDATE_INTERVAL = 2.0;
+
 #define UI_HEIGHT (60)
 #define WIN_MIN_WIDTH (320)
 #define WIN_MIN_HEIGHT (32 + UI_HEIGHT)
 #define WIN_MAX_WIDTH (800)
 #define WIN_MAX_HEIGHT (600 + UI_HEIGHT)
 
+/* Bytes queued for the SSDV thread, over 16 packets */
+#define INPUT_SIZE (4096)
+
 ssdv_rx::ssdv_rx(int w, int h, const char *title)
 	: Fl_Double_Window(w, h, title)
 {
@@ -152,9 +186,36 @@ ssdv_rx::ssdv_rx(int w, int h, const char *title)
 	
 	/* No image yet */
 	packets = NULL;
+	packets_len = 0;
+	rgb = NULL;
+	rgb_len = 0;
 	image = NULL;
+	image_shown_width = 0;
+	image_shown_height = 0;
 	flrgb = NULL;
 	image_id = -1;
+	dec_ok = false;
+	dec_next = 0;
+	dirty_row = -1;
+	update_due.tv_sec = 0;
+	update_due.tv_nsec = 0;
+	update_dirty = false;
+	
+	/* Nothing for the GUI thread yet */
+	status_ready = false;
+	frame = NULL;
+	frame_width = 0;
+	frame_height = 0;
+	frame_row = -1;
+	
+	/* The SSDV thread is started by the first put_byte() */
+	input = new ringbuffer<rx_byte>(INPUT_SIZE);
+	input_lost = 0;
+	pthread_mutex_init(&rx_mutex, NULL);
+	pthread_cond_init(&rx_cond, NULL);
+	rx_running = false;
+	rx_quit = false;
+	rx_pending = false;
 	
 	begin();
 	
@@ -238,10 +299,104 @@ ssdv_rx::ssdv_rx(int w, int h, const char *title)
 
 ssdv_rx::~ssdv_rx()
 {
+	if(rx_running)
+	{
+		pthread_mutex_lock(&rx_mutex);
+		rx_quit = true;
+		pthread_cond_signal(&rx_cond);
+		pthread_mutex_unlock(&rx_mutex);
+		pthread_join(rx_thread, NULL);
+	}
+	pthread_cond_destroy(&rx_cond);
+	pthread_mutex_destroy(&rx_mutex);
+	
+	delete input;
+	if(dec_ok) free(dec.out);
+	if(packets) free(packets);
 	if(flrgb) delete flrgb;
-	if(image) delete image;
-	if(buffer) delete buffer;
-	if(erasures) delete erasures;
+	delete [] image;
+	delete [] frame;
+	delete [] rgb;
+	delete [] buffer;
+	delete [] erasures;
+}
+
+void ssdv_rx::put_byte(uint8_t byte, int lost)
+{
+	/* Only the modem's thread calls this, so it alone writes to input
+	 * and rx_running, and needs no lock once the thread is running */
+	if(!rx_running)
+	{
+		guard_lock lock(&rx_mutex);
+		
+		if(pthread_create(&rx_thread, NULL, rx_loop, this) != 0)
+		{
+			LOG_PERROR("pthread_create");
+			return;
+		}
+		rx_running = true;
+	}
+	
+	/* Count the byte as lost if the SSDV thread has fallen behind */
+	if(input->write_space() == 0)
+	{
+		input_lost += lost + 1;
+		return;
+	}
+	
+	rx_byte b = { byte, lost + input_lost };
+	input_lost = 0;
+	input->write(&b, 1);
+	
+	/* Wake the thread once a packet's worth is waiting */
+	if(input->read_space() == SSDV_PKT_SIZE)
+		pthread_cond_signal(&rx_cond);
+}
+
+void *ssdv_rx::rx_loop(void *arg)
+{
+	SET_THREAD_ID(SSDV_TID);
+	
+	static_cast<ssdv_rx *>(arg)->rx_process();
+	
+	return NULL;
+}
+
+void ssdv_rx::rx_process()
+{
+	rx_byte in[256];
+	struct timespec now;
+	
+	guard_lock lock(&rx_mutex);
+	for(;;)
+	{
+		/* Wait for more bytes, or for a held back update to fall due.
+		 * put_byte() doesn't lock when it signals, and only does so for
+		 * a full packet, so never sleep for long */
+		while(!rx_quit && input->read_space() == 0)
+		{
+			if(update_dirty)
+			{
+				clock_gettime(CLOCK_REALTIME, &now);
+				if(!(update_due > now)) break;
+			}
+			pthread_cond_timedwait_rel(&rx_cond, &rx_mutex, 0.1);
+		}
+		if(rx_quit) break;
+		
+		size_t n = input->read(in, sizeof(in) / sizeof(*in));
+		
+		pthread_mutex_unlock(&rx_mutex);
+		for(size_t i = 0; i < n; i++)
+			process_byte(in[i].byte, in[i].lost);
+		
+		if(update_dirty)
+		{
+			clock_gettime(CLOCK_REALTIME, &now);
+			if(!(update_due > now)) update_image();
+		}
+		pthread_mutex_lock(&rx_mutex);
+	}
 }
 
 void ssdv_rx::feed_buffer(uint8_t byte, uint8_t erasure)
@@ -266,123 +421,237 @@ void ssdv_rx::clear_buffer()
 	bl = 0;
 }
 
-static void *upload_packet_thread(void *arg)
+/* Starts the decoder again from the first packet */
+void ssdv_rx::reset_decoder()
 {
-	ssdv_post_data_t *t = (ssdv_post_data_t *) arg;
-	struct curl_httppost* post = t->post;
-	CURL *curl = t->curl;
-	CURLcode r;
+	if(dec_ok) free(dec.out);
+	dec_ok = (ssdv_dec_init(&dec) == SSDV_OK);
+	dec_next = 0;
+}
+
+/* Feeds the stored packets from dec_next to last to the decoder, skipping
+ * the ones that have not been received */
+void ssdv_rx::feed_decoder(int last)
+{
+	if(!dec_ok) return;
 	
-	r = curl_easy_perform(curl);
-	if(r == 0)
-	{
-		fprintf(stderr, "SSDV: packet uploaded!\n");
-	}
-	else
+	for(; dec_next <= last; dec_next++)
 	{
-		fprintf(stderr, "CURL upload failed! \"%s\"\n", curl_easy_strerror(r));
+		uint8_t *p = packets + (dec_next * SSDV_PKT_SIZE);
+		if(p[0] != 0x55) continue;
+		ssdv_dec_feed(&dec, p);
 	}
+}
+
+/* Notes that the image may have changed from MCU mcu_id onwards */
+void ssdv_rx::mark_dirty(int mcu_id)
+{
+	int mcu_width = (image_mcu_mode == 0 || image_mcu_mode == 2 ? 16 : 8);
+	int mcu_height = (image_mcu_mode == 0 || image_mcu_mode == 1 ? 16 : 8);
 	
-	curl_easy_cleanup(curl);
-	curl_formfree(post);
-	
-	free(t);
+	/* Start a row of MCUs early, as the chroma upsampling blends
+	 * neighbouring rows */
+	int row = (mcu_id / (image_width / mcu_width) - 1) * mcu_height;
+	if(row < 0) row = 0;
 	
-	pthread_exit(0);
+	if(dirty_row < 0 || row < dirty_row) dirty_row = row;
 }
 
-/* TODO: HABITAT-LATER upload using habitat */
-void ssdv_rx::upload_packet(int fixes)
+/* Finishes a copy of the decoder's JPEG, saves and renders it, and hands
+ * the rows that changed to the GUI thread */
+void ssdv_rx::update_image()
 {
-	ssdv_post_data_t *t;
-	pthread_attr_t attr;
-	pthread_t thread;
-	const char *callsign;
-	char *packet;
-	char data[10];
-	struct curl_httppost* post = NULL;
-	struct curl_httppost* last = NULL;
-	CURL *curl;
-	
-	/* Don't upload if no URL is present */
-	if(progdefaults.ssdv_packet_url.length() <= 0) return;
-	
-	/* Get the callsign, or "UNKNOWN" if none is set */
-	callsign = (progdefaults.myCall.empty() ? "UNKNOWN" : progdefaults.myCall.c_str());
-	curl_formadd(&post, &last, CURLFORM_COPYNAME, "callsign",
-		CURLFORM_COPYCONTENTS, callsign, CURLFORM_END);
-	
-	/* The encoding used on the packet */
-	curl_formadd(&post, &last, CURLFORM_COPYNAME, "encoding",
-		CURLFORM_COPYCONTENTS, "hex", CURLFORM_END);
-	
-	/* Include the number of bytes corrected by the FEC */
-	snprintf(data, 10, "%i", fixes);
-	curl_formadd(&post, &last, CURLFORM_COPYNAME, "fixes",
-		CURLFORM_COPYCONTENTS, data, CURLFORM_END);
-	
-	/* URL-encode the packet */
-	packet = (char *) malloc((SSDV_PKT_SIZE * 2) + 1);
-	if(!packet)
+	ssdv_t fin;
+	uint8_t *jpeg;
+	size_t length;
+	
+	clock_gettime(CLOCK_REALTIME, &update_due);
+	update_due = update_due + UPDATE_INTERVAL;
+	update_dirty = false;
+	if(!dec_ok || !ssdv_dec_copy(&fin, &dec)) return;
+	
+	ssdv_dec_get_jpeg(&fin, &jpeg, &length);
+	
+	/* Save the image to disk */
+	save_image(jpeg, length);
+	
+	/* Render the image */
+	render_image(jpeg, length);
+	
+	free(jpeg);
+	
+	int row = dirty_row;
+	dirty_row = -1;
+	if(row < 0) return;
+	
+	guard_lock lock(&rx_mutex);
+	
+	if(frame_width != image_width || frame_height != image_height)
 	{
-		fprintf(stderr, "ssdv_rx::upload_packet(): failed to allocate memory for packet\n");
-		curl_formfree(post);
-		return;
+		delete [] frame;
+		frame = new uint8_t[rgb_len];
+		frame_width = image_width;
+		frame_height = image_height;
+		row = 0;
 	}
 	
-	for(int i = 0; i < SSDV_PKT_SIZE; i++)
-		snprintf(packet + (i * 2), 3, "%02X", buffer[bc + i]);
+	size_t stride = image_width * 3;
+	memcpy(frame + row * stride, rgb + row * stride, (image_height - row) * stride);
+	if(frame_row < 0 || row < frame_row) frame_row = row;
 	
-	/* Add a copy of the packet */
-	curl_formadd(&post, &last, CURLFORM_COPYNAME, "packet",
-		CURLFORM_COPYCONTENTS, packet, CURLFORM_END);
-	
-	free(packet);
+	notify();
+}
+
+/* Updates the image now if it has not been updated in the last
+ * UPDATE_INTERVAL seconds, or else once they have passed */
+void ssdv_rx::request_update(bool now)
+{
+	struct timespec t;
 	
-	/* Initialise libcurl */
-	curl = curl_easy_init();
-	if(!curl)
+	clock_gettime(CLOCK_REALTIME, &t);
+	if(!now && update_due > t)
 	{
-		fprintf(stderr, "ssdv_rx::upload_packet(): curl_easy_init() failed\n");
-		curl_formfree(post);
+		update_dirty = true;
 		return;
 	}
 	
-	curl_easy_setopt(curl, CURLOPT_URL, progdefaults.ssdv_packet_url.c_str());
-	curl_easy_setopt(curl, CURLOPT_HTTPPOST, post); 
+	update_image();
+}
+
+/* Hands the details of the current image, and a message for the receive
+ * pane, to the GUI thread */
+void ssdv_rx::publish(const char *msg)
+{
+	guard_lock lock(&rx_mutex);
+	
+	status.callsign  = image_callsign;
+	status.image_id  = image_id;
+	status.width     = image_width;
+	status.height    = image_height;
+	status.received  = image_received_packets;
+	status.lost      = image_lost_packets;
+	status.errors    = image_errors;
+	status.mcu_id    = (dec_ok ? dec.mcu_id : 0);
+	status.mcu_count = (dec_ok ? dec.mcu_count : 0);
+	status_ready = true;
+	
+	messages.push_back(msg);
+	
+	notify();
+}
+
+/* Asks the GUI thread for a take_update(), unless one is already queued.
+ * Called with rx_mutex held. */
+void ssdv_rx::notify()
+{
+	if(rx_pending) return;
+	rx_pending = true;
+	REQ(&ssdv_rx::take_update, this);
+}
+
+void ssdv_rx::take_update()
+{
+	ENSURE_THREAD(FLMAIN_TID);
+	
+	std::vector<std::string> msgs;
+	rx_status s;
+	bool show, redraw_image = false, resized = false;
+	
+	pthread_mutex_lock(&rx_mutex);
+	rx_pending = false;
+	msgs.swap(messages);
+	s = status;
+	show = status_ready;
+	status_ready = false;
+	if(frame_row >= 0)
+	{
+		if(frame_width != image_shown_width || frame_height != image_shown_height)
+		{
+			delete [] image;
+			image = new uint8_t[frame_width * frame_height * 3];
+			image_shown_width = frame_width;
+			image_shown_height = frame_height;
+			frame_row = 0;
+			resized = true;
+		}
+		
+		size_t stride = frame_width * 3;
+		memcpy(image + frame_row * stride, frame + frame_row * stride,
+			(frame_height - frame_row) * stride);
+		frame_row = -1;
+		redraw_image = true;
+	}
+	pthread_mutex_unlock(&rx_mutex);
 	
-	/* Begin the thread to do the post */
-	t = (ssdv_post_data_t *) malloc(sizeof(ssdv_post_data_t));
-	if(!t)
+	if(resized)
 	{
-		fprintf(stderr, "ssdv_rx::upload_packet(): failed to allocate memory for thread data\n");
-		curl_easy_cleanup(curl);
-		curl_formfree(post);
-		return;
+		/* Create the Fl_RGB_Image object */
+		if(flrgb) delete flrgb;
+		flrgb = new Fl_RGB_Image(image, image_shown_width, image_shown_height, 3);
+		box->size(image_shown_width, image_shown_height);
+		box->image(flrgb);
+		
+		/* Snap the window to the new image size */
+		size(
+			CLAMP(image_shown_width, WIN_MIN_WIDTH, WIN_MAX_WIDTH),
+			CLAMP(image_shown_height + UI_HEIGHT, WIN_MIN_HEIGHT, WIN_MAX_HEIGHT)
+		);
 	}
 	
-	t->curl = curl;
-	t->post = post;
+	if(redraw_image)
+	{
+		flrgb->uncache();
+		box->redraw();
+	}
 	
-	pthread_attr_init(&attr);
-	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	/* Display the messages on the fldigi interface */
+	if(!msgs.empty())
+	{
+		put_status("SSDV: Decoded image packet!", 10);
+		
+		if(bHAB)
+		{
+			habString->value(msgs.back().c_str());
+			habString->color(FL_GREEN);
+			habString->damage(FL_DAMAGE_ALL);
+		}
+	}
 	
-	if(pthread_create(&thread, &attr, upload_packet_thread, (void *) t) != 0)
+	for(size_t i = 0; i < msgs.size(); i++)
 	{
-		fprintf(stderr, "ssdv_rx::upload_packet(): failed to start post thread\n");
-		curl_easy_cleanup(curl);
-		curl_formfree(post);
-		free(t);
+		ReceiveText->addstr("\n");
+		ReceiveText->addstr(msgs[i].c_str(), FTextBase::QSY);
+		ReceiveText->addstr("\n");
 	}
 	
-	pthread_attr_destroy(&attr);
+	if(!show) return;
+	
+	/* Update values on display */
+	char t[16];
+	
+	ssdv_decode_callsign(t, s.callsign);
+	flcallsign->copy_label(t);
+	
+	snprintf(t, 16, "%d", s.received);
+	flreceived->copy_label(t);
+	
+	snprintf(t, 16, "0x%02X", s.image_id);
+	flimageid->copy_label(t);
 	
-	/* All done! */
+	snprintf(t, 16, "%d", s.lost);
+	flmissing->copy_label(t);
 	
-	return;
+	snprintf(t, 16, "%d byte%s", s.errors, (s.errors == 1 ? "" : "s"));
+	flfixes->copy_label(t);
+	
+	snprintf(t, 16, "%ix%i", s.width, s.height);
+	flsize->copy_label(t);
+	
+	flprogress->maximum(s.mcu_count);
+	flprogress->value(s.mcu_id);
 }
 
-void ssdv_rx::put_byte(uint8_t byte, int lost)
+void ssdv_rx::process_byte(uint8_t byte, int lost)
 {
 	int i;
 	
@@ -401,13 +670,16 @@ void ssdv_rx::put_byte(uint8_t byte, int lost)
 	
 	/* Test if this is a packet and is valid */
 	uint8_t *b = &buffer[bc];
+	
+	/* Only try the FEC where a packet could start */
+	if(!ssdv_dec_is_candidate(b, &erasures[bc])) return;
 	if(ssdv_dec_is_packet(b, &i, &erasures[bc]) != 0) return;
 	
 	/* Make a note of the number of errors */
 	image_errors += i;
 	
-	/* Packet received.. upload to server */
-	if (dl_fldigi::online()) upload_packet(i);
+	/* Packet received.. queue it for the server */
+	dl_fldigi::ssdv_upload::packet(b, i);
 	
 	/* Read the header */
 	ssdv_dec_header(&pkt_info, b);
@@ -419,6 +691,9 @@ void ssdv_rx::put_byte(uint8_t byte, int lost)
 	   pkt_info.height != image_height ||
 	   pkt_info.mcu_mode != image_mcu_mode)
 	{
+		/* Finish the previous image */
+		if(update_dirty) update_image();
+		
 		/* Prepare the new image */
 		image_timestamp      = time(NULL);
 		image_callsign       = pkt_info.callsign;
@@ -426,30 +701,22 @@ void ssdv_rx::put_byte(uint8_t byte, int lost)
 		image_width          = pkt_info.width;
 		image_height         = pkt_info.height;
 		image_mcu_mode       = pkt_info.mcu_mode;
+		image_received_packets = 0;
 		image_lost_packets   = 0;
 		image_errors         = i;
 		
-		/* Initialise and clear the image buffer */
-		if(image) delete image;
-		image_len = image_width * image_height * 3;
-		image = new unsigned char[image_len];
-		
-		/* Create the Fl_RGB_Image object */
-		if(flrgb) delete flrgb;
-		flrgb = new Fl_RGB_Image(image, image_width, image_height, 3);
-		box->size(image_width, image_height);
-		box->image(flrgb);
-		
-		/* Snap the window to the new image size */
-		size(
-			CLAMP(image_width, WIN_MIN_WIDTH, WIN_MAX_WIDTH),
-			CLAMP(image_height + UI_HEIGHT, WIN_MIN_HEIGHT, WIN_MAX_HEIGHT)
-		);
+		/* Initialise the image buffer, all of which is new */
+		delete [] rgb;
+		rgb_len = image_width * image_height * 3;
+		rgb = new uint8_t[rgb_len];
+		dirty_row = 0;
 		
 		/* Clear the packet buffer */
 		if(packets != NULL) free(packets);
 		packets = NULL;
 		packets_len = 0;
+		
+		reset_decoder();
 	}
 	
 	/* Realloc packet buffer for new packet */
@@ -473,14 +740,15 @@ void ssdv_rx::put_byte(uint8_t byte, int lost)
 	}
 	
 	/* Copy it into place */
-	memcpy(packets + (pkt_info.packet_id * SSDV_PKT_SIZE), b, SSDV_PKT_SIZE);
+	uint8_t *p = packets + (pkt_info.packet_id * SSDV_PKT_SIZE);
+	bool duplicate = (p[0] == 0x55);
+	memcpy(p, b, SSDV_PKT_SIZE);
+	if(!duplicate) image_received_packets++;
+	image_lost_packets = packets_len - image_received_packets;
 	
 	/* Done with the receive buffer */
 	clear_buffer();	
 	
-	/* Display a message on the fldigi interface */
-	put_status("SSDV: Decoded image packet!", 10);
-	
 	char msg[200], callsign[10];
 	snprintf(msg, 200, "Decoded image packet. Callsign: %s, Image ID: %02X, Resolution: %dx%d, Packet ID: %d",
 		ssdv_decode_callsign(callsign, pkt_info.callsign),
@@ -489,74 +757,24 @@ void ssdv_rx::put_byte(uint8_t byte, int lost)
 		pkt_info.height,
 		pkt_info.packet_id);
 	
-	if(bHAB)
+	/* Packets that arrive in order are fed to the decoder as they come.
+	 * One that fills an earlier gap means starting again. */
+	if(pkt_info.packet_id >= dec_next)
 	{
-		habString->value(msg);
-		habString->color(FL_GREEN);
-		habString->damage(FL_DAMAGE_ALL);
+		if(dec_ok) mark_dirty(dec.mcu_id);
+		feed_decoder(pkt_info.packet_id);
 	}
-	
-	ReceiveText->addstr("\n");
-	ReceiveText->addstr(msg, FTextBase::QSY);
-	ReceiveText->addstr("\n");
-	
-	/* Initialise the decoder */
-	ssdv_t dec;
-	ssdv_dec_init(&dec);
-	
-	image_received_packets = 0;
-	image_lost_packets = 0;
-	for(i = 0; i < packets_len; i++)
+	else if(!duplicate)
 	{
-		int r;
-		uint8_t *p = packets + (i * SSDV_PKT_SIZE);
-		if(p[0] != 0x55) { image_lost_packets++; continue; }
-		image_received_packets++;
-		r = ssdv_dec_feed(&dec, p);
+		mark_dirty(0);
+		reset_decoder();
+		feed_decoder(packets_len - 1);
 	}
 	
-	/* Store the last decoded MCU, for the progress bar */
-	int mcu_id = dec.mcu_id;
-	
-	/* Get the final image */
-	uint8_t *jpeg;
-	size_t length;
-	
-	i = ssdv_dec_get_jpeg(&dec, &jpeg, &length);
-	
-	/* Save the image to disk */
-	save_image(jpeg, length);
-	
-	/* Render the image to screen */
-	render_image(jpeg, length);
-	flrgb->uncache();
-	box->redraw();
-	
-	free(jpeg);
-	
-	/* Update values on display */
-	char s[16];
-	
-	ssdv_decode_callsign(s, image_callsign);
-	flcallsign->copy_label(s);
-	
-	snprintf(s, 16, "%d", image_received_packets);
-	flreceived->copy_label(s);
-	
-	snprintf(s, 16, "0x%02X", pkt_info.image_id);
-	flimageid->copy_label(s);
-	
-	snprintf(s, 16, "%d", image_lost_packets);
-	flmissing->copy_label(s);
-	
-	snprintf(s, 16, "%d byte%s", image_errors, (image_errors == 1 ? "" : "s"));
-	flfixes->copy_label(s);
-	
-	snprintf(s, 16, "%ix%i", image_width, image_height);
-	flsize->copy_label(s);
+	publish(msg);
 	
-	flprogress->maximum(dec.mcu_count);
-	flprogress->value(mcu_id);
+	/* Save and render the image, at once if it is complete */
+	request_update(dec_ok && dec.mcu_count && dec.mcu_id >= dec.mcu_count);
 }
 
 void ssdv_rx::save_image(uint8_t *jpeg, size_t length)
@@ -644,7 +862,9 @@ void ssdv_rx::render_image(uint8_t *jpeg, size_t length)
 	jpeg_start_decompress(&cinfo);
 	
 	/* Fail if the image doesn't match our requirements */
-	if(cinfo.output_components != 3)
+	if(cinfo.output_components != 3 ||
+	   (int) cinfo.output_width != image_width ||
+	   (int) cinfo.output_height != image_height)
 	{
 		jpeg_finish_decompress(&cinfo);
 		jpeg_destroy_decompress(&cinfo);
@@ -655,7 +875,7 @@ void ssdv_rx::render_image(uint8_t *jpeg, size_t length)
 	
 	while(cinfo.output_scanline < cinfo.output_height)
 	{
-		uint8_t *b = &image[cinfo.output_scanline * row_stride];
+		uint8_t *b = &rgb[cinfo.output_scanline * row_stride];
 		jpeg_read_scanlines(&cinfo, &b, 1);
 	}
 	
@@ -301,6 +301,13 @@ thor::thor(trx_mode md) : hilbert(0), fft(0), filter_reset(false)
 
 	prev1symbol = prev2symbol = 0;
 
+	lastc = lastmag = nowmag = prev1rawdoppler = 0;
+	lastdoppler = nowdoppler = 0.0;
+	for (int i = 0; i < MAXPATHS; i++)
+		lastCWI[i] = nextCWI[i] = false;
+	preamblecheck = twocount = 0;
+	neg16seen = false;
+
 	if ( mode == MODE_THOR100 || mode == MODE_THOR50x1 || mode == MODE_THOR50x2 || mode == MODE_THOR25x4 ) {
 		Enc = new encoder (THOR_K15, K15_POLY1, K15_POLY2);
 		Dec = new viterbi (THOR_K15, K15_POLY1, K15_POLY2);
@@ -464,8 +471,6 @@ void thor::softdecodesymbol()
 {
 	unsigned char one, zero;
 	int c, nextmag=127, rawdoppler=0;
-	static int lastc=0, lastmag=0, nowmag=0, prev1rawdoppler=0;
-	static double lastdoppler=0, nowdoppler=0;
 	unsigned char lastsymbols[4];
 	bool outofrange=false;
 
@@ -589,7 +594,7 @@ int thor::harddecode()
 	double x, max = 0.0;
 	int symbol = 0;
 	double avg = 0.0;
-	static bool cwi[MAXPATHS]; //[paths * numbins];
+	bool cwi[MAXPATHS]; //[paths * numbins];
 	double cwmag;
 
 	for (int i = 0; i < MAXPATHS; i++) cwi[i] = false;
@@ -632,8 +637,6 @@ LOG_DEBUG("cwi detected in bin %d", i);
 
 int thor::softdecode()
 {
-	static bool lastCWI[MAXPATHS] = {false};
-	static bool nextCWI[MAXPATHS] = {false};
 	static const int SoftBailout=6; // Max number of attempts to get a valid symbol
 
 	double x, max = 0.0, avg = 0.0;
@@ -695,7 +698,7 @@ int thor::softdecode()
 
 	} while ( nextCWI[symbol] && soft_symbol_trycount < SoftBailout ); // Run while the detected symbol has been identified as CWI (alt: bailout after 6 trys)
 
-	// Copy the newly-detected CWI mask to the static lastCWI array for use on next function call
+	// Copy the newly-detected CWI mask to lastCWI for use on next function call
 	for (int i = lowest_tone-1; i < highest_tone+1; i++) lastCWI[i] = nextCWI[i];
 
 	staticburst = (max / avg < 1.2);
@@ -707,9 +710,6 @@ int thor::softdecode()
 
 bool thor::preambledetect(int c)
 {
-	static int preamblecheck=0, twocount=0;
-	static bool neg16seen=false;
-
 	if (twocount > 14 ) twocount = 0;
 
 	if (-16 == c && twocount > 2 ) neg16seen = true;
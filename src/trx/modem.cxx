@@ -39,6 +39,9 @@
 
 #include "status.h"
 #include "debug.h"
+#if DECODER_MODE
+#  include "benchmark.h"
+#endif
 
 using namespace std;
 
@@ -177,7 +180,6 @@ modem *wwv_modem = 0;
 modem *anal_modem = 0;
 modem *ssb_modem = 0;
 
-double modem::frequency = 1000;
 double modem::tx_frequency = 1000;
 bool   modem::freqlock = false;
 
@@ -185,17 +187,27 @@ modem::modem()
 {
 	scptr = 0;
 
-	if( !progdefaults.retain_freq_lock ) {
+	// extra modems are created on their own receive thread, and must leave
+	// the active modem's transmit frequency alone
+	extra = trx_extra_modem() >= 0;
+
+	if (extra)
+		frequency = 1000;
+	else if( !progdefaults.retain_freq_lock ) {
 		freqlock = false;
 		frequency = tx_frequency = 1000;
 	}
+	else
+		frequency = active_modem ? active_modem->get_freq() : 1000;
 
 	sigsearch = 0;
+#if !DECODER_MODE
 	if (wf) {
 		bool wfrev = wf->Reverse();
 		bool wfsb = wf->USB();
 		reverse = wfrev ^ !wfsb;
 	} else
+#endif
 		reverse = false;
 	historyON = false;
 	cap = CAP_RX | CAP_TX;
@@ -210,25 +222,33 @@ modem::modem()
 void modem::init()
 {
 	stopflag = false;
+#if !DECODER_MODE
 	if (!wf) return;
 
 	bool wfrev = wf->Reverse();
 	bool wfsb = wf->USB();
 	reverse = wfrev ^ !wfsb;
+#endif
 
 	if (progdefaults.StartAtSweetSpot) {
 		set_freq(progdefaults.PSKsweetspot);
 	} else if (progStatus.carrier != 0) {
 		set_freq(progStatus.carrier);
-#if !BENCHMARK_MODE
+#if !DECODER_MODE
 		progStatus.carrier = 0;
-#endif
 	} else
 		set_freq(wf->Carrier());
+#else
+	}
+#endif
 }
 
 double modem::track_freq(double freq)
 {
+#if DECODER_MODE
+	// there is no rig to retune
+	return freq;
+#else
 	if(track_freq_lock) return(freq);
 	
 	if(freq >= progdefaults.track_freq_min &&
@@ -246,17 +266,20 @@ double modem::track_freq(double freq)
 	qsy(rf);
 	
 	return(cf);
+#endif
 }
 
 void modem::set_freq(double freq)
 {
-	if(progdefaults.track_freq)
+	if(progdefaults.track_freq && !extra)
 		freq = track_freq(freq);
 	
 	frequency = CLAMP(
 		freq,
 		progdefaults.LowFreqCutoff + bandwidth / 2,
 		progdefaults.HighFreqCutoff - bandwidth / 2);
+	if (extra)
+		return;
 	if (freqlock == false)
 		tx_frequency = frequency;
 	REQ(put_freq, frequency);
@@ -288,14 +311,17 @@ double modem::get_txfreq_woffset(void) const
 void modem::set_bandwidth(double bw)
 {
 	bandwidth = bw;
-	put_Bandwidth((int)bandwidth);
+	if (!extra)
+		put_Bandwidth((int)bandwidth);
 }
 
 void modem::set_reverse(bool on)
 {
+#if !DECODER_MODE
 	if (likely(wf))
 		reverse = on ^ (!wf->USB());
 	else
+#endif
 		reverse = false;
 }
 
@@ -307,7 +333,8 @@ void modem::set_metric(double m)
 void modem::display_metric(double m)
 {
 	set_metric(m);
-	::global_display_metric(m);
+	if (!extra)
+		::global_display_metric(m);
 }
 
 bool modem::get_cwTrack()
@@ -439,14 +466,21 @@ void modem::add_noise(double *buffer, int len)
 
 void modem::s2nreport(void)
 {
+#if !DECODER_MODE
 	double s2n_avg = s2n_sum / s2n_ncount;
 	double s2n_stddev = sqrt((s2n_sum2 / s2n_ncount) - (s2n_avg * s2n_avg));
 
 	pskmail_notify_s2n(s2n_ncount, s2n_avg, s2n_stddev);
+#endif
 }
 
 void modem::ModulateXmtr(double *buffer, int len)
 {
+#if DECODER_MODE
+	// there is no sound card; only the benchmark transmits
+	benchmark_modulated(buffer, len);
+	return;
+#endif
 	if (unlikely(!scard)) return;
 
 	if (progdefaults.PTTrightchannel) {
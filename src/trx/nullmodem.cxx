@@ -53,21 +53,28 @@ void  NULLMODEM::tx_init(SoundBase *sc)
 
 void  NULLMODEM::rx_init()
 {
+#if !DECODER_MODE
 	if (fl_digi_main)
 		put_MODEstatus(mode);
+#endif
 }
 
 void NULLMODEM::init()
 {
 	modem::init();
 	rx_init();
+#if !DECODER_MODE
 	if (digiscope)
 		digiscope->mode(Digiscope::SCOPE);
+#endif
 }
 
 void NULLMODEM::restart()
 {
-	if (wf) set_bandwidth(null_bw);
+#if !DECODER_MODE
+	if (wf)
+#endif
+		set_bandwidth(null_bw);
 }
 
 
@@ -88,7 +95,11 @@ int NULLMODEM::rx_process(const double *buf, int len)
 int NULLMODEM::tx_process()
 {
 	MilliSleep(10);
+#if DECODER_MODE
+	return 0;
+#else
 	if (!fl_digi_main) return 0;
+#endif
 
 	if ( get_tx_char() == GET_TX_CHAR_ETX || stopflag) {
 		stopflag = false;
@@ -46,7 +46,8 @@
 #include "nullmodem.h"
 #include "macros.h"
 
-#if BENCHMARK_MODE
+#if DECODER_MODE
+#  include "decoder.h"
 #  include "benchmark.h"
 #endif
 
@@ -60,6 +61,7 @@ void	trx_receive_loop();
 void	trx_transmit_loop();
 void	trx_tune_loop();
 static void trx_signal_state(void);
+static void trx_sem_init(void);
 
 //#define DEBUG
 
@@ -75,17 +77,20 @@ cDTMF		*dtmf = 0;
 SoundBase 	*scard;
 static int	_trx_tune;
 
-// Ringbuffer for the audio "history". A pointer into this buffer
-// is also passed to the waterfall signal drawing routines.
-#define NUMMEMBUFS 1024
-static ringbuffer<double> trxrb(ceil2(NUMMEMBUFS * SCBLOCKSIZE));
-static float fbuf[SCBLOCKSIZE];
 bool    bHistory = false;
 bool    bHighSpeed = false;
-static  double hsbuff[SCBLOCKSIZE];
 
 static bool trxrunning = false;
 
+#if !DECODER_MODE
+// Ringbuffer for the audio "history". A pointer into this buffer
+// is also passed to the waterfall signal drawing routines.  It is
+// mirrored where possible, so that the readers see contiguous blocks.
+#define NUMMEMBUFS 1024
+static ringbuffer<double> trxrb(ceil2(NUMMEMBUFS * SCBLOCKSIZE), true);
+static float fbuf[SCBLOCKSIZE];
+static  double hsbuff[SCBLOCKSIZE];
+
 #include "tune.cxx"
 
 //=============================================================================
@@ -117,7 +122,7 @@ static void trx_xmit_wfall_draw(int samplerate)
 #undef block_read_
 
 	// read non-contiguous data into tmp buffer so that we can
-	// still draw it one block at a time
+	// still draw it one block at a time; only if trxrb is not mirrored
 	if (unlikely(trxrb.read_space() >= WFBLOCKSIZE)) {
 		double buf[WFBLOCKSIZE];
 		do {
@@ -189,6 +194,327 @@ void trx_xmit_wfall_queue(int samplerate, const double* buf, size_t len)
 
 //=============================================================================
 
+// The receive pipeline.  The trx thread reads the sound card and writes to
+// trxrb; the modem, RSID and DTMF decoders each run on their own thread and
+// read trxrb through their own cursor, so that a slow stage only delays itself.
+// A stage that falls more than half the ringbuffer behind skips ahead.
+// The last NUM_EXTRA_MODEMS stages run the extra modems, which are created
+// and deleted by their own stage thread.
+
+struct rx_stage {
+	const char* name;
+	int tid;
+	void (*process)(struct rx_stage* s, const double* buf, size_t len);
+	pthread_t thread;
+	size_t pos; // next sample to read, in the same units as rx_pos
+	size_t at; // position of the samples passed to process()
+	bool busy;
+
+	// extra modems only
+	bool extra;
+	modem* m;
+	trx_mode new_mode; // to be created by the stage thread, or NUM_MODES
+	int new_freq;
+	modem_settings new_settings;
+	bool remove;
+};
+
+static void rx_modem_process(rx_stage* s, const double* buf, size_t len);
+static void rx_rsid_process(rx_stage* s, const double* buf, size_t len);
+static void rx_dtmf_process(rx_stage* s, const double* buf, size_t len);
+static void rx_extra_process(rx_stage* s, const double* buf, size_t len);
+
+#define NUM_RX_STAGES (3 + NUM_EXTRA_MODEMS)
+static rx_stage rx_stages[NUM_RX_STAGES] = {
+	{ "modem", RXMODEM_TID, rx_modem_process },
+	{ "rsid", RSID_TID, rx_rsid_process },
+	{ "dtmf", DTMF_TID, rx_dtmf_process },
+};
+#define extra_stage(i_) rx_stages[NUM_RX_STAGES - NUM_EXTRA_MODEMS + (i_)]
+
+static pthread_mutex_t rx_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t rx_data_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t rx_idle_cond = PTHREAD_COND_INITIALIZER;
+static size_t rx_pos; // samples written, congruent to the trxrb write index
+static bool rx_paused = true, rx_quit = false, rx_running = false;
+static bool rx_flush_pending = false; // set by trx_rx_flush(), under rx_mutex
+
+static void rx_modem_process(rx_stage*, const double* buf, size_t len)
+{
+	bool flush;
+	{
+		guard_lock lock(&rx_mutex);
+		flush = rx_flush_pending;
+		rx_flush_pending = false;
+	}
+	if (unlikely(flush))
+		active_modem->rx_flush();
+	batch_rx_chars();
+	active_modem->rx_process(buf, len);
+	flush_rx_chars();
+}
+
+// Detections are queued for the trx thread, which applies them
+static void rx_rsid_process(rx_stage* s, const double* buf, size_t len)
+{
+	if (!progdefaults.rsid)
+		return;
+	float f[SCBLOCKSIZE];
+	for (size_t i = 0; i < len; i++)
+		f[i] = buf[i];
+	ReedSolomon->receive(f, len, s->at);
+}
+
+static void rx_dtmf_process(rx_stage*, const double* buf, size_t len)
+{
+	if (!progdefaults.DTMFdecode)
+		return;
+	float f[SCBLOCKSIZE];
+	for (size_t i = 0; i < len; i++)
+		f[i] = buf[i];
+	dtmf->receive(f, len);
+}
+
+static void rx_extra_process(rx_stage* s, const double* buf, size_t len)
+{
+	// the sound card runs at the active modem's rate
+	if (s->m->get_samplerate() == active_modem->get_samplerate()) {
+		batch_rx_chars();
+		s->m->rx_process(buf, len);
+		flush_rx_chars();
+	}
+}
+
+// Creates or deletes the stage's extra modem, with rx_mutex unlocked
+static void rx_extra_update(rx_stage* s)
+{
+	if (s->new_mode != NUM_MODES) {
+		trx_mode mode = s->new_mode;
+		int freq = s->new_freq;
+		modem_settings settings = s->new_settings;
+		pthread_mutex_unlock(&rx_mutex);
+
+		modem* m = create_modem(mode);
+		m->set_extra(true);
+		m->set_settings(settings);
+		m->restart();
+		m->set_freq(freq);
+		m->rx_init();
+		LOG_INFO("extra modem %d: %s @ %d Hz", s->tid - EXTRA_MODEM_TID,
+			 mode_info[mode].sname, m->get_freq());
+
+		pthread_mutex_lock(&rx_mutex);
+		s->m = m;
+		s->new_mode = NUM_MODES;
+		s->pos = rx_pos;
+	}
+	else if (s->remove) {
+		modem* m = s->m;
+		s->m = 0;
+		s->remove = false;
+		pthread_mutex_unlock(&rx_mutex);
+		delete m;
+		pthread_mutex_lock(&rx_mutex);
+	}
+}
+
+static void* rx_stage_loop(void* arg)
+{
+	rx_stage* s = static_cast<rx_stage*>(arg);
+	SET_THREAD_ID(s->tid);
+
+	ringbuffer<double>::vector_type v[2];
+	guard_lock lock(&rx_mutex);
+	for (;;) {
+		while (!rx_quit && !(s->extra && (s->new_mode != NUM_MODES || s->remove)) &&
+		       (rx_paused || s->pos == rx_pos || (s->extra && !s->m)))
+			pthread_cond_wait(&rx_data_cond, &rx_mutex);
+		if (rx_quit)
+			break;
+		if (s->extra && (s->new_mode != NUM_MODES || s->remove)) {
+			rx_extra_update(s);
+			continue;
+		}
+
+		if (unlikely(trxrb.read_space_at(s->pos) > trxrb.length() / 2)) {
+			LOG_WARN("%s: skipping %" PRIuSZ " samples", s->name,
+				 rx_pos - s->pos - SCBLOCKSIZE);
+			s->pos = rx_pos - SCBLOCKSIZE;
+		}
+		size_t n = MIN(rx_pos - s->pos, (size_t)SCBLOCKSIZE);
+		trxrb.get_rv_at(v, s->pos, n);
+		s->busy = true;
+
+		pthread_mutex_unlock(&rx_mutex);
+		s->at = s->pos;
+		s->process(s, v[0].buf, v[0].len);
+		if (v[1].len) {
+			s->at += v[0].len;
+			s->process(s, v[1].buf, v[1].len);
+		}
+		pthread_mutex_lock(&rx_mutex);
+
+		s->pos += n;
+		s->busy = false;
+		if (rx_paused)
+			pthread_cond_broadcast(&rx_idle_cond);
+	}
+
+	delete s->m;
+	s->m = 0;
+
+	return NULL;
+}
+
+static void rx_pipeline_start(void)
+{
+	rx_quit = false;
+	rx_paused = true;
+	for (size_t i = 0; i < NUM_EXTRA_MODEMS; i++) {
+		rx_stage& s = extra_stage(i);
+		s.name = "extra modem";
+		s.tid = EXTRA_MODEM_TID + i;
+		s.process = rx_extra_process;
+		s.extra = true;
+		s.m = 0;
+		s.new_mode = NUM_MODES;
+		s.remove = false;
+	}
+	for (size_t i = 0; i < NUM_RX_STAGES; i++) {
+		rx_stages[i].busy = false;
+		if (pthread_create(&rx_stages[i].thread, NULL, rx_stage_loop, &rx_stages[i]) != 0) {
+			LOG_PERROR("pthread_create");
+			exit(1);
+		}
+	}
+	rx_running = true;
+}
+
+static void rx_pipeline_stop(void)
+{
+	if (!rx_running)
+		return;
+	pthread_mutex_lock(&rx_mutex);
+	rx_quit = true;
+	pthread_cond_broadcast(&rx_data_cond);
+	pthread_mutex_unlock(&rx_mutex);
+	for (size_t i = 0; i < NUM_RX_STAGES; i++)
+		pthread_join(rx_stages[i].thread, NULL);
+	rx_running = false;
+}
+
+// Stops the stages from reading trxrb, and waits for them to finish the
+// block they are processing.  Any data they have not read are discarded.
+static void rx_pipeline_pause(void)
+{
+	ENSURE_THREAD(TRX_TID);
+
+	guard_lock lock(&rx_mutex);
+	rx_paused = true;
+	for (size_t i = 0; i < NUM_RX_STAGES; i++)
+		while (rx_stages[i].busy)
+			pthread_cond_wait(&rx_idle_cond, &rx_mutex);
+
+	if (rx_flush_pending) {
+		rx_flush_pending = false;
+		active_modem->rx_flush();
+	}
+}
+
+// Starts the stages at the current trxrb write position.  RSID detections
+// made before the pause are discarded.
+static void rx_pipeline_resume(void)
+{
+	ENSURE_THREAD(TRX_TID);
+
+	ReedSolomon->clear_pending();
+
+	guard_lock lock(&rx_mutex);
+	rx_pos = trxrb.write_index();
+	for (size_t i = 0; i < NUM_RX_STAGES; i++)
+		rx_stages[i].pos = rx_pos;
+	rx_paused = false;
+}
+
+// Called after writing `n' samples to trxrb
+static void rx_pipeline_write(size_t n)
+{
+	guard_lock lock(&rx_mutex);
+	rx_pos += n;
+	pthread_cond_broadcast(&rx_data_cond);
+}
+
+#endif // !DECODER_MODE
+
+// Extra modems take the receive settings that trx_add_modem was not given
+// from progdefaults once, when they are created, and are not restarted when
+// the configuration changes.
+// Only modes that read nothing else at run time but on/off options, and
+// that keep no state outside the modem, are allowed.  These are also the
+// only modes that dl-fldigi-decode, which has no widgets, can run.
+bool trx_extra_mode_ok(trx_mode mode)
+{
+	return mode == MODE_RTTY ||
+	       (mode >= MODE_PSK_FIRST && mode <= MODE_PSK_LAST) ||
+	       (mode >= MODE_DOMINOEX_FIRST && mode <= MODE_DOMINOEX_LAST) ||
+	       (mode >= MODE_THOR_FIRST && mode <= MODE_THOR_LAST);
+}
+
+#if !DECODER_MODE
+
+int trx_add_modem(trx_mode mode, int freq, const modem_settings& settings)
+{
+	guard_lock lock(&rx_mutex);
+	if (!rx_running || !trx_extra_mode_ok(mode))
+		return -1;
+
+	for (int i = 0; i < NUM_EXTRA_MODEMS; i++) {
+		rx_stage& s = extra_stage(i);
+		if (s.m || s.new_mode != NUM_MODES)
+			continue;
+		s.new_mode = mode;
+		s.new_freq = freq;
+		s.new_settings = settings;
+		s.remove = false;
+		pthread_cond_broadcast(&rx_data_cond);
+		return i;
+	}
+
+	return -1;
+}
+
+void trx_remove_modem(int i)
+{
+	guard_lock lock(&rx_mutex);
+	if (!rx_running || i < 0 || i >= NUM_EXTRA_MODEMS)
+		return;
+
+	extra_stage(i).remove = true;
+	pthread_cond_broadcast(&rx_data_cond);
+}
+
+modem* trx_rx_modem(void)
+{
+	// an extra modem is only replaced by its own thread
+	int i = trx_extra_modem();
+	return i < 0 ? active_modem : extra_stage(i).m;
+}
+
+// Flushes the active modem's receive buffers before the next block is
+// processed.  Used by the RSID decoder, which does not run on the modem thread.
+void trx_rx_flush(void)
+{
+	if (!rx_running || (GET_THREAD_ID() == TRX_TID && rx_paused)) {
+		active_modem->rx_flush();
+		return;
+	}
+
+	guard_lock lock(&rx_mutex);
+	rx_flush_pending = true;
+}
+
+//=============================================================================
+
 void trx_trx_receive_loop()
 {
 	size_t  numread;
@@ -200,12 +526,6 @@ void trx_trx_receive_loop()
 		return;
 	}
 
-#if BENCHMARK_MODE
-	do_benchmark();
-	trx_state = STATE_ENDED;
-	return;
-#endif
-
 	if (unlikely(!scard)) {
 		MilliSleep(10);
 		return;
@@ -232,6 +552,9 @@ void trx_trx_receive_loop()
 	ringbuffer<double>::vector_type rbvec[2];
 	rbvec[0].buf = rbvec[1].buf = 0;
 
+	if (!bHighSpeed)
+		rx_pipeline_resume();
+
 	while (1) {
 		try {
 			numread = 0;
@@ -250,6 +573,7 @@ void trx_trx_receive_loop()
 			}
 		}
 		catch (const SndException& e) {
+			rx_pipeline_pause();
 			scard->Close();
 			LOG_ERROR("%s", e.what());
 			put_status(e.what(), 5);
@@ -260,42 +584,52 @@ void trx_trx_receive_loop()
 			break;
 
 		if (bHighSpeed) {
+			if (!rx_paused)
+				rx_pipeline_pause();
 			bool afc = progStatus.afconoff;
 			progStatus.afconoff = false;
 			QRUNNER_DROP(true);
-			if (progdefaults.rsid)
-				ReedSolomon->receive(fbuf, numread);
+			if (progdefaults.rsid) {
+				ReedSolomon->receive(fbuf, numread, rx_pos);
+				ReedSolomon->apply_pending(rx_pos);
+			}
 			active_modem->HistoryON(true);
+			batch_rx_chars();
 			active_modem->rx_process(hsbuff, numread);
+			flush_rx_chars();
 			QRUNNER_DROP(false);
 			progStatus.afconoff = afc;
 			active_modem->HistoryON(false);
 		} else {
+			if (rx_paused)
+				rx_pipeline_resume();
 			trxrb.write_advance(numread);
-			REQ(&waterfall::sig_data, wf, rbvec[0].buf, numread, current_samplerate);
+			rx_pipeline_write(numread);
+			wf->sig_data(rbvec[0].buf, numread, current_samplerate);
+			ReedSolomon->apply_pending(rx_pos);
 
-			if (!bHistory) {
-				active_modem->rx_process(rbvec[0].buf, numread);
-				if (progdefaults.rsid)
-					ReedSolomon->receive(fbuf, numread);
-				dtmf->receive(fbuf, numread);
-			} else {
+			if (bHistory) {
+				rx_pipeline_pause();
 				bool afc = progStatus.afconoff;
 				progStatus.afconoff = false;
 				QRUNNER_DROP(true);
 				active_modem->HistoryON(true);
 				trxrb.get_rv(rbvec);
+				batch_rx_chars();
 				if (rbvec[0].len)
 					active_modem->rx_process(rbvec[0].buf, rbvec[0].len);
 				if (rbvec[1].len)
 					active_modem->rx_process(rbvec[1].buf, rbvec[1].len);
+				flush_rx_chars();
 				QRUNNER_DROP(false);
 				progStatus.afconoff = afc;
 				bHistory = false;
 				active_modem->HistoryON(false);
+				rx_pipeline_resume();
 			}
 		}
 	}
+	rx_pipeline_pause();
 	if (scard->must_close(O_RDONLY))
 		scard->Close(O_RDONLY);
 }
@@ -439,6 +773,40 @@ void trx_tune_loop()
 	REQ(&waterfall::set_XmtRcvBtn, wf, false);
 }
 
+#else // DECODER_MODE
+
+// There is no sound card, waterfall, RSID or DTMF decoder: the trx thread
+// runs the active modem over the decoder's input, and never transmits
+void trx_xmit_wfall_queue(int samplerate, const double* buf, size_t len)
+{
+}
+
+modem* trx_rx_modem(void)
+{
+	return active_modem;
+}
+
+void trx_rx_flush(void)
+{
+	active_modem->rx_flush();
+}
+
+void trx_trx_receive_loop()
+{
+	if (unlikely(!active_modem)) {
+		MilliSleep(10);
+		return;
+	}
+
+	if (benchmark.enabled)
+		do_benchmark();
+	else
+		do_decode();
+	trx_state = STATE_ENDED;
+}
+
+#endif // DECODER_MODE
+
 //=============================================================================
 void *trx_loop(void *args)
 {
@@ -449,8 +817,10 @@ void *trx_loop(void *args)
 	for (;;) {
 		if (unlikely(old_state != trx_state)) {
 			old_state = trx_state;
+#if !DECODER_MODE
 			if (trx_state == STATE_TX || trx_state == STATE_TUNE)
 				trxrb.reset();
+#endif
 			trx_signal_state();
 		}
 
@@ -471,22 +841,26 @@ void *trx_loop(void *args)
 			trx_state = STATE_ENDED;
 			// fall through
 		case STATE_ENDED:
+#if !DECODER_MODE
 			Fl::lock();
 			Fl::awake();
 			Fl::unlock();
+#endif
 			return 0;
-		case STATE_RESTART:
-			trx_reset_loop();
-			break;
 		case STATE_NEW_MODEM:
 			trx_start_modem_loop();
 			break;
+#if !DECODER_MODE
+		case STATE_RESTART:
+			trx_reset_loop();
+			break;
 		case STATE_TX:
 			trx_trx_transmit_loop();
 			break;
 		case STATE_TUNE:
 			trx_tune_loop();
 			break;
+#endif
 		case STATE_RX:
 			trx_trx_receive_loop();
 			break;
@@ -535,6 +909,7 @@ void trx_start_modem(modem* m, int f)
 }
 
 //=============================================================================
+#if !DECODER_MODE
 void trx_reset_loop()
 {
 	if (scard)  {
@@ -567,6 +942,7 @@ void trx_reset_loop()
 
 	trx_state = STATE_RX;	
 }
+#endif
 
 //=============================================================================
 
@@ -579,7 +955,7 @@ void trx_reset(void)
 
 void trx_start(void)
 {
-#if !BENCHMARK_MODE
+#if !DECODER_MODE
 	if (trxrunning) {
 		LOG(debug::ERROR_LEVEL, debug::LOG_MODEM, "trx already running!");
 		return;
@@ -616,8 +992,30 @@ void trx_start(void)
 	ReedSolomon = new cRsId;
 	dtmf = new cDTMF;
 
-#endif // !BENCHMARK_MODE
+	rx_pipeline_start();
+#endif // !DECODER_MODE
+
+#if DECODER_MODE
+	// the decoder runs the trx thread once for every input
+	if (trxrunning)
+		pthread_join(trx_thread, NULL);
+	else
+#endif
+		trx_sem_init();
 
+	trx_state = STATE_RX;
+	_trx_tune = 0;
+	active_modem = 0;
+	if (pthread_create(&trx_thread, NULL, trx_loop, NULL) < 0) {
+		LOG(debug::ERROR_LEVEL, debug::LOG_MODEM, "pthread_create failed");
+		trxrunning = false;
+		exit(1);
+	} 
+	trxrunning = true;
+}
+
+static void trx_sem_init(void)
+{
 #if USE_NAMED_SEMAPHORES
 	char sname[32];
 	snprintf(sname, sizeof(sname), "trx-%u-%s", getpid(), PACKAGE_TARNAME);
@@ -638,16 +1036,6 @@ void trx_start(void)
 		abort();
 	}
 #endif
-
-	trx_state = STATE_RX;
-	_trx_tune = 0;
-	active_modem = 0;
-	if (pthread_create(&trx_thread, NULL, trx_loop, NULL) < 0) {
-		LOG(debug::ERROR_LEVEL, debug::LOG_MODEM, "pthread_create failed");
-		trxrunning = false;
-		exit(1);
-	} 
-	trxrunning = true;
 }
 
 //=============================================================================
@@ -656,6 +1044,9 @@ void trx_close()
 	trx_state = STATE_ABORT;
 	while (trx_state != STATE_ENDED)
 		MilliSleep(100);
+#if !DECODER_MODE
+	rx_pipeline_stop();
+#endif
 
 #if USE_NAMED_SEMAPHORES
 	if (sem_close(trx_sem) == -1)
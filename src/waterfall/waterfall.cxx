@@ -53,6 +53,7 @@
 #include "main.h"
 #include "modem.h"
 #include "qrunner.h"
+#include "threads.h"
 
 #if USE_HAMLIB
 	#include "hamlib.h"
@@ -87,6 +88,12 @@ using namespace std;
 #define bwXmtRcv	40
 #define wSpace		1
 
+// finished rows that may wait for the GUI thread
+#define WF_ROWS		16
+// zoom FFT length, and the band shown at x1 in Hz
+#define ZOOM_LEN	2048
+#define ZOOM_SPAN	1000
+
 #define bwdths	(wSpace + bwFFT + wSpace + cwRef + wSpace + cwRef + wSpace + bwX1 + \
 				wSpace + 3*bwMov + wSpace + bwRate + wSpace + \
 				cwCnt + wSpace + bwQsy + wSpace + bwMem + wSpace + \
@@ -111,8 +118,6 @@ static	RGB RGBred		= {254,0,0};
 RGBI	mag2RGBI[256];
 RGB		palette[9];
 
-short int *tmp_fft_db;
-
 WFdisp::WFdisp (int x0, int y0, int w0, int h0, char *lbl) :
 			  Fl_Widget(x0,y0,w0,h0,"") {
 	disp_width = w();
@@ -132,15 +137,46 @@ WFdisp::WFdisp (int x0, int y0, int w0, int h0, char *lbl) :
 	sig_img			= new uchar[sig_image_area];
 	pwr				= new wf_fft_type[IMAGE_WIDTH];
 	fft_db			= new short int[image_area];
-	tmp_fft_db		= new short int[image_area];
+	img_offset		= -1;
+	img_stale		= 0;
+	palette_gen		= 0;
+	img_palette		= 0;
 	circbuff		= new double[FFT_LEN];
 	wfbuf			= new wf_cpx_type[FFT_LEN];
 	wfft			= new g_fft<wf_fft_type>(FFT_LEN);
 	fftwindow		= new double[FFT_LEN];
-	setPrefilter(progdefaults.wfPreFilter);
+	makeWindow(progdefaults.wfPreFilter);
 
 	memset(circbuff, 0, FFT_LEN * sizeof(double));
 
+	rows			= new wf_row[WF_ROWS];
+	for (int i = 0; i < WF_ROWS; i++) {
+		rows[i].db	= new short int[IMAGE_WIDTH];
+		rows[i].img	= new RGBI[IMAGE_WIDTH];
+		rows[i].pwr	= new wf_fft_type[IMAGE_WIDTH];
+	}
+	rows_head = rows_tail = 0;
+	wf_input		= new ringbuffer<double>(ceil2(16 * WFBLOCKSIZE));
+	scopebuf		= new double[FFT_LEN];
+	scope_ready		= false;
+	pthread_mutex_init(&wf_mutex, NULL);
+	pthread_cond_init(&wf_cond, NULL);
+	wf_running = wf_quit = wf_pending = false;
+
+	zoom_centre = zp_centre = zoom_at = 0.0;
+	zp_on = false;
+	zp_mag = MAG_1;
+	zoom_dec = zoom_srate = 0;
+	zoom_filt		= 0;
+	zoom_buf		= new cmplx[ZOOM_LEN];
+	zoom_ptr		= 0;
+	zoom_fbuf		= new wf_cpx_type[ZOOM_LEN];
+	zoom_window		= new double[ZOOM_LEN];
+	zoom_fft		= new g_fft<wf_fft_type>(ZOOM_LEN);
+	BlackmanWindow(zoom_window, ZOOM_LEN);
+	for (int i = 0; i < ZOOM_LEN; i++)
+		zoom_buf[i] = cmplx(0.0, 0.0);
+
 	mag = 1;
 	step = 4;
 	offset = 0;
@@ -162,7 +198,7 @@ WFdisp::WFdisp (int x0, int y0, int w0, int h0, char *lbl) :
 	rfc = 0L;
 	usb = true;
 	wfspeed = NORMAL;
-	srate = 8000;
+	srate = in_srate = 8000;
 	wfspdcnt = 0;
 	dispcnt = 4;
 	wantcursor = false;
@@ -183,7 +219,32 @@ WFdisp::WFdisp (int x0, int y0, int w0, int h0, char *lbl) :
 }
 
 WFdisp::~WFdisp() {
+	if (wf_running) {
+		pthread_mutex_lock(&wf_mutex);
+		wf_quit = true;
+		pthread_cond_signal(&wf_cond);
+		pthread_mutex_unlock(&wf_mutex);
+		pthread_join(wf_thread, NULL);
+	}
+	pthread_cond_destroy(&wf_cond);
+	pthread_mutex_destroy(&wf_mutex);
+	for (int i = 0; i < WF_ROWS; i++) {
+		delete [] rows[i].db;
+		delete [] rows[i].img;
+		delete [] rows[i].pwr;
+	}
+	delete [] rows;
+	delete wf_input;
+	delete [] scopebuf;
+	delete [] circbuff;
+	delete [] wfbuf;
+	delete [] fftwindow;
 	delete wfft;
+	delete zoom_filt;
+	delete [] zoom_buf;
+	delete [] zoom_fbuf;
+	delete [] zoom_window;
+	delete zoom_fft;
 	delete [] fft_img;
 	delete [] scaleimage;
 	delete [] markerimage;
@@ -192,7 +253,6 @@ WFdisp::~WFdisp() {
 	delete [] pwr;
 	delete [] scline;
 	delete [] fft_db;
-	delete [] tmp_fft_db;
 }
 
 void WFdisp::initMarkers() {
@@ -389,11 +449,12 @@ void WFdisp::setcolors() {
 			mag2RGBI[i + 32*n].B = b;
 		}
 	}
+	palette_gen++;
 }
 
 
 void WFdisp::initmaps() {
-	for (int i = 0; i < image_area; i++) fft_db[i] = tmp_fft_db[i] = log2disp(-1000);
+	for (int i = 0; i < image_area; i++) fft_db[i] = log2disp(-1000);
 
 	memset (fft_img, 0, image_area * sizeof(RGBI) );
 	memset (scaleimage, 0, scale_width * WFSCALE);
@@ -407,6 +468,26 @@ void WFdisp::initmaps() {
 	setcolors();
 }
 
+void WFdisp::clear_history() {
+	for (int i = 0; i < image_area; i++) fft_db[i] = log2disp(-1000);
+	img_stale = image_height;
+	redraw();
+}
+
+// The history is cleared when entering or leaving ZOOM, as the rows of the
+// two views do not share a frequency axis.
+void WFdisp::Mode(WFmode M) {
+	bool rezoom = (M == ZOOM) != (mode == ZOOM);
+	if (rezoom && M == ZOOM) {
+		pthread_mutex_lock(&wf_mutex);
+		zoom_centre = active_modem ? active_modem->get_freq() : carrierfreq;
+		pthread_mutex_unlock(&wf_mutex);
+	}
+	mode = M;
+	if (rezoom)
+		clear_history();
+}
+
 int WFdisp::peakFreq(int f0, int delta)
 {
 	double threshold = 0.0;
@@ -477,7 +558,13 @@ double WFdisp::powerDensityMaximum(int bw_nb, const int (*bw)[2]) const
 	return max_idx ;
 }
 
+// The window is rebuilt by the waterfall thread when it sees the change
 void WFdisp::setPrefilter(int v)
+{
+	progdefaults.wfPreFilter = v;
+}
+
+void WFdisp::makeWindow(int v)
 {
 	switch (v) {
 	case WF_FFT_RECTANGULAR: RectWindow(fftwindow, FFT_LEN); break;
@@ -497,65 +584,79 @@ int WFdisp::log2disp(int v)
 	return (int)(255 - val);
 }
 
-void WFdisp::processFFT() {
+// Runs on the waterfall thread.  Returns true if a new row was written to
+// `row', which may be null if there is no room for one.
+bool WFdisp::processFFT(wf_row *row) {
 	if (prefilter != progdefaults.wfPreFilter)
-		setPrefilter(progdefaults.wfPreFilter);
+		makeWindow(progdefaults.wfPreFilter);
 
 	wf_fft_type scale = ( 1.0 * SC_SMPLRATE / srate ) * ( FFT_LEN / 8000.0);
 
-	if (--dispcnt == 0) {
-		static const int log2disp100 = log2disp(-100);
-		double vscale = 2.0 / FFT_LEN;
-
-		memset(wfbuf, 0, FFT_LEN * sizeof(*wfbuf));
-		void *pv = static_cast<void*>(wfbuf);
-		wf_fft_type *pbuf = static_cast<wf_fft_type*>(pv);
-
-		int latency = progdefaults.wf_latency;
-		if (latency < 1) latency = 1;
-		if (latency > 16) latency = 16;
-		int nsamples = FFT_LEN * latency / 16;
-		vscale *= sqrt(16.0 / latency);
-		for (int i = 0; i < nsamples; i++)
-			pbuf[i] = fftwindow[i * 16 / latency] * circbuff[i] * vscale;
-
-		wfft->RealFFT(wfbuf);
-
-		memset(pwr, 0, progdefaults.LowFreqCutoff * sizeof(wf_fft_type));
-		memset(&fft_db[ptrFFTbuff * IMAGE_WIDTH],
-				log2disp100,
-				progdefaults.LowFreqCutoff * sizeof(*fft_db));
-
-		int n = 0;
-		for (int i = progdefaults.LowFreqCutoff + 1; i < IMAGE_WIDTH; i++) {
-			n = round(scale * i);
-			pwr[i] = norm(wfbuf[n]);
-			int ffth = round(10.0 * log10(pwr[i] + 1e-10) );
-			fft_db[ptrFFTbuff * IMAGE_WIDTH + i] = log2disp(ffth);
-		}
-
-		ptrFFTbuff--;
-		if (ptrFFTbuff < 0) ptrFFTbuff += image_height;
+	if (--dispcnt != 0)
+		return false;
 
-		for (int i = 0; i < image_height; i++) {
-			int j = (i + 1 + ptrFFTbuff) % image_height;
-			memmove( (void *)(tmp_fft_db + i * IMAGE_WIDTH),
-					 (void *)(fft_db + j * IMAGE_WIDTH),
-					 IMAGE_WIDTH * sizeof(short int));
-		}
-		redraw();
+	if (srate == 8000)
+		dispcnt = wfspeed;
+	else if (srate == 11025)
+		dispcnt = wfspeed * 4 / 3;
+	//kl4yfd
+	else
+		dispcnt = wfspeed * 8 / 3;
+
+	// the GUI thread is behind, drop this row
+	if (!row)
+		return false;
+
+	static const int log2disp100 = log2disp(-100);
+	double vscale = 2.0 / FFT_LEN;
+
+	memset(wfbuf, 0, FFT_LEN * sizeof(*wfbuf));
+	void *pv = static_cast<void*>(wfbuf);
+	wf_fft_type *pbuf = static_cast<wf_fft_type*>(pv);
+
+	int latency = progdefaults.wf_latency;
+	if (latency < 1) latency = 1;
+	if (latency > 16) latency = 16;
+	int nsamples = FFT_LEN * latency / 16;
+	vscale *= sqrt(16.0 / latency);
+	for (int i = 0; i < nsamples; i++)
+		pbuf[i] = fftwindow[i * 16 / latency] * circbuff[i] * vscale;
+
+	wfft->RealFFT(wfbuf);
+
+	memset(row->pwr, 0, progdefaults.LowFreqCutoff * sizeof(wf_fft_type));
+	for (int i = 0; i < progdefaults.LowFreqCutoff; i++)
+		row->db[i] = log2disp100;
+
+	int n = 0;
+	for (int i = progdefaults.LowFreqCutoff; i < IMAGE_WIDTH; i++) {
+		n = round(scale * i);
+		row->pwr[i] = norm(wfbuf[n]);
+		int ffth = round(10.0 * log10(row->pwr[i] + 1e-10) );
+		row->db[i] = log2disp(ffth);
+	}
 
-		if (srate == 8000)
-			dispcnt = wfspeed;
-		else if (srate == 11025)
-			dispcnt = wfspeed * 4 / 3;
-		//kl4yfd
-		else
-			dispcnt = wfspeed * 8 / 3;
+	row->width = disp_width;
+	row->zoom = zp_on;
+	row->centre = zp_centre;
+	row->zmag = zp_mag;
+	if (zp_on) {
+		zoom_row(row);
+		row->offset = 0;
+		row->step = 1;
 	}
+	else {
+		row->offset = offset;
+		row->step = step;
+	}
+	row->averaging = progdefaults.WFaveraging;
+	row->palette = palette_gen;
+	colour_row(row->db, row->img, row->offset, row->step, row->width, row->averaging);
+
+	return true;
 }
 
-void WFdisp::process_analog (wf_fft_type *sig, int len) {
+void WFdisp::process_analog (double *sig, int len) {
 	int h1, h2, h3;
 	int sigy, sigpixel, ynext, graylevel;
 	h1 = h()/8 - 1;
@@ -592,10 +693,79 @@ void WFdisp::redrawCursor()
 //	cursormoved = true;
 }
 
+// Queues audio for the waterfall thread; may be called from any thread.
 void WFdisp::sig_data( double *sig, int len, int sr )
+{
+	guard_lock lock(&wf_mutex);
+
+	if (unlikely(!wf_running)) {
+		if (pthread_create(&wf_thread, NULL, wf_loop, this) != 0) {
+			LOG_PERROR("pthread_create");
+			return;
+		}
+		wf_running = true;
+	}
+
+	in_srate = sr;
+	// keep the newest samples if the waterfall thread has fallen behind
+	size_t space = wf_input->write_space();
+	if (space < (size_t)len)
+		wf_input->read_advance(MIN(len - space, wf_input->read_space()));
+	wf_input->write(sig, len);
+	pthread_cond_signal(&wf_cond);
+}
+
+void *WFdisp::wf_loop(void *arg)
+{
+	SET_THREAD_ID(WF_TID);
+
+	static_cast<WFdisp *>(arg)->wf_process();
+
+	return NULL;
+}
+
+void WFdisp::wf_process()
+{
+	double buf[WFBLOCKSIZE];
+
+	guard_lock lock(&wf_mutex);
+	for (;;) {
+		while (!wf_quit && wf_input->read_space() < WFBLOCKSIZE)
+			pthread_cond_wait(&wf_cond, &wf_mutex);
+		if (wf_quit)
+			break;
+
+		wf_input->read(buf, WFBLOCKSIZE);
+		int sr = in_srate;
+		zp_on = mode == ZOOM;
+		zp_centre = zoom_centre;
+		zp_mag = mag;
+		wf_row *row = rows_head - rows_tail < WF_ROWS ? &rows[rows_head % WF_ROWS] : 0;
+
+		pthread_mutex_unlock(&wf_mutex);
+		bool ready = wf_block(buf, WFBLOCKSIZE, sr, row);
+		pthread_mutex_lock(&wf_mutex);
+
+		if (ready)
+			rows_head++;
+		if (mode == SCOPE) {
+			memcpy(scopebuf, circbuff, FFT_LEN * sizeof(*scopebuf));
+			scope_ready = true;
+		}
+		// one request at a time, however far behind the GUI thread is
+		if (!wf_pending) {
+			wf_pending = true;
+			REQ(&WFdisp::take_rows, this);
+		}
+	}
+}
+
+// Runs on the waterfall thread.  Returns true if a new row was written to
+// `row'.
+bool WFdisp::wf_block(const double *sig, int len, int sr, wf_row *row)
 {
 	if (wfspeed == PAUSE)
-		goto update_freq;
+		return false;
 
 	// if sound card sampling rate changed reset the waterfall buffer
 	if (srate != sr) {
@@ -606,7 +776,7 @@ void WFdisp::sig_data( double *sig, int len, int sr )
 
 	memmove((void*)circbuff,
 			(void*)(circbuff + len), 
-			(size_t)((FFT_LEN - len)*sizeof(wf_fft_type)));
+			(size_t)((FFT_LEN - len)*sizeof(*circbuff)));
 	memcpy((void*)&circbuff[FFT_LEN-len], 
 			(void*)sig,
 			(size_t)(len)*sizeof(double));
@@ -621,14 +791,144 @@ void WFdisp::sig_data( double *sig, int len, int sr )
 		peakaudio = 0.1 * peak + 0.9 * peakaudio;
 	}
 
-	if (mode == SCOPE)
-		process_analog(circbuff, FFT_LEN);
+	if (zp_on)
+		zoom_input(sig, len);
 	else
-		processFFT();
+		zoom_at = -1.0;
+
+	return mode != SCOPE && processFFT(row);
+}
+
+double WFdisp::zoom_hzpp(int m)
+{
+	return m == MAG_4 ? 0.25 : m == MAG_2 ? 0.5 : 1.0;
+}
+
+// Runs on the waterfall thread.  Mixes zp_centre down to 0 Hz and keeps the
+// last ZOOM_LEN decimated samples in zoom_buf.
+void WFdisp::zoom_input(const double *sig, int len)
+{
+	double span = ZOOM_SPAN * zoom_hzpp(zp_mag);
+	int dec = MAX(1, (int)(srate / (1.25 * span)));
+
+	if (!zoom_filt || dec != zoom_dec || srate != zoom_srate || zp_centre != zoom_at) {
+		if (!zoom_filt || dec != zoom_dec || srate != zoom_srate) {
+			delete zoom_filt;
+			zoom_filt = new C_FIR_filter();
+			zoom_filt->init_lowpass(8 * dec + 1, dec, 0.6 * span / srate);
+			zoom_dec = dec;
+			zoom_srate = srate;
+		}
+		zoom_at = zp_centre;
+		for (int i = 0; i < ZOOM_LEN; i++)
+			zoom_buf[i] = cmplx(0.0, 0.0);
+	}
+
+	cmplx z[WFBLOCKSIZE];
+	zoom_nco.set_freq(-zp_centre, srate);
+	while (len > 0) {
+		int n = MIN(len, WFBLOCKSIZE);
+		zoom_nco.mix(z, sig, n);
+		int m = zoom_filt->run(z, z, n);
+		for (int i = 0; i < m; i++) {
+			zoom_buf[zoom_ptr] = z[i];
+			zoom_ptr = (zoom_ptr + 1) & (ZOOM_LEN - 1);
+		}
+		sig += n;
+		len -= n;
+	}
+}
+
+// Runs on the waterfall thread.  Replaces row->db with the zoom spectrum,
+// zp_centre at pixel row->width / 2 and zoom_hzpp(zp_mag) Hz a pixel.
+void WFdisp::zoom_row(wf_row *row)
+{
+	static const int log2disp1000 = log2disp(-1000);
+	double vscale = 2.0 / ZOOM_LEN;
+
+	// oldest sample first
+	for (int i = 0; i < ZOOM_LEN; i++) {
+		const cmplx& z = zoom_buf[(zoom_ptr + i) & (ZOOM_LEN - 1)];
+		double w = zoom_window[i] * vscale;
+		zoom_fbuf[i] = wf_cpx_type(w * z.real(), w * z.imag());
+	}
+	zoom_fft->ComplexFFT(zoom_fbuf);
+
+	double binw = (double)zoom_srate / zoom_dec / ZOOM_LEN;
+	double hzpp = zoom_hzpp(zp_mag);
+	double half = 0.5 * ZOOM_SPAN * hzpp;
+	for (int i = 0; i < IMAGE_WIDTH; i++) {
+		double f = (i - row->width / 2) * hzpp;
+		if (i >= row->width || f < -half || f >= half) {
+			row->db[i] = log2disp1000;
+			continue;
+		}
+		// the strongest of the bins that fall within this pixel
+		int k0 = (int)floor(f / binw + 0.5);
+		int k1 = MAX(k0 + 1, (int)floor((f + hzpp) / binw + 0.5));
+		wf_fft_type p = 0.0;
+		for (int k = k0; k < k1; k++)
+			p = MAX(p, norm(zoom_fbuf[k & (ZOOM_LEN - 1)]));
+		row->db[i] = log2disp((int)round(10.0 * log10(p + 1e-10)));
+	}
+}
+
+// Moves the finished rows into the history and updates the displays
+void WFdisp::take_rows()
+{
+	ENSURE_THREAD(FLMAIN_TID);
+
+	pthread_mutex_lock(&wf_mutex);
+	wf_pending = false;
+	size_t head = rows_head;
+	if (scope_ready) {
+		scope_ready = false;
+		process_analog(scopebuf, FFT_LEN);
+	}
+	pthread_mutex_unlock(&wf_mutex);
+
+	// rows_tail..head are not touched by the waterfall thread
+	bool zoom = mode == ZOOM;
+	for (size_t i = rows_tail; i != head; i++) {
+		wf_row& row = rows[i % WF_ROWS];
+		memcpy(pwr, row.pwr, IMAGE_WIDTH * sizeof(*pwr));
+		// made for another view of the band
+		if (row.zoom != zoom || (zoom && (row.centre != zoom_centre || row.zmag != mag)))
+			continue;
+		memcpy(&fft_db[ptrFFTbuff * IMAGE_WIDTH], row.db, IMAGE_WIDTH * sizeof(*fft_db));
+		if (img_stale == 0 && row.offset == view_offset() && row.step == view_step() &&
+		    row.width == disp_width && row.averaging == progdefaults.WFaveraging &&
+		    row.palette == palette_gen)
+			memcpy(&fft_img[ptrFFTbuff * disp_width], row.img, disp_width * sizeof(*fft_img));
+		else if (img_stale < image_height)
+			img_stale++;
+
+		ptrFFTbuff--;
+		if (ptrFFTbuff < 0) ptrFFTbuff += image_height;
+	}
+	if (head != rows_tail) {
+		pthread_mutex_lock(&wf_mutex);
+		rows_tail = head;
+		pthread_mutex_unlock(&wf_mutex);
+		redraw();
+	}
+
+	// recentre the zoom when the signal nears its edge
+	if (zoom && active_modem &&
+	    fabs(active_modem->get_freq() - zoom_centre) > ZOOM_SPAN * zoom_hzpp(mag) / 4) {
+		pthread_mutex_lock(&wf_mutex);
+		zoom_centre = active_modem->get_freq();
+		pthread_mutex_unlock(&wf_mutex);
+		clear_history();
+	}
 
-	put_WARNstatus(peakaudio);
+	if (wfspeed != PAUSE)
+		put_WARNstatus(peakaudio);
+	update_freq();
+}
 
-update_freq:
+void WFdisp::update_freq()
+{
 	static char szFrequency[14];
 	if (active_modem && rfc != 0) { // use a boolean for the waterfall
 		int cwoffset = 0;
@@ -721,6 +1021,8 @@ int WFdisp::checkMag()
 {
 	checkWidth();
 	makeScale();
+	if (mode == ZOOM)
+		clear_history();
 	return mag;
 }
 
@@ -809,8 +1111,32 @@ void WFdisp::drawScale() {
 	}
 }
 
+// Frequency ticks for the zoomed band, one label every 100 pixels
+void WFdisp::drawZoomScale() {
+	static char szFreq[20];
+	double hzpp = zoom_hzpp(mag);
+	double tick = 100 * hzpp;
+	double f0 = zoom_centre - (disp_width / 2) * hzpp;
+
+	fl_color(fl_rgb_color(228));
+	fl_font(progdefaults.WaterfallFontnbr, progdefaults.WaterfallFontsize);
+	for (double f = ceil(f0 / tick) * tick; ; f += tick) {
+		int xoff = freq2x(f);
+		if (xoff >= disp_width)
+			break;
+		if (progdefaults.wf_audioscale || !rfc)
+			snprintf(szFreq, sizeof(szFreq), "%.0f", f);
+		else
+			snprintf(szFreq, sizeof(szFreq), "%.3f", (usb ? rfc + f : rfc - f) / 1000.0);
+		int fw = (int)fl_width(szFreq);
+		fl_yxline(x() + xoff, y() + WFTEXT, y() + WFTEXT + WFSCALE - 1);
+		if (xoff - fw / 2 > 0 && xoff + fw / 2 < w())
+			fl_draw(szFreq, x() + xoff - fw / 2, y() + 10);
+	}
+}
+
 void WFdisp::drawMarker() {
-	if (mode == SCOPE) return;
+	if (mode == SCOPE || mode == ZOOM) return;
 	uchar *pixmap = (uchar *)(markerimage + (int)(offset));
 	fl_draw_image(
 		pixmap,
@@ -819,29 +1145,27 @@ void WFdisp::drawMarker() {
 		step * RGBsize, RGBwidth);
 }
 
-void WFdisp::update_waterfall() {
-// transfer the fft history data into the WF image
-	short int * __restrict__ p1, * __restrict__ p2;
-	RGBI * __restrict__ p3, * __restrict__ p4;
-	p1 = tmp_fft_db + offset + step/2;
-	p2 = p1;
-	p3 = fft_img;
-	p4 = p3;
+// Colour one row of the fft history into the same row of the WF image
+void WFdisp::update_row(int row) {
+	colour_row(fft_db + row * IMAGE_WIDTH, fft_img + row * disp_width,
+		   view_offset(), view_step(), disp_width, progdefaults.WFaveraging);
+}
+
+// Colour IMAGE_WIDTH fft values into `width' pixels, `step' values a pixel
+void WFdisp::colour_row(const short int *db, RGBI *img, int offset, int step,
+			int width, bool averaging) {
+	const short int * __restrict__ p2 = db + offset + step/2;
+	RGBI * __restrict__ p4 = img;
 
-	short*  __restrict__ limit = tmp_fft_db + image_area - step + 1;
+	const short*  __restrict__ limit = db + IMAGE_WIDTH - step + 1;
+	const short*  __restrict__ last_p2 = std::min( p2 + step * width, limit + 1 );
 
 #define UPD_LOOP( Step, Operation ) \
-case Step: for (int row = 0; row < image_height; row++) { \
-		p2 = p1; \
-		p4 = p3; \
-		for ( const short *  __restrict__ last_p2 = std::min( p2 + Step * disp_width, limit +1 ); p2 < last_p2; p2 += Step ) { \
-			*(p4++) = mag2RGBI[ Operation ]; \
-		} \
-		p1 += IMAGE_WIDTH; \
-		p3 += disp_width; \
+case Step: for ( ; p2 < last_p2; p2 += Step ) { \
+		*(p4++) = mag2RGBI[ Operation ]; \
 	}; break
 
-	if (progdefaults.WFaveraging) {
+	if (averaging) {
 		switch(step) {
 			UPD_LOOP( 4, (*p2 + *(p2+1) + *(p2+2) + *(p2-1) + *(p2-1))/5 );
 			UPD_LOOP( 2, (*p2 + *(p2+1) + *(p2-1))/3 );
@@ -857,6 +1181,49 @@ case Step: for (int row = 0; row < image_height; row++) { \
 		}
 	}
 #undef UPD_LOOP
+}
+
+// Only the rows added since the last draw are coloured, unless the view or
+// the palette has changed.
+void WFdisp::update_waterfall() {
+	if (view_offset() != img_offset || view_step() != img_step || disp_width != img_width ||
+	    progdefaults.WFaveraging != img_averaging || palette_gen != img_palette) {
+		img_palette = palette_gen;
+		img_offset = view_offset();
+		img_step = view_step();
+		img_width = disp_width;
+		img_averaging = progdefaults.WFaveraging;
+		img_stale = image_height;
+	}
+
+	for (int row = ring_top(); img_stale > 0; img_stale--) {
+		update_row(row);
+		if (++row == image_height)
+			row = 0;
+	}
+}
+
+// The tracks, cursor and notch are drawn over the blitted image so that the
+// image itself only ever holds the spectrum history.
+// Pixel column of audio frequency f
+int WFdisp::freq2x(double f) {
+	if (mode == ZOOM)
+		return disp_width / 2 + (int)floor((f - zoom_centre) / zoom_hzpp(mag));
+	return ((int)f - offset) / step;
+}
+
+int WFdisp::cursorFreq(int xpos) {
+	if (mode == ZOOM)
+		return (int)floor(zoom_centre + (xpos - disp_width / 2) * zoom_hzpp(mag) + 0.5);
+	return (offset + step * xpos);
+}
+
+void WFdisp::drawoverlays() {
+	int top = y() + WFSCALE + WFMARKER + WFTEXT;
+	int bottom = top + image_height - 1;
+	double hzpp = mode == ZOOM ? zoom_hzpp(mag) : step;
+
+	fl_push_clip(x(), top, disp_width, image_height);
 
 	if (active_modem && progdefaults.UseBWTracks) {
 		int bw_lo = bandwidth / 2;
@@ -864,11 +1231,11 @@ case Step: for (int row = 0; row < image_height; row++) { \
 		trx_mode mode = active_modem->get_mode();
 		if (mode >= MODE_MT63_500S && mode <= MODE_MT63_2000L)
 			bw_hi = bw_hi * 31 / 32;
-		RGBI  *pos1 = fft_img + (carrierfreq - offset - bw_lo) / step;
-		RGBI  *pos2 = fft_img + (carrierfreq - offset + bw_hi) / step;
-		if (unlikely(pos2 == fft_img + disp_width))
+		int pos1 = freq2x(carrierfreq - bw_lo);
+		int pos2 = freq2x(carrierfreq + bw_hi);
+		if (unlikely(pos2 == disp_width))
 			pos2--;
-		if (likely(pos1 >= fft_img && pos2 < fft_img + disp_width)) {
+		if (likely(pos1 >= 0 && pos2 < disp_width)) {
 			RGBI rgbi1, rgbi2 ;
 
 			if (mode == MODE_RTTY && progdefaults.useMARKfreq) {
@@ -883,21 +1250,11 @@ case Step: for (int row = 0; row < image_height; row++) { \
 				rgbi1 = progdefaults.bwTrackRGBI;
 				rgbi2 = progdefaults.bwTrackRGBI;
 			}
-			if (progdefaults.UseWideTracks) {
-				for (int y = 0; y < image_height; y ++) {
-					*(pos1 + 1) = *pos1 = rgbi1;
-					*(pos2 - 1) = *pos2 = rgbi2;
-					pos1 += disp_width;
-					pos2 += disp_width;
-				}
-			} else {
-				for (int y = 0; y < image_height; y ++) {
-					*pos1 = rgbi1;
-					*pos2 = rgbi2;
-					pos1 += disp_width;
-					pos2 += disp_width;
-				}
-			}
+			int wide = progdefaults.UseWideTracks ? 2 : 1;
+			fl_color(rgbi1.R, rgbi1.G, rgbi1.B);
+			fl_rectf(x() + pos1, top, wide, image_height);
+			fl_color(rgbi2.R, rgbi2.G, rgbi2.B);
+			fl_rectf(x() + pos2 - wide + 1, top, wide, image_height);
 		}
 	}
 
@@ -907,15 +1264,43 @@ case Step: for (int row = 0; row < image_height; row++) { \
 		RGBInotch.R = progdefaults.notchRGBI.R;
 		RGBInotch.G = progdefaults.notchRGBI.G;
 		RGBInotch.B = progdefaults.notchRGBI.B;
-		RGBI  *notch = fft_img + (notch_frequency - offset) / step;
-		int dash = 0;
-		for (int y = 0; y < image_height; y++) {
-			dash = (dash + 1) % 6;
-			if (dash == 0 || dash == 1 || dash == 2)
-				*(notch-1) = *notch = *(notch+1) = RGBInotch;
-			notch += disp_width;
+		int notch = x() + freq2x(notch_frequency);
+		fl_color(RGBInotch.R, RGBInotch.G, RGBInotch.B);
+		// dashes of 3 rows every 6, the first one cut short
+		for (int y = -1; y < image_height; y += 6)
+			fl_rectf(notch - 1, top + MAX(y, 0), 3, y < 0 ? 2 : 3);
+	}
+
+	if (active_modem && wantcursor && 
+		(progdefaults.UseCursorLines || progdefaults.UseCursorCenterLine) ) {
+		trx_mode mode = active_modem->get_mode();
+		int bw_lo = bandwidth / 2;
+		int bw_hi = bandwidth / 2;
+		if (mode >= MODE_MT63_500S && mode <= MODE_MT63_2000L)
+			bw_hi = bw_hi * 31 / 32;
+		int pos0 = cursorpos;
+		int pos1 = cursorpos - (int)(bw_lo / hzpp);
+		int pos2 = cursorpos + (int)(bw_hi / hzpp);
+		if (pos1 >= 0 && pos2 < disp_width) {
+			if (progdefaults.UseCursorLines) {
+				const RGBI& c = progdefaults.cursorLineRGBI;
+				int wide = progdefaults.UseWideCursor ? 2 : 1;
+				fl_color(c.R, c.G, c.B);
+				fl_rectf(x() + pos1, top, wide, image_height);
+				fl_rectf(x() + pos2 - wide + 1, top, wide, image_height);
+			}
+			if (progdefaults.UseCursorCenterLine) {
+				const RGBI& c = progdefaults.cursorCenterRGBI;
+				fl_color(c.R, c.G, c.B);
+				if (progdefaults.UseWideCenter)
+					fl_rectf(x() + pos0 - 1, top, 3, image_height);
+				else
+					fl_yxline(x() + pos0, top, bottom);
+			}
 		}
 	}
+
+	fl_pop_clip();
 }
 
 void WFdisp::drawcolorWF() {
@@ -927,46 +1312,30 @@ void WFdisp::drawcolorWF() {
 	png_byte tmp_image[image_height][w() * 3];
 
 	uchar *pixmap = (uchar *)fft_img;
+	int top = y() + WFSCALE + WFMARKER + WFTEXT;
+	int row = ring_top();
 
 	update_waterfall();
 
-	if (active_modem && wantcursor && 
-		(progdefaults.UseCursorLines || progdefaults.UseCursorCenterLine) ) {
-		trx_mode mode = active_modem->get_mode();
-		int bw_lo = bandwidth / 2;
-		int bw_hi = bandwidth / 2;
-		if (mode >= MODE_MT63_500S && mode <= MODE_MT63_2000L)
-			bw_hi = bw_hi * 31 / 32;
-		RGBI  *pos0 = (fft_img + cursorpos);
-		RGBI  *pos1 = (fft_img + cursorpos - bw_lo/step);
-		RGBI  *pos2 = (fft_img + cursorpos + bw_hi/step);
-		if (pos1 >= fft_img && pos2 < fft_img + disp_width)
-			for (int y = 0; y < image_height; y ++) {
-				if (progdefaults.UseCursorLines) {
-					*pos1 = *pos2 = progdefaults.cursorLineRGBI;
-					if (progdefaults.UseWideCursor)
-						*(pos1 + 1) = *(pos2 - 1) = *pos1;
-				}
-				if (progdefaults.UseCursorCenterLine) {
-					*pos0 = progdefaults.cursorCenterRGBI;
-					if (progdefaults.UseWideCenter)
-						*(pos0 - 1) = *(pos0 + 1) = *pos0;
-				}
-				pos0 += disp_width;
-				pos1 += disp_width;
-				pos2 += disp_width;
-			}
-	}
-
 	fl_color(FL_BLACK);
 	fl_rectf(x(), y(), w(), WFSCALE + WFMARKER + WFTEXT);
 	fl_color(fl_rgb_color(palette[0].R, palette[0].G, palette[0].B));
-	fl_rectf(x(), y() + WFSCALE + WFMARKER + WFTEXT, w(), image_height);
+	fl_rectf(x(), top, w(), image_height);
+// newest rows from the ring top to the end, then the older ones from the start
 	fl_draw_image(
-		pixmap, x(), y() + WFSCALE + WFMARKER + WFTEXT,
-		disp_width, image_height,
+		pixmap + row * disp_width * sizeof(RGBI), x(), top,
+		disp_width, image_height - row,
 		sizeof(RGBI), disp_width * sizeof(RGBI) );
-	drawScale();
+	if (row > 0)
+		fl_draw_image(
+			pixmap, x(), top + image_height - row,
+			disp_width, row,
+			sizeof(RGBI), disp_width * sizeof(RGBI) );
+	drawoverlays();
+	if (mode == ZOOM)
+		drawZoomScale();
+	else
+		drawScale();
 
 	if (waterwheel == 0)
 	{
@@ -1017,9 +1386,10 @@ void WFdisp::drawcolorWF() {
 			png_set_IHDR(png_ptr, info_ptr, disp_width, image_height, 8, PNG_COLOR_TYPE_RGB,
 					 PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
 
-			for (int y = 0; y < image_height; y++) for (int x = 0; x < disp_width; x++)
-			{
-				memcpy(&(tmp_image[y][x * 3]), pixmap + ((x + (y * disp_width)) * sizeof(RGBI)), 3);
+			for (int y = 0; y < image_height; y++) {
+				RGBI *src = fft_img + ((row + y) % image_height) * disp_width;
+				for (int x = 0; x < disp_width; x++)
+					memcpy(&(tmp_image[y][x * 3]), src + x, 3);
 			}
 
 			for (int k = 0; k < image_height; k++)
@@ -1056,15 +1426,17 @@ void WFdisp::drawspectrum() {
 
 	memset (fft_sig_img, 0, image_area);
 
+	const short int *db = fft_db + ring_top() * IMAGE_WIDTH;
+
 	fftpixel /= step;
 	for (int c = 0; c < IMAGE_WIDTH; c += step) {
-		sig = tmp_fft_db[c];
+		sig = db[c];
 		if (step == 1)
-			sig = tmp_fft_db[c];
+			sig = db[c];
 		else if (step == 2)
-			sig = MAX(tmp_fft_db[c], tmp_fft_db[c+1]);
+			sig = MAX(db[c], db[c+1]);
 		else
-			sig = MAX( MAX ( MAX ( tmp_fft_db[c], tmp_fft_db[c+1] ), tmp_fft_db[c+2] ), tmp_fft_db[c+3]);
+			sig = MAX( MAX ( MAX ( db[c], db[c+1] ), db[c+2] ), db[c+3]);
 		ynext = h1 * sig / 256;
 		while (ffty < ynext) { fft_sig_img[fftpixel -= IMAGE_WIDTH/step] = graylevel; ffty++;}
 		while (ffty > ynext) { fft_sig_img[fftpixel += IMAGE_WIDTH/step] = graylevel; ffty--;}
@@ -1155,6 +1527,9 @@ void WFdisp::draw() {
 	case SCOPE :
 		drawsignal();
 		break;
+	case ZOOM :
+		drawcolorWF();
+		break;
 	case WATERFALL :
 	default:
 		drawcolorWF();
@@ -1338,7 +1713,7 @@ void waterfall::set_XmtRcvBtn(bool val)
 
 void mode_cb(Fl_Widget* w, void*)
 {
-	static const char* names[NUM_WF_MODES] = { "WF", "FFT", "SIG" };
+	static const char* names[NUM_WF_MODES] = { "WF", "FFT", "SIG", "ZM" };
 	int m = wf->wfdisp->Mode() + (Fl::event_button() == FL_LEFT_MOUSE ? 1 : -1);
 	m = WCLAMP(m, WATERFALL, NUM_WF_MODES-1);
 